@@ -0,0 +1,401 @@
+/**
+ * Name: Thread Pool Benchmarker
+ * Description: Measures the overhead of the thread pools themselves, rather than the algorithms that run on them.
+ * Every pool implementation is put through the same set of benchmarks:
+ *  - Latency from submitting an empty task to its future being ready, one task at a time
+ *  - Sustained throughput of empty tasks with 1 to N threads submitting at once
+ *  - Overhead of parallelize_loop() as the grain size (indices per block) shrinks
+ *  - Cost of fanning out tasks into a multi_future and waiting on all of them
+ *  - The same fan-out from a coroutine on the pool, which suspends on when_all() instead of blocking a worker
+ *  - Latency for an idle pool to start running a newly submitted task
+ *  - For pools with an idle policy, how often the workers spun, yielded, parked and were woken up
+ *  - For elastic pools, how often they grew and shrank
+ * Results are printed and written to pool-benchmark.csv, with one row per pool, benchmark, parameter and metric.
+ *
+ * @cite Barak Shoshany, BS::thread_pool (2023), GitHub repository, https://github.com/bshoshany/thread-pool.git
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "BS_coroutine.hpp"
+#include "BS_thread_pool.hpp"
+#include "BS_work_stealing_pool.hpp"
+
+using namespace std::chrono;
+
+const std::string resultsPath = "pool-benchmark.csv";
+const int latencySamples = 20000;
+const int producerTasks = 200000; // Split evenly between the producers
+const int loopSize = 1 << 22;
+const int grainSizes[]{64, 256, 1024, 4096, 16384, 65536, 262144, loopSize};
+const int fanOutSizes[]{10, 100, 1000, 10000};
+const int wakeUpSamples = 200;
+const milliseconds idleTime{2};
+const int repeats = 5;
+const BS::idle_policy spinThenPark{2000, 50}; // Spin iterations, then yields, before a worker parks
+
+/**
+ * Get the value at a percentile of some samples
+ * @param samples Samples to look through, must be sorted
+ * @param percentile Percentile to get, from 0 to 100
+ * @return The sample at that percentile
+ */
+long long percentileOf(const std::vector<long long>& samples, double percentile) {
+    size_t idx = (size_t) (percentile / 100.0 * (double) (samples.size() - 1) + 0.5);
+    return samples[std::min(idx, samples.size() - 1)];
+}
+
+/**
+ * Get the median of some durations, to shrug off the odd run that got descheduled
+ * @param durations Durations to get the median of
+ * @return Median duration
+ */
+long long medianOf(std::vector<long long> durations) {
+    std::sort(durations.begin(), durations.end());
+    return durations[durations.size() / 2];
+}
+
+/**
+ * Collects rows of results for one pool and prints them as they come in.
+ */
+class ResultWriter {
+public:
+    /**
+     * Constructor for ResultWriter
+     * @param poolName name of the pool that the results are for
+     * @param rows vector to append CSV rows to
+     */
+    ResultWriter(std::string poolName, std::vector<std::string>& rows) : rows(rows) {
+        this->poolName = std::move(poolName);
+    }
+
+    /**
+     * Record a single result
+     * @param benchmark name of the benchmark
+     * @param parameter what the benchmark was run with (ex. number of producers)
+     * @param metric name of what was measured, including its unit
+     * @param value measured value
+     */
+    void add(const std::string& benchmark, const std::string& parameter, const std::string& metric, double value) {
+        std::stringstream ss("");
+        ss << poolName << "," << benchmark << "," << parameter << "," << metric << "," << value << "\n";
+        rows.push_back(ss.str());
+
+        std::cout << "  " << benchmark << " [" << parameter << "] " << metric << ": " << value << "\n";
+    }
+
+    /**
+     * Record the usual percentiles of some samples
+     * @param benchmark name of the benchmark
+     * @param parameter what the benchmark was run with
+     * @param samples samples in nanoseconds, will be sorted
+     */
+    void addPercentiles(const std::string& benchmark, const std::string& parameter, std::vector<long long>& samples) {
+        std::sort(samples.begin(), samples.end());
+        add(benchmark, parameter, "p50 (ns)", (double) percentileOf(samples, 50));
+        add(benchmark, parameter, "p90 (ns)", (double) percentileOf(samples, 90));
+        add(benchmark, parameter, "p99 (ns)", (double) percentileOf(samples, 99));
+        add(benchmark, parameter, "p99.9 (ns)", (double) percentileOf(samples, 99.9));
+        add(benchmark, parameter, "max (ns)", (double) samples.back());
+    }
+
+private:
+    std::string poolName;
+    std::vector<std::string>& rows;
+};
+
+/**
+ * Time submitting an empty task and waiting for its future, one task at a time.
+ * @tparam Pool Type of thread pool
+ * @param pool Pool to benchmark
+ * @param writer Where to record the results
+ */
+template<class Pool>
+void benchmarkSubmitLatency(Pool& pool, ResultWriter& writer) {
+    std::vector<long long> samples;
+    samples.reserve(latencySamples);
+
+    for (int i = 0; i < latencySamples; i++) {
+        auto start = high_resolution_clock::now();
+        pool.submit([] {}).wait();
+        auto stop = high_resolution_clock::now();
+        samples.push_back(duration_cast<nanoseconds>(stop - start).count());
+    }
+
+    writer.addPercentiles("Submit to Complete", "empty task", samples);
+}
+
+/**
+ * Time a number of threads pushing empty tasks at the same time until all of them have run.
+ * @tparam Pool Type of thread pool
+ * @param pool Pool to benchmark
+ * @param writer Where to record the results
+ */
+template<class Pool>
+void benchmarkThroughput(Pool& pool, ResultWriter& writer) {
+    unsigned int maxProducers = std::max(2u, std::thread::hardware_concurrency());
+
+    for (unsigned int producers = 1; producers <= maxProducers; producers *= 2) {
+        int tasksPerProducer = producerTasks / (int) producers;
+        std::vector<long long> durations;
+
+        for (int r = 0; r < repeats; r++) {
+            // Hold every producer at the starting line so they really do submit at the same time
+            std::atomic<bool> go = false;
+            std::vector<std::thread> producerThreads;
+            for (unsigned int p = 0; p < producers; p++) {
+                producerThreads.emplace_back([&] {
+                    while (!go) std::this_thread::yield();
+                    for (int i = 0; i < tasksPerProducer; i++) {
+                        pool.push_task([] {});
+                    }
+                });
+            }
+
+            auto start = high_resolution_clock::now();
+            go = true;
+            for (auto& thread : producerThreads) {
+                thread.join();
+            }
+            pool.wait_for_tasks();
+            auto stop = high_resolution_clock::now();
+            durations.push_back(duration_cast<nanoseconds>(stop - start).count());
+        }
+
+        double seconds = (double) medianOf(durations) / 1e9;
+        writer.add("Throughput", std::to_string(producers) + " producers", "tasks/s",
+                   (double) (tasksPerProducer * producers) / seconds);
+    }
+}
+
+/**
+ * Time parallelize_loop() over the same loop with smaller and smaller blocks, compared to just running it serially.
+ * @tparam Pool Type of thread pool
+ * @param pool Pool to benchmark
+ * @param writer Where to record the results
+ */
+template<class Pool>
+void benchmarkLoopGrainSize(Pool& pool, ResultWriter& writer) {
+    std::vector<double> values(loopSize, 1.0);
+    auto loop = [&values](int start, int end) {
+        for (int i = start; i < end; i++) {
+            values[i] = values[i] * 1.0001 + 1.0;
+        }
+    };
+
+    // Baseline without the pool
+    std::vector<long long> serialDurations;
+    for (int r = 0; r < repeats; r++) {
+        auto start = high_resolution_clock::now();
+        loop(0, loopSize);
+        auto stop = high_resolution_clock::now();
+        serialDurations.push_back(duration_cast<nanoseconds>(stop - start).count());
+    }
+    long long serialDuration = medianOf(serialDurations);
+    writer.add("Loop", "serial", "duration (ns)", (double) serialDuration);
+
+    for (int grainSize : grainSizes) {
+        size_t numBlocks = loopSize / grainSize;
+        std::vector<long long> durations;
+        for (int r = 0; r < repeats; r++) {
+            auto start = high_resolution_clock::now();
+            pool.parallelize_loop(0, loopSize, loop, numBlocks).wait();
+            auto stop = high_resolution_clock::now();
+            durations.push_back(duration_cast<nanoseconds>(stop - start).count());
+        }
+        long long duration = medianOf(durations);
+
+        // Anything above a perfect split of the serial time across the threads is overhead
+        double idealDuration = (double) serialDuration / (double) std::min<size_t>(numBlocks, pool.get_thread_count());
+        std::string parameter = "grain " + std::to_string(grainSize);
+        writer.add("Loop", parameter, "duration (ns)", (double) duration);
+        writer.add("Loop", parameter, "overhead per block (ns)",
+                   std::max(0.0, (double) duration - idealDuration) / (double) numBlocks);
+    }
+}
+
+/**
+ * Time fanning out empty tasks into a multi_future and waiting on it, plus the cost of waiting alone once every task
+ * has already finished.
+ * @tparam Pool Type of thread pool
+ * @param pool Pool to benchmark
+ * @param writer Where to record the results
+ */
+template<class Pool>
+void benchmarkMultiFuture(Pool& pool, ResultWriter& writer) {
+    for (int fanOut : fanOutSizes) {
+        std::vector<long long> fanOutDurations, waitDurations;
+
+        for (int r = 0; r < repeats; r++) {
+            auto start = high_resolution_clock::now();
+            BS::multi_future<void> futures;
+            for (int i = 0; i < fanOut; i++) {
+                futures.push_back(pool.submit([] {}));
+            }
+            futures.wait();
+            auto stop = high_resolution_clock::now();
+            fanOutDurations.push_back(duration_cast<nanoseconds>(stop - start).count());
+
+            // Same again, but only time the wait
+            BS::multi_future<void> finishedFutures;
+            for (int i = 0; i < fanOut; i++) {
+                finishedFutures.push_back(pool.submit([] {}));
+            }
+            pool.wait_for_tasks();
+            start = high_resolution_clock::now();
+            finishedFutures.wait();
+            stop = high_resolution_clock::now();
+            waitDurations.push_back(duration_cast<nanoseconds>(stop - start).count());
+        }
+
+        std::string parameter = std::to_string(fanOut) + " tasks";
+        writer.add("Fan-out/Fan-in", parameter, "duration (ns)", (double) medianOf(fanOutDurations));
+        writer.add("Fan-out/Fan-in", parameter, "wait on finished (ns)", (double) medianOf(waitDurations));
+    }
+}
+
+/**
+ * A coroutine that does nothing, the coroutine version of an empty task.
+ * @return Task to await
+ */
+BS::task<void> emptyCoroutine() {
+    co_return;
+}
+
+/**
+ * Move onto the pool, then fan out empty coroutines with when_all() and suspend until they have all finished.
+ * @tparam Pool Type of thread pool
+ * @param pool Pool to run on
+ * @param fanOut Number of coroutines to fan out
+ * @return Task to await
+ */
+template<class Pool>
+BS::task<void> fanOutCoroutines(Pool& pool, int fanOut) {
+    co_await BS::schedule_on(pool);
+
+    std::vector<BS::task<void>> children;
+    children.reserve(fanOut);
+    for (int i = 0; i < fanOut; i++) {
+        children.push_back(emptyCoroutine());
+    }
+    co_await BS::when_all(pool, std::move(children));
+}
+
+/**
+ * Time a coroutine on the pool fanning out empty coroutines and waiting on all of them, comparable to
+ * benchmarkMultiFuture() but without any thread blocking inside the pool.
+ * @tparam Pool Type of thread pool
+ * @param pool Pool to benchmark
+ * @param writer Where to record the results
+ */
+template<class Pool>
+void benchmarkCoroutineFanOut(Pool& pool, ResultWriter& writer) {
+    for (int fanOut : fanOutSizes) {
+        std::vector<long long> durations;
+        for (int r = 0; r < repeats; r++) {
+            auto start = high_resolution_clock::now();
+            BS::sync_wait(fanOutCoroutines(pool, fanOut));
+            auto stop = high_resolution_clock::now();
+            durations.push_back(duration_cast<nanoseconds>(stop - start).count());
+        }
+
+        writer.add("Coroutine Fan-out/Fan-in", std::to_string(fanOut) + " tasks", "duration (ns)",
+                   (double) medianOf(durations));
+    }
+}
+
+/**
+ * Time how long a task takes to start running when it is submitted to a pool that has been idle for a while.
+ * @tparam Pool Type of thread pool
+ * @param pool Pool to benchmark
+ * @param writer Where to record the results
+ */
+template<class Pool>
+void benchmarkWakeUpLatency(Pool& pool, ResultWriter& writer) {
+    std::vector<long long> samples;
+    samples.reserve(wakeUpSamples);
+
+    for (int i = 0; i < wakeUpSamples; i++) {
+        // Give the workers time to go to sleep
+        std::this_thread::sleep_for(idleTime);
+
+        auto submitted = high_resolution_clock::now();
+        auto started = pool.submit([] { return high_resolution_clock::now(); }).get();
+        samples.push_back(duration_cast<nanoseconds>(started - submitted).count());
+    }
+
+    writer.addPercentiles("Wake-up", "after " + std::to_string(idleTime.count()) + "ms idle", samples);
+}
+
+/**
+ * Run every benchmark on a fresh pool.
+ * @tparam Pool Type of thread pool, must have the same interface as BS::thread_pool
+ * @tparam Args Types of the extra arguments for the pool's constructor
+ * @param poolName Name of the pool to put in the results
+ * @param rows Vector to append CSV rows to
+ * @param args Extra arguments for the pool's constructor
+ */
+template<class Pool, class... Args>
+void runPoolBenchmarks(const std::string& poolName, std::vector<std::string>& rows, const Args&... args) {
+    Pool pool(args...);
+    ResultWriter writer(poolName, rows);
+    std::cout << poolName << " (" << pool.get_thread_count() << " threads)\n";
+
+    benchmarkSubmitLatency(pool, writer);
+    benchmarkThroughput(pool, writer);
+    benchmarkLoopGrainSize(pool, writer);
+    benchmarkMultiFuture(pool, writer);
+    benchmarkCoroutineFanOut(pool, writer);
+    benchmarkWakeUpLatency(pool, writer);
+
+    // Pools with an idle policy also report how their workers spent their idle time
+    if constexpr (requires { pool.get_idle_stats(); }) {
+        BS::idle_stats stats = pool.get_idle_stats();
+        writer.add("Idle", "all benchmarks", "spins", (double) stats.spins);
+        writer.add("Idle", "all benchmarks", "yields", (double) stats.yields);
+        writer.add("Idle", "all benchmarks", "parks", (double) stats.parks);
+        writer.add("Idle", "all benchmarks", "wakes", (double) stats.wakes);
+    }
+
+    // Elastic pools also report how they resized themselves
+    if constexpr (requires { pool.get_elastic_stats(); }) {
+        if (pool.is_elastic()) {
+            BS::elastic_stats stats = pool.get_elastic_stats();
+            writer.add("Elastic", "all benchmarks", "grows for queue depth", (double) stats.grows_for_depth);
+            writer.add("Elastic", "all benchmarks", "grows for wait time", (double) stats.grows_for_wait);
+            writer.add("Elastic", "all benchmarks", "shrinks", (double) stats.shrinks);
+            writer.add("Elastic", "all benchmarks", "peak threads", (double) stats.peak_threads);
+        }
+    }
+}
+
+int main() {
+    std::vector<std::string> rows;
+
+    // Every pool implementation goes here
+    runPoolBenchmarks<BS::thread_pool>("BS::thread_pool", rows);
+    runPoolBenchmarks<BS::thread_pool>("BS::thread_pool (spin then park)", rows, 0, spinThenPark);
+    runPoolBenchmarks<BS::thread_pool>("BS::thread_pool (elastic)", rows, BS::elastic_policy{});
+    runPoolBenchmarks<BS::lock_free_thread_pool>("BS::lock_free_thread_pool", rows);
+    runPoolBenchmarks<BS::work_stealing_pool>("BS::work_stealing_pool", rows);
+
+    std::fstream file;
+    file.open(resultsPath, std::ios::out | std::ios::trunc);
+    file << "Pool,Benchmark,Parameter,Metric,Value\n";
+    for (const auto& row : rows) {
+        file << row;
+    }
+    file.close();
+
+    std::cout << "Wrote results to " << resultsPath << "\n";
+
+    return 0;
+}
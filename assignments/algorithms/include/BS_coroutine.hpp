@@ -0,0 +1,535 @@
+#pragma once
+
+/**
+ * @file BS_coroutine.hpp
+ *
+ * @brief BS::task: C++20 coroutines that run on any of the thread pools. A coroutine moves itself onto a pool with co_await BS::schedule_on(pool), and waits for other coroutines with co_await or BS::when_all() by suspending rather than blocking, so a worker is never tied up waiting for another worker. BS::sync_wait() runs a coroutine from outside the pool and blocks until it finishes. Coroutine frames are allocated with BS::block_recycler. Requires C++20.
+ */
+
+#include <atomic>             // std::atomic
+#include <condition_variable> // std::condition_variable
+#include <coroutine>          // std::coroutine_handle, std::noop_coroutine, std::suspend_always, std::suspend_never
+#include <cstddef>            // std::size_t
+#include <exception>          // std::current_exception, std::exception_ptr, std::rethrow_exception, std::terminate
+#include <mutex>              // std::mutex, std::scoped_lock, std::unique_lock
+#include <optional>           // std::optional
+#include <type_traits>        // std::conditional_t, std::is_void_v
+#include <utility>            // std::exchange, std::forward, std::move
+#include <vector>             // std::vector
+
+#include "BS_thread_pool.hpp"
+
+namespace BS
+{
+// ============================================================================================= //
+//                                       Begin class task                                        //
+
+template <typename T>
+class task;
+
+/**
+ * @brief The parts of the promise of a task that don't depend on its result type: where to continue once the task finishes, the exception it threw if any, and allocating its frame.
+ */
+class task_promise_base
+{
+public:
+    /**
+     * @brief Resumes whichever coroutine was waiting for the task once it finishes, without growing the stack.
+     */
+    struct final_awaiter
+    {
+        [[nodiscard]] bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template <typename P>
+        [[nodiscard]] std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) const noexcept
+        {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    /**
+     * @brief Tasks are lazy, and only start once they are awaited.
+     */
+    [[nodiscard]] std::suspend_always initial_suspend() const noexcept
+    {
+        return {};
+    }
+
+    [[nodiscard]] final_awaiter final_suspend() const noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception() noexcept
+    {
+        exception = std::current_exception();
+    }
+
+    /**
+     * @brief Allocate a coroutine frame, reusing a freed one of a similar size if possible.
+     *
+     * @param bytes The size of the frame.
+     * @return A pointer to the frame.
+     */
+    [[nodiscard]] static void* operator new(const size_t bytes)
+    {
+        return block_recycler::allocate(bytes);
+    }
+
+    /**
+     * @brief Free a coroutine frame, keeping it for reuse if possible.
+     *
+     * @param frame The frame.
+     * @param bytes The size of the frame.
+     */
+    static void operator delete(void* frame, const size_t bytes)
+    {
+        block_recycler::deallocate(frame, bytes);
+    }
+
+    /**
+     * @brief The coroutine waiting for this task, if any.
+     */
+    std::coroutine_handle<> continuation = {};
+
+    /**
+     * @brief The exception the task threw, if any.
+     */
+    std::exception_ptr exception = nullptr;
+};
+
+/**
+ * @brief The promise of a task with a result.
+ *
+ * @tparam T The result type of the task.
+ */
+template <typename T>
+class task_promise : public task_promise_base
+{
+public:
+    [[nodiscard]] task<T> get_return_object() noexcept
+    {
+        return task<T>(std::coroutine_handle<task_promise>::from_promise(*this));
+    }
+
+    template <typename V>
+    void return_value(V&& value_)
+    {
+        value.emplace(std::forward<V>(value_));
+    }
+
+    /**
+     * @brief Get the result of the task, rethrowing its exception if it failed. Moves the result out, so it can only be called once.
+     *
+     * @return The result.
+     */
+    T result()
+    {
+        if (exception)
+            std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+
+private:
+    /**
+     * @brief The result of the task, once it has returned.
+     */
+    std::optional<T> value = std::nullopt;
+};
+
+/**
+ * @brief The promise of a task with no result.
+ */
+template <>
+class task_promise<void> : public task_promise_base
+{
+public:
+    [[nodiscard]] task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+
+    /**
+     * @brief Rethrow the exception of the task if it failed.
+     */
+    void result() const
+    {
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+};
+
+/**
+ * @brief A lazily started coroutine that produces a value of type T. Awaiting a task starts it in the awaiting thread, suspends the awaiting coroutine until the task finishes, and then returns its result or rethrows its exception. Each task can only be awaited once.
+ *
+ * @tparam T The result type of the task (can be void).
+ */
+template <typename T = void>
+class [[nodiscard]] task
+{
+public:
+    using promise_type = task_promise<T>;
+
+    /**
+     * @brief Construct a task that owns the given coroutine. Used by the promise.
+     *
+     * @param handle_ The coroutine.
+     */
+    explicit task(std::coroutine_handle<promise_type> handle_) noexcept : handle(handle_) {}
+
+    task(task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+    task& operator=(task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle)
+                handle.destroy();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    /**
+     * @brief Destroy the coroutine frame, if the task still owns one.
+     */
+    ~task()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    /**
+     * @brief Start the task and wait for it to finish.
+     *
+     * @return An awaiter for the result of the task.
+     */
+    auto operator co_await() && noexcept
+    {
+        struct awaiter
+        {
+            [[nodiscard]] bool await_ready() const noexcept
+            {
+                return handle.done();
+            }
+
+            [[nodiscard]] std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept
+            {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() const
+            {
+                return handle.promise().result();
+            }
+
+            std::coroutine_handle<promise_type> handle;
+        };
+        return awaiter{handle};
+    }
+
+private:
+    /**
+     * @brief The coroutine owned by this task.
+     */
+    std::coroutine_handle<promise_type> handle = {};
+};
+
+inline task<void> task_promise<void>::get_return_object() noexcept
+{
+    return task<void>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+
+//                                        End class task                                         //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                    Begin class schedule_on                                    //
+
+/**
+ * @brief An awaitable that resumes the awaiting coroutine on a worker of a thread pool.
+ *
+ * @tparam Pool The type of the pool. Any pool with the same push_task() as BS::thread_pool works.
+ */
+template <typename Pool>
+class [[nodiscard]] schedule_awaiter
+{
+public:
+    explicit schedule_awaiter(Pool& pool_) noexcept : pool(pool_) {}
+
+    [[nodiscard]] bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+        pool.push_task([handle] { handle.resume(); });
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    /**
+     * @brief The pool to resume on.
+     */
+    Pool& pool;
+};
+
+/**
+ * @brief Move the awaiting coroutine onto a worker of a thread pool: co_await BS::schedule_on(pool).
+ *
+ * @tparam Pool The type of the pool.
+ * @param pool The pool.
+ * @return An awaitable that resumes the coroutine on the pool.
+ */
+template <typename Pool>
+schedule_awaiter<Pool> schedule_on(Pool& pool)
+{
+    return schedule_awaiter<Pool>(pool);
+}
+
+/**
+ * @brief A coroutine that starts immediately and destroys itself once it finishes. Used to run tasks without anyone awaiting them. Exceptions must be caught inside the coroutine.
+ */
+class detached_task
+{
+public:
+    struct promise_type
+    {
+        [[nodiscard]] detached_task get_return_object() const noexcept
+        {
+            return {};
+        }
+
+        [[nodiscard]] std::suspend_never initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        [[nodiscard]] std::suspend_never final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() const noexcept
+        {
+            std::terminate();
+        }
+
+        [[nodiscard]] static void* operator new(const size_t bytes)
+        {
+            return block_recycler::allocate(bytes);
+        }
+
+        static void operator delete(void* frame, const size_t bytes)
+        {
+            block_recycler::deallocate(frame, bytes);
+        }
+    };
+};
+
+/**
+ * @brief The state shared between when_all() and the tasks it is waiting for.
+ *
+ * @tparam T The result type of the tasks.
+ */
+template <typename T>
+struct when_all_state
+{
+    explicit when_all_state(const size_t count) : remaining(count + 1), results(std::is_void_v<T> ? 0 : count) {}
+
+    /**
+     * @brief The number of tasks still running, plus one for when_all() itself until it has started all of them.
+     */
+    std::atomic<size_t> remaining;
+
+    /**
+     * @brief The results of the tasks, in the order they were given. Unused if T is void.
+     */
+    std::vector<std::optional<std::conditional_t<std::is_void_v<T>, bool, T>>> results;
+
+    /**
+     * @brief The first exception thrown by any of the tasks, if any.
+     */
+    std::exception_ptr exception = nullptr;
+
+    /**
+     * @brief A mutex to synchronize setting the exception.
+     */
+    std::mutex exception_mutex = {};
+
+    /**
+     * @brief The coroutine waiting in when_all().
+     */
+    std::coroutine_handle<> continuation = {};
+};
+
+/**
+ * @brief Run one of the tasks of when_all() on the pool, and resume when_all() if it was the last one to finish.
+ *
+ * @tparam Pool The type of the pool.
+ * @tparam T The result type of the task.
+ * @param pool The pool.
+ * @param child The task.
+ * @param state The state of when_all().
+ * @param index The position of the task.
+ */
+template <typename Pool, typename T>
+detached_task run_when_all_child(Pool& pool, task<T> child, when_all_state<T>& state, const size_t index)
+{
+    co_await schedule_on(pool);
+    try
+    {
+        if constexpr (std::is_void_v<T>)
+            co_await std::move(child);
+        else
+            state.results[index].emplace(co_await std::move(child));
+    }
+    catch (...)
+    {
+        const std::scoped_lock exception_lock(state.exception_mutex);
+        if (!state.exception)
+            state.exception = std::current_exception();
+    }
+    if (--state.remaining == 0)
+        state.continuation.resume();
+}
+
+/**
+ * @brief Suspends when_all() while its tasks run, unless they all finished before it could suspend.
+ *
+ * @tparam Pool The type of the pool.
+ * @tparam T The result type of the tasks.
+ */
+template <typename Pool, typename T>
+struct when_all_awaiter
+{
+    [[nodiscard]] bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    [[nodiscard]] bool await_suspend(std::coroutine_handle<> awaiting)
+    {
+        state.continuation = awaiting;
+        for (size_t i = 0; i < tasks.size(); ++i)
+            run_when_all_child(pool, std::move(tasks[i]), state, i);
+        return --state.remaining != 0;
+    }
+
+    void await_resume() const noexcept {}
+
+    Pool& pool;
+    std::vector<task<T>>& tasks;
+    when_all_state<T>& state;
+};
+
+/**
+ * @brief Run tasks in parallel on a thread pool, and suspend until all of them finish. The awaiting coroutine is resumed by whichever worker finishes the last task.
+ *
+ * @tparam Pool The type of the pool.
+ * @tparam T The result type of the tasks.
+ * @param pool The pool.
+ * @param tasks The tasks.
+ * @return A task for the results of the tasks, in the order they were given, or nothing if T is void. If any of the tasks failed, rethrows the first exception once all of them are done.
+ */
+template <typename Pool, typename T>
+task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> when_all(Pool& pool, std::vector<task<T>> tasks)
+{
+    when_all_state<T> state(tasks.size());
+    co_await when_all_awaiter<Pool, T>{pool, tasks, state};
+    if (state.exception)
+        std::rethrow_exception(state.exception);
+    if constexpr (!std::is_void_v<T>)
+    {
+        std::vector<T> results;
+        results.reserve(state.results.size());
+        for (std::optional<T>& result : state.results)
+            results.push_back(std::move(*result));
+        co_return results;
+    }
+}
+
+//                                     End class schedule_on                                     //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                     Begin class sync_wait                                     //
+
+/**
+ * @brief The state shared between sync_wait() and the task it is waiting for.
+ *
+ * @tparam T The result type of the task.
+ */
+template <typename T>
+struct sync_wait_state
+{
+    std::optional<std::conditional_t<std::is_void_v<T>, bool, T>> result = std::nullopt;
+    std::exception_ptr exception = nullptr;
+    bool done = false;
+    std::mutex done_mutex = {};
+    std::condition_variable done_cv = {};
+};
+
+/**
+ * @brief Run a task for sync_wait() and wake it up once the task finishes.
+ *
+ * @tparam T The result type of the task.
+ * @param awaited The task.
+ * @param state The state of sync_wait().
+ */
+template <typename T>
+detached_task run_sync_wait(task<T> awaited, sync_wait_state<T>& state)
+{
+    try
+    {
+        if constexpr (std::is_void_v<T>)
+            co_await std::move(awaited);
+        else
+            state.result.emplace(co_await std::move(awaited));
+    }
+    catch (...)
+    {
+        state.exception = std::current_exception();
+    }
+    const std::scoped_lock done_lock(state.done_mutex);
+    state.done = true;
+    state.done_cv.notify_all();
+}
+
+/**
+ * @brief Start a task in the calling thread and block until it finishes. Meant for bridging from ordinary code, such as main(), into coroutines. Calling it from a worker ties that worker up, which is what coroutines are meant to avoid.
+ *
+ * @tparam T The result type of the task (can be void).
+ * @param awaited The task.
+ * @return The result of the task. Rethrows its exception if it failed.
+ */
+template <typename T>
+T sync_wait(task<T> awaited)
+{
+    sync_wait_state<T> state;
+    run_sync_wait(std::move(awaited), state);
+    std::unique_lock<std::mutex> done_lock(state.done_mutex);
+    state.done_cv.wait(done_lock, [&state] { return state.done; });
+    if (state.exception)
+        std::rethrow_exception(state.exception);
+    if constexpr (!std::is_void_v<T>)
+        return std::move(*state.result);
+}
+
+//                                      End class sync_wait                                      //
+// ============================================================================================= //
+
+} // namespace BS
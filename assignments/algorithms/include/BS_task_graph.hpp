@@ -0,0 +1,634 @@
+#pragma once
+
+/**
+ * @file BS_task_graph.hpp
+ *
+ * @brief BS::task_graph: a layer on top of any of the thread pools for running tasks that depend on each other. Each task is a node in a directed acyclic graph, and is pushed to the pool as soon as all of the nodes it depends on have finished, so no thread ever blocks waiting for an input. Nodes are represented by BS::task_future objects, which can be chained with then() and combined with when_all() and when_any().
+ */
+
+#include <atomic>             // std::atomic
+#include <condition_variable> // std::condition_variable
+#include <cstddef>            // std::size_t
+#include <exception>          // std::current_exception, std::exception_ptr, std::rethrow_exception
+#include <functional>         // std::bind, std::function, std::invoke
+#include <memory>             // std::make_shared, std::shared_ptr
+#include <mutex>              // std::mutex, std::scoped_lock, std::unique_lock
+#include <optional>           // std::optional
+#include <stdexcept>          // std::invalid_argument
+#include <type_traits>        // std::conditional_t, std::decay_t, std::invoke_result_t, std::is_void_v
+#include <utility>            // std::forward, std::move
+#include <vector>             // std::vector
+
+#include "BS_thread_pool.hpp"
+
+namespace BS
+{
+/**
+ * @brief Get the type that the result of a node with result type T is read as: a const reference to it, or void if T is void.
+ *
+ * @tparam T The result type of the node.
+ */
+template <typename T>
+struct task_result_reference
+{
+    using type = const T&;
+};
+
+template <>
+struct task_result_reference<void>
+{
+    using type = void;
+};
+
+/**
+ * @brief Get the return type of a continuation chained onto a node with result type T.
+ *
+ * @tparam T The result type of the node (can be void).
+ * @tparam F The type of the continuation.
+ */
+template <typename T, typename F>
+struct continuation_result
+{
+    using type = std::invoke_result_t<F&, const T&>;
+};
+
+template <typename F>
+struct continuation_result<void, F>
+{
+    using type = std::invoke_result_t<F&>;
+};
+
+// ============================================================================================= //
+//                                    Begin class task_state                                     //
+
+/**
+ * @brief The part of the state of a node that doesn't depend on its result type: whether it has finished, the exception it threw if it failed, and the callbacks to run once it finishes.
+ */
+class task_state_base
+{
+public:
+    virtual ~task_state_base() = default;
+
+    /**
+     * @brief Get the exception that the node failed with. Must only be called once the node is ready.
+     *
+     * @return The exception, or nullptr if the node succeeded.
+     */
+    [[nodiscard]] std::exception_ptr get_exception() const
+    {
+        const std::scoped_lock state_lock(state_mutex);
+        return exception;
+    }
+
+    /**
+     * @brief Check whether the node has finished, either with a result or with an exception.
+     *
+     * @return true if the node is ready, false otherwise.
+     */
+    [[nodiscard]] bool is_ready() const
+    {
+        const std::scoped_lock state_lock(state_mutex);
+        return ready;
+    }
+
+    /**
+     * @brief Run a callback once the node is ready. If it already is, the callback runs immediately in the calling thread. Otherwise, it runs in whichever thread finishes the node, so it should be short.
+     *
+     * @param callback The callback to run.
+     */
+    void on_ready(std::function<void()> callback)
+    {
+        {
+            const std::scoped_lock state_lock(state_mutex);
+            if (!ready)
+            {
+                callbacks.push_back(std::move(callback));
+                return;
+            }
+        }
+        callback();
+    }
+
+    /**
+     * @brief Finish the node with an exception.
+     *
+     * @param exception_ The exception.
+     */
+    void set_exception(std::exception_ptr exception_)
+    {
+        {
+            const std::scoped_lock state_lock(state_mutex);
+            exception = std::move(exception_);
+        }
+        mark_ready();
+    }
+
+    /**
+     * @brief Block the calling thread until the node is ready.
+     */
+    void wait() const
+    {
+        std::unique_lock<std::mutex> state_lock(state_mutex);
+        ready_cv.wait(state_lock, [this] { return ready; });
+    }
+
+protected:
+    /**
+     * @brief Mark the node as ready, wake up any threads waiting for it, and run its callbacks.
+     */
+    void mark_ready()
+    {
+        std::vector<std::function<void()>> ready_callbacks;
+        {
+            const std::scoped_lock state_lock(state_mutex);
+            ready = true;
+            ready_callbacks.swap(callbacks);
+        }
+        ready_cv.notify_all();
+        for (std::function<void()>& callback : ready_callbacks)
+            callback();
+    }
+
+    /**
+     * @brief A mutex to synchronize access to the state by different threads.
+     */
+    mutable std::mutex state_mutex = {};
+
+private:
+    /**
+     * @brief A condition variable used to notify wait() that the node is ready.
+     */
+    mutable std::condition_variable ready_cv = {};
+
+    /**
+     * @brief Whether the node has finished.
+     */
+    bool ready = false;
+
+    /**
+     * @brief The exception the node failed with, if any.
+     */
+    std::exception_ptr exception = nullptr;
+
+    /**
+     * @brief The callbacks to run once the node is ready.
+     */
+    std::vector<std::function<void()>> callbacks = {};
+};
+
+/**
+ * @brief The state of a node, including its result.
+ *
+ * @tparam T The result type of the node (can be void).
+ */
+template <typename T>
+class task_state : public task_state_base
+{
+public:
+    /**
+     * @brief Get the result of the node. Must only be called once the node is ready and has succeeded.
+     *
+     * @return A reference to the result, or nothing if T is void.
+     */
+    [[nodiscard]] typename task_result_reference<T>::type get_value() const
+    {
+        if constexpr (!std::is_void_v<T>)
+        {
+            const std::scoped_lock state_lock(state_mutex);
+            return *value;
+        }
+    }
+
+    /**
+     * @brief Finish the node with a result.
+     *
+     * @tparam V The type of the result.
+     * @param value_ The result.
+     */
+    template <typename V>
+    void set_value(V&& value_)
+    {
+        {
+            const std::scoped_lock state_lock(state_mutex);
+            value.emplace(std::forward<V>(value_));
+        }
+        mark_ready();
+    }
+
+    /**
+     * @brief Finish a node that has no result.
+     */
+    void set_value()
+    {
+        mark_ready();
+    }
+
+private:
+    /**
+     * @brief The result of the node, once it has succeeded. Unused if T is void.
+     */
+    std::optional<std::conditional_t<std::is_void_v<T>, bool, T>> value = std::nullopt;
+};
+
+//                                     End class task_state                                      //
+// ============================================================================================= //
+
+template <typename T>
+class task_future;
+
+template <typename R, typename F>
+class task_node;
+
+// ============================================================================================= //
+//                                    Begin class task_graph                                     //
+
+/**
+ * @brief The part of a node that the pool runs: a counter of the inputs it is still waiting for, and the function to run once there are none left.
+ */
+class task_node_base
+{
+public:
+    /**
+     * @brief Construct a node waiting for the given number of inputs.
+     *
+     * @param pending_inputs_ The number of inputs.
+     */
+    explicit task_node_base(const size_t pending_inputs_) : pending_inputs(pending_inputs_) {}
+
+    virtual ~task_node_base() = default;
+
+    /**
+     * @brief Run the node. Called by the pool.
+     */
+    virtual void run() = 0;
+
+    /**
+     * @brief The number of inputs the node is still waiting for. The node is pushed to the pool by whichever input brings this down to zero.
+     */
+    std::atomic<size_t> pending_inputs;
+};
+
+/**
+ * @brief A handle for adding nodes to a thread pool. Works with any pool that has the same push_task() as BS::thread_pool. Task graphs are cheap to copy, and all copies push to the same pool, which must outlive every node added through them.
+ */
+class [[nodiscard]] task_graph
+{
+public:
+    /**
+     * @brief Construct a task graph that pushes ready nodes to the given pool.
+     *
+     * @tparam Pool The type of the pool.
+     * @param pool_ The pool.
+     */
+    template <typename Pool>
+    explicit task_graph(Pool& pool_) : pool(&pool_), push_node(&push_node_to<Pool>)
+    {
+    }
+
+    /**
+     * @brief Add a node that runs a function once all of the given nodes have finished. If any of them failed, the function is not run and the node fails with the same exception as the first one that did. The function should read the results it needs from the futures of its dependencies, which are guaranteed to be ready.
+     *
+     * @tparam F The type of the function.
+     * @tparam T The result types of the dependencies.
+     * @tparam R The return type of the function (can be void).
+     * @param task The function to run. Should take no arguments.
+     * @param dependencies The futures of the nodes to wait for.
+     * @return A future for the new node.
+     */
+    template <typename F, typename... T, typename R = std::invoke_result_t<std::decay_t<F>>>
+    task_future<R> add_node(F&& task, const task_future<T>&... dependencies) const
+    {
+        return add_node_after<R>(std::forward<F>(task), {dependencies.state...});
+    }
+
+    /**
+     * @brief Add a node with no dependencies, which is pushed to the pool immediately. Like BS::thread_pool::submit(), but the result can be chained with then().
+     *
+     * @tparam F The type of the function.
+     * @tparam A The types of the zero or more arguments to pass to the function.
+     * @tparam R The return type of the function (can be void).
+     * @param task The function to run.
+     * @param args The zero or more arguments to pass to the function.
+     * @return A future for the new node.
+     */
+    template <typename F, typename... A, typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>
+    task_future<R> submit(F&& task, A&&... args) const
+    {
+        return add_node_after<R>(std::bind(std::forward<F>(task), std::forward<A>(args)...), {});
+    }
+
+    /**
+     * @brief Get a future that becomes ready once all of the given futures are ready, whether they succeeded or failed. Does not use the pool. Call get() on each of the inputs to find out which ones failed.
+     *
+     * @tparam T The result type of the futures.
+     * @param futures The futures to wait for.
+     * @return A future with no result.
+     */
+    template <typename T>
+    task_future<void> when_all(const std::vector<task_future<T>>& futures) const;
+
+    /**
+     * @brief Get a future that becomes ready as soon as any of the given futures is ready, whether it succeeded or failed. Does not use the pool.
+     *
+     * @tparam T The result type of the futures.
+     * @param futures The futures to wait for. Must not be empty.
+     * @return A future for the index of the first input to become ready.
+     */
+    template <typename T>
+    task_future<size_t> when_any(const std::vector<task_future<T>>& futures) const;
+
+private:
+    template <typename T>
+    friend class task_future;
+
+    /**
+     * @brief Add a node that runs a function once the given states are ready.
+     *
+     * @tparam R The return type of the function (can be void).
+     * @tparam F The type of the function.
+     * @param task The function to run.
+     * @param dependencies The states of the nodes to wait for.
+     * @return A future for the new node.
+     */
+    template <typename R, typename F>
+    task_future<R> add_node_after(F&& task, std::vector<std::shared_ptr<task_state_base>> dependencies) const
+    {
+        // One extra input so the node can't be pushed while the callbacks are still being added
+        std::shared_ptr<task_node<R, std::decay_t<F>>> node = std::make_shared<task_node<R, std::decay_t<F>>>(std::forward<F>(task), dependencies);
+        for (const std::shared_ptr<task_state_base>& dependency : dependencies)
+            dependency->on_ready([graph = *this, node] { graph.input_ready(node); });
+        input_ready(node);
+        return task_future<R>(node, *this);
+    }
+
+    /**
+     * @brief Record that one of the inputs of a node is ready, and push the node to the pool if it was the last one.
+     *
+     * @param node The node.
+     */
+    void input_ready(const std::shared_ptr<task_node_base>& node) const
+    {
+        if (--node->pending_inputs == 0)
+            push_node(pool, node);
+    }
+
+    /**
+     * @brief Push a node to a pool of a specific type.
+     *
+     * @tparam Pool The type of the pool.
+     * @param pool_ The pool.
+     * @param node The node to run.
+     */
+    template <typename Pool>
+    static void push_node_to(void* pool_, std::shared_ptr<task_node_base> node)
+    {
+        static_cast<Pool*>(pool_)->push_task([node = std::move(node)] { node->run(); });
+    }
+
+    /**
+     * @brief The pool that ready nodes are pushed to.
+     */
+    void* pool;
+
+    /**
+     * @brief push_node_to() for the type of the pool.
+     */
+    void (*push_node)(void*, std::shared_ptr<task_node_base>);
+};
+
+//                                     End class task_graph                                      //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                    Begin class task_future                                    //
+
+/**
+ * @brief A handle on a node in a task graph. Unlike std::future, it can be copied, get() can be called any number of times, and further nodes can be chained onto it with then().
+ *
+ * @tparam T The result type of the node (can be void).
+ */
+template <typename T>
+class [[nodiscard]] task_future
+{
+public:
+    /**
+     * @brief Wait for the node to finish and get its result, rethrowing its exception if it failed.
+     *
+     * @return A reference to the result, or nothing if T is void.
+     */
+    typename task_result_reference<T>::type get() const
+    {
+        state->wait();
+        if (std::exception_ptr exception = state->get_exception())
+            std::rethrow_exception(exception);
+        return state->get_value();
+    }
+
+    /**
+     * @brief Check whether the node has finished.
+     *
+     * @return true if the node is ready, false otherwise.
+     */
+    [[nodiscard]] bool is_ready() const
+    {
+        return state->is_ready();
+    }
+
+    /**
+     * @brief Add a copy of the result of the node, or its exception, to a completion queue once it finishes. The copy is made in whichever thread finishes the node.
+     *
+     * @param queue The completion queue to add the result to. Must outlive the node.
+     * @param tag The tag to add the result with.
+     */
+    void notify(completion_queue<T>& queue, const size_t tag) const
+    {
+        state->on_ready(
+            [ready_state = state, &queue, tag]
+            {
+                queue.complete(tag,
+                    [&ready_state]() -> T
+                    {
+                        if (std::exception_ptr exception = ready_state->get_exception())
+                            std::rethrow_exception(exception);
+                        if constexpr (!std::is_void_v<T>)
+                            return ready_state->get_value();
+                    });
+            });
+    }
+
+    /**
+     * @brief Add a node that runs a continuation on the result of this one once it finishes. If this node fails, the continuation is not run and the new node fails with the same exception.
+     *
+     * @tparam F The type of the continuation.
+     * @tparam R The return type of the continuation (can be void).
+     * @param continuation The continuation. Should take the result of this node as a const reference, or no arguments if T is void.
+     * @return A future for the new node.
+     */
+    template <typename F, typename R = typename continuation_result<T, std::decay_t<F>>::type>
+    task_future<R> then(F&& continuation) const
+    {
+        return graph.template add_node_after<R>(
+            [continuation = std::forward<F>(continuation), antecedent = *this]() mutable -> R
+            {
+                if constexpr (std::is_void_v<T>)
+                    return std::invoke(continuation);
+                else
+                    return std::invoke(continuation, antecedent.get());
+            },
+            {state});
+    }
+
+    /**
+     * @brief Block the calling thread until the node is ready.
+     */
+    void wait() const
+    {
+        state->wait();
+    }
+
+private:
+    friend class task_graph;
+
+    /**
+     * @brief Construct a future for the given state.
+     *
+     * @param state_ The state of the node.
+     * @param graph_ The graph that continuations will be added to.
+     */
+    task_future(std::shared_ptr<task_state<T>> state_, const task_graph& graph_) : state(std::move(state_)), graph(graph_) {}
+
+    /**
+     * @brief The state of the node, shared with every copy of this future.
+     */
+    std::shared_ptr<task_state<T>> state;
+
+    /**
+     * @brief The graph that continuations will be added to.
+     */
+    task_graph graph;
+};
+
+// The combinators of task_graph need task_future to be complete, so they are defined here.
+
+template <typename T>
+task_future<void> task_graph::when_all(const std::vector<task_future<T>>& futures) const
+{
+    std::shared_ptr<task_state<void>> state = std::make_shared<task_state<void>>();
+    // One extra count so the result can't become ready while the callbacks are still being added
+    std::shared_ptr<std::atomic<size_t>> remaining = std::make_shared<std::atomic<size_t>>(futures.size() + 1);
+    auto input_ready = [state, remaining]
+    {
+        if (--*remaining == 0)
+            state->set_value();
+    };
+    for (const task_future<T>& future : futures)
+        future.state->on_ready(input_ready);
+    input_ready();
+    return task_future<void>(state, *this);
+}
+
+template <typename T>
+task_future<size_t> task_graph::when_any(const std::vector<task_future<T>>& futures) const
+{
+    if (futures.empty())
+        throw std::invalid_argument("when_any() needs at least one future to wait for.");
+    std::shared_ptr<task_state<size_t>> state = std::make_shared<task_state<size_t>>();
+    std::shared_ptr<std::atomic<bool>> claimed = std::make_shared<std::atomic<bool>>(false);
+    for (size_t i = 0; i < futures.size(); ++i)
+    {
+        futures[i].state->on_ready(
+            [state, claimed, i]
+            {
+                if (!claimed->exchange(true))
+                    state->set_value(i);
+            });
+    }
+    return task_future<size_t>(state, *this);
+}
+
+//                                     End class task_future                                     //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                     Begin class task_node                                     //
+
+/**
+ * @brief A node that runs a function once its dependencies are ready, and stores its result.
+ *
+ * @tparam R The return type of the function (can be void).
+ * @tparam F The type of the function.
+ */
+template <typename R, typename F>
+class task_node final : public task_state<R>, public task_node_base
+{
+public:
+    /**
+     * @brief Construct a node.
+     *
+     * @param task_ The function to run.
+     * @param dependencies_ The states of the nodes to wait for.
+     */
+    template <typename G>
+    task_node(G&& task_, std::vector<std::shared_ptr<task_state_base>> dependencies_) : task_node_base(dependencies_.size() + 1), task(std::forward<G>(task_)), dependencies(std::move(dependencies_))
+    {
+    }
+
+    /**
+     * @brief Run the function, or fail with the exception of the first dependency that failed. The function and dependencies are released afterwards, so that long chains of nodes don't keep every earlier result alive.
+     */
+    void run() override
+    {
+        std::exception_ptr dependency_exception = nullptr;
+        for (const std::shared_ptr<task_state_base>& dependency : dependencies)
+        {
+            dependency_exception = dependency->get_exception();
+            if (dependency_exception)
+                break;
+        }
+        dependencies.clear();
+
+        if (dependency_exception)
+        {
+            task.reset();
+            this->set_exception(dependency_exception);
+            return;
+        }
+
+        try
+        {
+            if constexpr (std::is_void_v<R>)
+            {
+                std::invoke(*task);
+                task.reset();
+                this->set_value();
+            }
+            else
+            {
+                R result = std::invoke(*task);
+                task.reset();
+                this->set_value(std::move(result));
+            }
+        }
+        catch (...)
+        {
+            task.reset();
+            this->set_exception(std::current_exception());
+        }
+    }
+
+private:
+    /**
+     * @brief The function to run, until it has run.
+     */
+    std::optional<F> task;
+
+    /**
+     * @brief The states of the nodes this one depends on, until it has run.
+     */
+    std::vector<std::shared_ptr<task_state_base>> dependencies;
+};
+
+//                                      End class task_node                                      //
+// ============================================================================================= //
+
+} // namespace BS
@@ -7,23 +7,32 @@
  * @date 2023-05-12
  * @copyright Copyright (c) 2023 Barak Shoshany. Licensed under the MIT license. If you found this project useful, please consider starring it on GitHub! If you use this library in software of any kind, please provide a link to the GitHub repository https://github.com/bshoshany/thread-pool in the source code and documentation. If you use this library in published research, please cite it as follows: Barak Shoshany, "A C++17 Thread Pool for High-Performance Scientific Computing", doi:10.5281/zenodo.4742687, arXiv:2105.00613 (May 2021)
  *
- * @brief BS::thread_pool: a fast, lightweight, and easy-to-use C++17 thread pool library. This header file contains the entire library, including the main BS::thread_pool class and the helper classes BS::multi_future, BS::blocks, BS:synced_stream, and BS::timer.
+ * @brief BS::thread_pool: a fast, lightweight, and easy-to-use C++17 thread pool library. This header file contains the entire library, including the main BS::basic_thread_pool class (used through the aliases BS::thread_pool and BS::lock_free_thread_pool), its task queues BS::locked_task_queue and BS::mpmc_task_queue, the task storage helpers BS::inline_task and BS::recycling_allocator, and the helper classes BS::multi_future, BS::blocks, BS:synced_stream, and BS::timer.
  */
 
 #define BS_THREAD_POOL_VERSION "v3.4.0 (2023-05-12)"
 
+#include <algorithm>          // std::clamp, std::find_if, std::max
 #include <atomic>             // std::atomic
 #include <chrono>             // std::chrono
 #include <condition_variable> // std::condition_variable
+#include <cstddef>            // std::max_align_t, std::ptrdiff_t
+#include <cstdint>            // std::int64_t, std::uint64_t, UINT64_MAX
+#include <deque>              // std::deque
 #include <exception>          // std::current_exception
-#include <functional>         // std::bind, std::function, std::invoke
+#include <functional>         // std::bind, std::invoke
 #include <future>             // std::future, std::promise
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>        // _mm_pause
+#endif
 #include <iostream>           // std::cout, std::endl, std::flush, std::ostream
-#include <memory>             // std::make_shared, std::make_unique, std::shared_ptr, std::unique_ptr
+#include <memory>             // std::allocator, std::allocator_arg, std::make_unique, std::unique_ptr
+#include <optional>           // std::optional
 #include <mutex>              // std::mutex, std::scoped_lock, std::unique_lock
+#include <new>                // operator new, operator delete
 #include <queue>              // std::queue
 #include <thread>             // std::thread
-#include <type_traits>        // std::common_type_t, std::conditional_t, std::decay_t, std::invoke_result_t, std::is_void_v
+#include <type_traits>        // std::common_type_t, std::conditional_t, std::decay_t, std::enable_if_t, std::invoke_result_t, std::is_void_v
 #include <utility>            // std::forward, std::move, std::swap
 #include <vector>             // std::vector
 
@@ -232,12 +241,1061 @@ private:
 // ============================================================================================= //
 
 // ============================================================================================= //
-//                                    Begin class thread_pool                                    //
+//                                    Begin class inline_task                                    //
 
 /**
- * @brief A fast, lightweight, and easy-to-use C++17 thread pool class.
+ * @brief A move-only replacement for std::function<void()> that stores small callables inside itself instead of on the heap. Callables that are too large, over-aligned, or that might throw when moved fall back to a heap allocation.
  */
-class [[nodiscard]] thread_pool
+class [[nodiscard]] inline_task
+{
+public:
+    /**
+     * @brief The number of bytes available for storing a callable inline. Chosen so that a whole inline_task fits in a single cache line.
+     */
+    static constexpr size_t inline_size = 64 - sizeof(void*);
+
+    /**
+     * @brief Construct an empty task.
+     */
+    inline_task() = default;
+
+    /**
+     * @brief Construct a task from a callable, storing it inline if possible.
+     *
+     * @tparam F The type of the callable.
+     * @param callable The callable to store. Will be invoked with no arguments.
+     */
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, inline_task>>>
+    inline_task(F&& callable)
+    {
+        using D = std::decay_t<F>;
+        if constexpr (fits_inline<D>)
+        {
+            new (storage) D(std::forward<F>(callable));
+            ops = &inline_operations<D>;
+        }
+        else
+        {
+            *reinterpret_cast<D**>(storage) = new D(std::forward<F>(callable));
+            ops = &heap_operations<D>;
+        }
+    }
+
+    /**
+     * @brief Move a task into a new task, leaving the original empty.
+     *
+     * @param other The task to move.
+     */
+    inline_task(inline_task&& other) noexcept
+    {
+        move_from(other);
+    }
+
+    /**
+     * @brief Move a task into this one, destroying whatever this one held and leaving the original empty.
+     *
+     * @param other The task to move.
+     * @return A reference to this task.
+     */
+    inline_task& operator=(inline_task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    inline_task(const inline_task&) = delete;
+    inline_task& operator=(const inline_task&) = delete;
+
+    /**
+     * @brief Destroy the stored callable, if any.
+     */
+    ~inline_task()
+    {
+        reset();
+    }
+
+    /**
+     * @brief Invoke the stored callable. Must not be called on an empty task.
+     */
+    void operator()()
+    {
+        ops->invoke(storage);
+    }
+
+    /**
+     * @brief Check whether the task holds a callable.
+     *
+     * @return true if the task holds a callable, false if it is empty.
+     */
+    [[nodiscard]] explicit operator bool() const
+    {
+        return ops != nullptr;
+    }
+
+private:
+    /**
+     * @brief The type-specific operations on the stored callable.
+     */
+    struct operations
+    {
+        void (*invoke)(void*);
+        void (*move)(void* destination, void* source);
+        void (*destroy)(void*);
+    };
+
+    /**
+     * @brief Whether a callable of type D can be stored inline.
+     */
+    template <typename D>
+    static constexpr bool fits_inline = sizeof(D) <= inline_size && alignof(D) <= alignof(void*) && std::is_nothrow_move_constructible_v<D>;
+
+    /**
+     * @brief Operations on a callable of type D stored inline. Moving move-constructs the callable into the destination and destroys the source.
+     */
+    template <typename D>
+    static constexpr operations inline_operations = {
+        [](void* self) { (*static_cast<D*>(self))(); },
+        [](void* destination, void* source)
+        {
+            new (destination) D(std::move(*static_cast<D*>(source)));
+            static_cast<D*>(source)->~D();
+        },
+        [](void* self) { static_cast<D*>(self)->~D(); }};
+
+    /**
+     * @brief Operations on a callable of type D stored on the heap, with only a pointer to it stored inline. Moving just moves the pointer.
+     */
+    template <typename D>
+    static constexpr operations heap_operations = {
+        [](void* self) { (**static_cast<D**>(self))(); },
+        [](void* destination, void* source) { *static_cast<D**>(destination) = *static_cast<D**>(source); },
+        [](void* self) { delete *static_cast<D**>(self); }};
+
+    /**
+     * @brief Take the callable out of another task, leaving it empty. This task must be empty.
+     *
+     * @param other The task to take the callable from.
+     */
+    void move_from(inline_task& other) noexcept
+    {
+        if (other.ops)
+        {
+            other.ops->move(storage, other.storage);
+            ops = other.ops;
+            other.ops = nullptr;
+        }
+    }
+
+    /**
+     * @brief Destroy the stored callable, if any, leaving the task empty.
+     */
+    void reset()
+    {
+        if (ops)
+        {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+    /**
+     * @brief The storage for the callable itself, or for a pointer to it if it is stored on the heap.
+     */
+    alignas(void*) unsigned char storage[inline_size];
+
+    /**
+     * @brief The operations for the type of the stored callable, or nullptr if the task is empty.
+     */
+    const operations* ops = nullptr;
+};
+
+//                                     End class inline_task                                     //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                Begin class recycling_allocator                                //
+
+/**
+ * @brief Thread-local free lists of small memory blocks, grouped into size classes. Used by recycling_allocator so that the shared state of each std::promise created by submit() can reuse the memory of one that was already destroyed, instead of going through the global heap every time.
+ */
+class block_recycler
+{
+public:
+    /**
+     * @brief The size of the smallest size class. Every size class is a multiple of this.
+     */
+    static constexpr size_t class_size = 64;
+
+    /**
+     * @brief The number of size classes. Larger blocks are not recycled.
+     */
+    static constexpr size_t class_count = 8;
+
+    /**
+     * @brief The maximum number of free blocks each thread keeps per size class. Any more are returned to the heap, so a thread that only ever frees blocks doesn't hoard memory.
+     */
+    static constexpr size_t max_cached_blocks = 1024;
+
+    /**
+     * @brief Allocate a block, reusing a free one of the same size class if the current thread has one.
+     *
+     * @param bytes The number of bytes needed.
+     * @return A pointer to the block.
+     */
+    [[nodiscard]] static void* allocate(const size_t bytes)
+    {
+        if (bytes > class_size * class_count || free_lists_destroyed)
+            return ::operator new(bytes);
+        std::vector<void*>& free_list = free_lists.lists[(bytes - 1) / class_size];
+        if (!free_list.empty())
+        {
+            void* block = free_list.back();
+            free_list.pop_back();
+            return block;
+        }
+        return ::operator new(round_up(bytes));
+    }
+
+    /**
+     * @brief Give a block back, keeping it in the current thread's free list if there is room.
+     *
+     * @param block The block to give back.
+     * @param bytes The number of bytes that were requested when the block was allocated.
+     */
+    static void deallocate(void* block, const size_t bytes)
+    {
+        if (bytes > class_size * class_count || free_lists_destroyed)
+        {
+            ::operator delete(block);
+            return;
+        }
+        std::vector<void*>& free_list = free_lists.lists[(bytes - 1) / class_size];
+        if (free_list.size() < max_cached_blocks)
+            free_list.push_back(block);
+        else
+            ::operator delete(block);
+    }
+
+private:
+    /**
+     * @brief The free lists of one thread. Frees every cached block when the thread exits.
+     */
+    struct thread_free_lists
+    {
+        ~thread_free_lists()
+        {
+            for (std::vector<void*>& free_list : lists)
+                for (void* block : free_list)
+                    ::operator delete(block);
+            free_lists_destroyed = true;
+        }
+
+        std::vector<void*> lists[class_count];
+    };
+
+    /**
+     * @brief Round a number of bytes up to the size of its size class.
+     *
+     * @param bytes The number of bytes.
+     * @return The size of the size class.
+     */
+    [[nodiscard]] static size_t round_up(const size_t bytes)
+    {
+        return ((bytes - 1) / class_size + 1) * class_size;
+    }
+
+    /**
+     * @brief The free lists of the current thread.
+     */
+    inline static thread_local thread_free_lists free_lists = {};
+
+    /**
+     * @brief Whether the current thread's free lists have already been destroyed, in which case blocks freed while the thread exits go straight back to the heap.
+     */
+    inline static thread_local bool free_lists_destroyed = false;
+};
+
+/**
+ * @brief A standard allocator that gets its memory from block_recycler. Falls back to std::allocator for over-aligned types.
+ *
+ * @tparam T The type to allocate.
+ */
+template <typename T>
+class recycling_allocator
+{
+public:
+    using value_type = T;
+
+    recycling_allocator() = default;
+
+    template <typename U>
+    recycling_allocator(const recycling_allocator<U>&) noexcept
+    {
+    }
+
+    [[nodiscard]] T* allocate(const size_t n)
+    {
+        if constexpr (alignof(T) > alignof(std::max_align_t))
+            return std::allocator<T>().allocate(n);
+        else
+            return static_cast<T*>(block_recycler::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* block, const size_t n)
+    {
+        if constexpr (alignof(T) > alignof(std::max_align_t))
+            std::allocator<T>().deallocate(block, n);
+        else
+            block_recycler::deallocate(block, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const recycling_allocator<U>&) const noexcept
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const recycling_allocator<U>&) const noexcept
+    {
+        return false;
+    }
+};
+
+//                                 End class recycling_allocator                                 //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                 Begin class completion_queue                                  //
+
+/**
+ * @brief A queue of results in the order their tasks finish, rather than the order they were submitted in. Tasks are submitted to it with submit_to() on any of the thread pools, or task_future::notify() for task graph nodes, each with a tag chosen by the caller to tell the results apart. Each result is handed out as a ready std::future, so get() on it returns the result or rethrows the task's exception.
+ *
+ * @tparam T The return type of the tasks (can be void).
+ */
+template <typename T>
+class [[nodiscard]] completion_queue
+{
+public:
+    /**
+     * @brief A finished task: the tag it was submitted with, and a ready future for its result.
+     */
+    struct completion
+    {
+        size_t tag;
+        std::future<T> result;
+    };
+
+    /**
+     * @brief Run a function in the calling thread and add its result or exception to the queue. Used by submit_to().
+     *
+     * @tparam F The type of the function.
+     * @param tag The tag to add the result with.
+     * @param task The function to run.
+     */
+    template <typename F>
+    void complete(const size_t tag, F&& task)
+    {
+        std::promise<T> task_promise(std::allocator_arg, recycling_allocator<char>());
+        try
+        {
+            if constexpr (std::is_void_v<T>)
+            {
+                std::invoke(std::forward<F>(task));
+                task_promise.set_value();
+            }
+            else
+            {
+                task_promise.set_value(std::invoke(std::forward<F>(task)));
+            }
+        }
+        catch (...)
+        {
+            try
+            {
+                task_promise.set_exception(std::current_exception());
+            }
+            catch (...)
+            {
+            }
+        }
+        push(tag, task_promise.get_future());
+    }
+
+    /**
+     * @brief Check whether there are no finished tasks waiting to be popped.
+     *
+     * @return true if the queue is empty, false otherwise.
+     */
+    [[nodiscard]] bool empty() const
+    {
+        const std::scoped_lock queue_lock(queue_mutex);
+        return completions.empty();
+    }
+
+    /**
+     * @brief Wait until a task finishes, and take it out of the queue.
+     *
+     * @return The finished task.
+     */
+    [[nodiscard]] completion pop()
+    {
+        std::unique_lock<std::mutex> queue_lock(queue_mutex);
+        completion_cv.wait(queue_lock, [this] { return !completions.empty(); });
+        return take_front();
+    }
+
+    /**
+     * @brief Wait until a task finishes or the timeout expires, whichever comes first, and take the finished task out of the queue if there is one. Useful for doing something periodically, like printing progress, while waiting.
+     *
+     * @param duration The maximum time to wait.
+     * @return The finished task, or std::nullopt if none finished in time.
+     */
+    template <typename R, typename P>
+    [[nodiscard]] std::optional<completion> pop_for(const std::chrono::duration<R, P>& duration)
+    {
+        std::unique_lock<std::mutex> queue_lock(queue_mutex);
+        if (!completion_cv.wait_for(queue_lock, duration, [this] { return !completions.empty(); }))
+            return std::nullopt;
+        return take_front();
+    }
+
+    /**
+     * @brief Add a finished task to the queue, waking up a thread waiting in pop() if there is one.
+     *
+     * @param tag The tag of the task.
+     * @param result A ready future for the result of the task.
+     */
+    void push(const size_t tag, std::future<T> result)
+    {
+        {
+            const std::scoped_lock queue_lock(queue_mutex);
+            completions.push_back({tag, std::move(result)});
+        }
+        completion_cv.notify_one();
+    }
+
+    /**
+     * @brief Get the number of finished tasks waiting to be popped.
+     *
+     * @return The number of finished tasks.
+     */
+    [[nodiscard]] size_t size() const
+    {
+        const std::scoped_lock queue_lock(queue_mutex);
+        return completions.size();
+    }
+
+private:
+    /**
+     * @brief Take the oldest finished task out of the queue. The mutex must be held.
+     *
+     * @return The finished task.
+     */
+    completion take_front()
+    {
+        completion front = std::move(completions.front());
+        completions.pop_front();
+        return front;
+    }
+
+    /**
+     * @brief The finished tasks, in the order they finished.
+     */
+    std::deque<completion> completions = {};
+
+    /**
+     * @brief A condition variable used to notify pop() that a task has finished.
+     */
+    std::condition_variable completion_cv = {};
+
+    /**
+     * @brief A mutex to synchronize access to the queue by different threads.
+     */
+    mutable std::mutex queue_mutex = {};
+};
+
+//                                  End class completion_queue                                   //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                   Begin class task queues                                     //
+
+/**
+ * @brief The default task queue for BS::basic_thread_pool: an unbounded std::queue protected by a mutex.
+ */
+class [[nodiscard]] locked_task_queue
+{
+public:
+    /**
+     * @brief Add a task to the back of the queue. Always succeeds.
+     *
+     * @param task The task to add. Moved from.
+     * @return true.
+     */
+    bool try_push(inline_task& task)
+    {
+        const std::scoped_lock queue_lock(queue_mutex);
+        tasks.push(std::move(task));
+        return true;
+    }
+
+    /**
+     * @brief Take the task at the front of the queue, if there is one.
+     *
+     * @param task Where to move the task to.
+     * @return true if a task was taken, false if the queue was empty.
+     */
+    bool try_pop(inline_task& task)
+    {
+        const std::scoped_lock queue_lock(queue_mutex);
+        if (tasks.empty())
+            return false;
+        task = std::move(tasks.front());
+        tasks.pop();
+        return true;
+    }
+
+private:
+    /**
+     * @brief The tasks in the queue.
+     */
+    std::queue<inline_task> tasks = {};
+
+    /**
+     * @brief A mutex to synchronize access to the queue by different threads.
+     */
+    std::mutex queue_mutex = {};
+};
+
+/**
+ * @brief A bounded lock-free multi-producer multi-consumer task queue for BS::basic_thread_pool, based on Dmitry Vyukov's bounded MPMC queue. Every cell in the ring has a sequence number that tells producers and consumers whether it is their turn to use it, so pushing and popping each take a single compare-and-swap on the shared position. When the ring is full, try_push() fails and the pool has the producer yield and retry.
+ *
+ * @tparam Capacity The number of tasks the ring can hold. Must be a power of two.
+ */
+template <size_t Capacity = 16384>
+class [[nodiscard]] mpmc_task_queue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "The capacity of mpmc_task_queue must be a power of two.");
+
+public:
+    /**
+     * @brief Construct an empty queue.
+     */
+    mpmc_task_queue() : cells(std::make_unique<cell[]>(Capacity))
+    {
+        for (size_t i = 0; i < Capacity; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Add a task to the back of the queue, if there is room.
+     *
+     * @param task The task to add. Only moved from if it was added.
+     * @return true if the task was added, false if the queue was full.
+     */
+    bool try_push(inline_task& task)
+    {
+        size_t position = enqueue_position.load(std::memory_order_relaxed);
+        cell* target;
+        while (true)
+        {
+            target = &cells[position & mask];
+            const size_t sequence = target->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (difference == 0)
+            {
+                if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+        target->task = std::move(task);
+        target->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the task at the front of the queue, if there is one.
+     *
+     * @param task Where to move the task to.
+     * @return true if a task was taken, false if the queue was empty.
+     */
+    bool try_pop(inline_task& task)
+    {
+        size_t position = dequeue_position.load(std::memory_order_relaxed);
+        cell* target;
+        while (true)
+        {
+            target = &cells[position & mask];
+            const size_t sequence = target->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if (difference == 0)
+            {
+                if (dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = dequeue_position.load(std::memory_order_relaxed);
+            }
+        }
+        task = std::move(target->task);
+        target->sequence.store(position + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    /**
+     * @brief A slot in the ring.
+     */
+    struct cell
+    {
+        std::atomic<size_t> sequence;
+        inline_task task;
+    };
+
+    /**
+     * @brief Mask to turn a position into an index in the ring.
+     */
+    static constexpr size_t mask = Capacity - 1;
+
+    /**
+     * @brief The cells of the ring.
+     */
+    std::unique_ptr<cell[]> cells;
+
+    /**
+     * @brief The position the next task will be pushed to. Kept on its own cache line, since producers write to it.
+     */
+    alignas(64) std::atomic<size_t> enqueue_position = 0;
+
+    /**
+     * @brief The position the next task will be popped from. Kept on its own cache line, since consumers write to it.
+     */
+    alignas(64) std::atomic<size_t> dequeue_position = 0;
+};
+
+//                                    End class task queues                                      //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                    Begin class idle_policy                                    //
+
+/**
+ * @brief Tell the CPU that the current thread is busy-waiting. On x86 this is the PAUSE instruction, which stops the spin loop from flooding the memory pipeline and hands execution resources to the other hyperthread on the same core.
+ */
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/**
+ * @brief How a worker in BS::basic_thread_pool waits when it runs out of tasks. It first spins, checking for new tasks between calls to cpu_relax(), then yields its time slice, and only then parks on a condition variable. A parked worker costs a system call to wake up, so spinning for a little while trades idle CPU time for lower latency when tasks arrive in short bursts. The default is to park immediately.
+ */
+struct idle_policy
+{
+    /**
+     * @brief The number of times to check for new tasks while spinning, before starting to yield.
+     */
+    size_t spin_count = 0;
+
+    /**
+     * @brief The number of times to yield while checking for new tasks, before parking.
+     */
+    size_t yield_count = 0;
+};
+
+/**
+ * @brief Counts of what the workers of a BS::basic_thread_pool did while idle, summed over all workers since the pool was created.
+ */
+struct idle_stats
+{
+    /**
+     * @brief The number of spin iterations, i.e. calls to cpu_relax().
+     */
+    size_t spins = 0;
+
+    /**
+     * @brief The number of times a worker yielded its time slice.
+     */
+    size_t yields = 0;
+
+    /**
+     * @brief The number of times a worker parked on the condition variable.
+     */
+    size_t parks = 0;
+
+    /**
+     * @brief The number of times a producer had to notify the condition variable to wake a parked worker.
+     */
+    size_t wakes = 0;
+};
+
+//                                     End class idle_policy                                     //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                  Begin class elastic_policy                                   //
+
+/**
+ * @brief Settings for a BS::basic_thread_pool in elastic mode, where the number of threads follows demand instead of staying fixed. The pool starts with min_threads, adds a thread whenever there is pressure on the queue and every worker is busy, and lets a worker exit once it has been idle for idle_timeout. Resizing never waits for the queue to drain.
+ */
+struct elastic_policy
+{
+    /**
+     * @brief The number of threads the pool starts with and never shrinks below. At least one thread is always kept.
+     */
+    concurrency_t min_threads = 1;
+
+    /**
+     * @brief The number of threads the pool never grows beyond. The default value of 0 means the total number of hardware threads available.
+     */
+    concurrency_t max_threads = 0;
+
+    /**
+     * @brief Add a thread when more than this many tasks per thread are waiting in the queue.
+     */
+    size_t target_queue_depth = 2;
+
+    /**
+     * @brief Add a thread when tasks are waiting and no worker has taken one out of the queue for this long.
+     */
+    std::chrono::microseconds target_wait_time = std::chrono::milliseconds(1);
+
+    /**
+     * @brief Remove a thread once it has been idle for this long.
+     */
+    std::chrono::milliseconds idle_timeout = std::chrono::seconds(1);
+};
+
+/**
+ * @brief Counts of how a BS::basic_thread_pool in elastic mode has resized itself since it was last reset.
+ */
+struct elastic_stats
+{
+    /**
+     * @brief The number of threads added because of queue depth.
+     */
+    size_t grows_for_depth = 0;
+
+    /**
+     * @brief The number of threads added because of wait time.
+     */
+    size_t grows_for_wait = 0;
+
+    /**
+     * @brief The number of threads removed after being idle.
+     */
+    size_t shrinks = 0;
+
+    /**
+     * @brief The largest number of threads the pool has had at once.
+     */
+    concurrency_t peak_threads = 0;
+};
+
+//                                   End class elastic_policy                                    //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                 Begin class latency_histogram                                 //
+
+/**
+ * @brief A histogram of durations in nanoseconds with HDR-style log-linear buckets: every power of two is split into sub_bucket_count equal buckets, so each recorded value is accurate to within about 6% however large it is. Meant to be written by a single thread and read by any thread, so every counter is an atomic that the writer updates with plain loads and stores instead of read-modify-write operations. Copying a histogram takes a snapshot of it.
+ */
+class latency_histogram
+{
+public:
+    /**
+     * @brief The number of bits of each value that are kept exactly.
+     */
+    static constexpr unsigned sub_bucket_bits = 4;
+
+    /**
+     * @brief The number of buckets each power of two is split into.
+     */
+    static constexpr size_t sub_bucket_count = size_t(1) << sub_bucket_bits;
+
+    /**
+     * @brief Values of 2^max_bits nanoseconds (about 18 minutes) or more are counted in the last bucket.
+     */
+    static constexpr unsigned max_bits = 40;
+
+    /**
+     * @brief The total number of buckets.
+     */
+    static constexpr size_t bucket_count = (max_bits - sub_bucket_bits + 1) * sub_bucket_count;
+
+    latency_histogram() = default;
+
+    latency_histogram(const latency_histogram& other)
+    {
+        merge(other);
+    }
+
+    latency_histogram& operator=(const latency_histogram& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            merge(other);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Reset every counter to zero.
+     */
+    void clear()
+    {
+        for (std::atomic<uint64_t>& bucket : buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        total_count.store(0, std::memory_order_relaxed);
+        total_sum.store(0, std::memory_order_relaxed);
+        max_value.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of recorded values.
+     *
+     * @return The number of values.
+     */
+    [[nodiscard]] uint64_t count() const
+    {
+        return total_count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the exact largest recorded value.
+     *
+     * @return The largest value, or 0 if there are none.
+     */
+    [[nodiscard]] uint64_t max() const
+    {
+        return max_value.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the exact sum of the recorded values.
+     *
+     * @return The sum.
+     */
+    [[nodiscard]] uint64_t sum() const
+    {
+        return total_sum.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Add the counts of another histogram to this one. Only the thread that writes to this histogram may call this.
+     *
+     * @param other The histogram to add.
+     */
+    void merge(const latency_histogram& other)
+    {
+        for (size_t i = 0; i < bucket_count; ++i)
+            add_relaxed(buckets[i], other.buckets[i].load(std::memory_order_relaxed));
+        add_relaxed(total_count, other.count());
+        add_relaxed(total_sum, other.sum());
+        if (other.max() > max())
+            max_value.store(other.max(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the value at a percentile.
+     *
+     * @param percentile The percentile, from 0 to 100.
+     * @return The upper bound of the bucket the percentile falls in, capped at the largest recorded value, or 0 if there are no values.
+     */
+    [[nodiscard]] uint64_t percentile(const double percentile) const
+    {
+        uint64_t total = 0;
+        for (const std::atomic<uint64_t>& bucket : buckets)
+            total += bucket.load(std::memory_order_relaxed);
+        if (total == 0)
+            return 0;
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; ++i)
+        {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return std::min(bucket_upper_bound(i), max());
+        }
+        return max();
+    }
+
+    /**
+     * @brief Record a value. Only one thread may record into a given histogram.
+     *
+     * @param value The value in nanoseconds.
+     */
+    void record(const uint64_t value)
+    {
+        add_relaxed(buckets[bucket_index(value)], 1);
+        add_relaxed(total_count, 1);
+        add_relaxed(total_sum, value);
+        if (value > max_value.load(std::memory_order_relaxed))
+            max_value.store(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Write the histogram as a JSON object, with a summary and the non-empty buckets as [lower bound, count] pairs.
+     *
+     * @param out The stream to write to.
+     */
+    void write_json(std::ostream& out) const
+    {
+        out << "{\"count\": " << count() << ", \"sum\": " << sum() << ", \"max\": " << max();
+        out << ", \"p50\": " << percentile(50) << ", \"p90\": " << percentile(90) << ", \"p99\": " << percentile(99) << ", \"p99.9\": " << percentile(99.9);
+        out << ", \"buckets\": [";
+        bool first = true;
+        for (size_t i = 0; i < bucket_count; ++i)
+        {
+            const uint64_t bucket = buckets[i].load(std::memory_order_relaxed);
+            if (bucket == 0)
+                continue;
+            out << (first ? "" : ", ") << "[" << bucket_lower_bound(i) << ", " << bucket << "]";
+            first = false;
+        }
+        out << "]}";
+    }
+
+private:
+    /**
+     * @brief Add to a counter that only the calling thread writes to.
+     *
+     * @param counter The counter.
+     * @param amount The amount to add.
+     */
+    static void add_relaxed(std::atomic<uint64_t>& counter, const uint64_t amount)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Find the bucket a value falls in.
+     *
+     * @param value The value.
+     * @return The index of the bucket.
+     */
+    [[nodiscard]] static size_t bucket_index(uint64_t value)
+    {
+        if (value < sub_bucket_count)
+            return static_cast<size_t>(value);
+        if (value >= (uint64_t(1) << max_bits))
+            return bucket_count - 1;
+        unsigned highest_bit = 0;
+        while ((value >> (highest_bit + 1)) != 0)
+            ++highest_bit;
+        const unsigned shift = highest_bit - sub_bucket_bits;
+        return shift * sub_bucket_count + static_cast<size_t>(value >> shift);
+    }
+
+    /**
+     * @brief Get the smallest value that falls in a bucket.
+     *
+     * @param index The index of the bucket.
+     * @return The lower bound.
+     */
+    [[nodiscard]] static uint64_t bucket_lower_bound(const size_t index)
+    {
+        if (index < sub_bucket_count)
+            return index;
+        const size_t shift = index / sub_bucket_count - 1;
+        return static_cast<uint64_t>(sub_bucket_count + index % sub_bucket_count) << shift;
+    }
+
+    /**
+     * @brief Get the largest value that falls in a bucket.
+     *
+     * @param index The index of the bucket.
+     * @return The upper bound.
+     */
+    [[nodiscard]] static uint64_t bucket_upper_bound(const size_t index)
+    {
+        return index + 1 < bucket_count ? bucket_lower_bound(index + 1) - 1 : UINT64_MAX;
+    }
+
+    /**
+     * @brief The number of values recorded in each bucket.
+     */
+    std::atomic<uint64_t> buckets[bucket_count] = {};
+
+    /**
+     * @brief The number of values recorded.
+     */
+    std::atomic<uint64_t> total_count = 0;
+
+    /**
+     * @brief The sum of the values recorded.
+     */
+    std::atomic<uint64_t> total_sum = 0;
+
+    /**
+     * @brief The largest value recorded.
+     */
+    std::atomic<uint64_t> max_value = 0;
+};
+
+/**
+ * @brief A sample of the state of a BS::basic_thread_pool, taken periodically while instrumentation is enabled.
+ */
+struct queue_depth_sample
+{
+    /**
+     * @brief The time of the sample, in microseconds since instrumentation was enabled.
+     */
+    int64_t time_us = 0;
+
+    /**
+     * @brief The number of tasks waiting in the queue.
+     */
+    size_t tasks_queued = 0;
+
+    /**
+     * @brief The number of tasks running.
+     */
+    size_t tasks_running = 0;
+
+    /**
+     * @brief The number of threads in the pool.
+     */
+    concurrency_t thread_count = 0;
+};
+
+//                                  End class latency_histogram                                  //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                 Begin class basic_thread_pool                                 //
+
+/**
+ * @brief A fast, lightweight, and easy-to-use C++17 thread pool class, with a swappable task queue. Use BS::thread_pool for the default mutex-protected queue, or BS::lock_free_thread_pool for the lock-free ring.
+ *
+ * @tparam Queue The type of the task queue. Must provide bool try_push(inline_task&) and bool try_pop(inline_task&), and be safe to use from any number of threads at once.
+ */
+template <typename Queue = locked_task_queue>
+class [[nodiscard]] basic_thread_pool
 {
 public:
     // ============================
@@ -248,18 +1306,34 @@ public:
      * @brief Construct a new thread pool.
      *
      * @param thread_count_ The number of threads to use. The default value is the total number of hardware threads available, as reported by the implementation. This is usually determined by the number of cores in the CPU. If a core is hyperthreaded, it will count as two threads.
+     * @param idle_policy_ How the workers should wait for new tasks. The default is to park immediately.
+     */
+    basic_thread_pool(const concurrency_t thread_count_ = 0, const idle_policy& idle_policy_ = {})
+    {
+        set_idle_policy(idle_policy_);
+        create_threads(determine_thread_count(thread_count_));
+    }
+
+    /**
+     * @brief Construct a new thread pool in elastic mode, which grows and shrinks between the bounds of the elastic policy.
+     *
+     * @param elastic_policy_ The bounds and targets for resizing the pool.
+     * @param idle_policy_ How the workers should wait for new tasks. The default is to park immediately.
      */
-    thread_pool(const concurrency_t thread_count_ = 0) : thread_count(determine_thread_count(thread_count_)), threads(std::make_unique<std::thread[]>(determine_thread_count(thread_count_)))
+    basic_thread_pool(const elastic_policy& elastic_policy_, const idle_policy& idle_policy_ = {})
     {
-        create_threads();
+        set_idle_policy(idle_policy_);
+        set_elastic_policy(elastic_policy_);
+        create_threads(elastic_settings.min_threads);
     }
 
     /**
      * @brief Destruct the thread pool. Waits for all tasks to complete, then destroys all threads. Note that if the pool is paused, then any tasks still in the queue will never be executed.
      */
-    ~thread_pool()
+    ~basic_thread_pool()
     {
         wait_for_tasks();
+        disable_instrumentation();
         destroy_threads();
     }
 
@@ -267,6 +1341,75 @@ public:
     // Public member functions
     // =======================
 
+    /**
+     * @brief Get how the workers currently wait for new tasks.
+     *
+     * @return The idle policy.
+     */
+    [[nodiscard]] idle_policy get_idle_policy() const
+    {
+        return {spin_count.load(std::memory_order_relaxed), yield_count.load(std::memory_order_relaxed)};
+    }
+
+    /**
+     * @brief Get counts of how the pool has resized itself. All zero unless the pool is in elastic mode.
+     *
+     * @return The elastic statistics.
+     */
+    [[nodiscard]] elastic_stats get_elastic_stats() const
+    {
+        return {grows_for_depth.load(std::memory_order_relaxed), grows_for_wait.load(std::memory_order_relaxed), shrinks.load(std::memory_order_relaxed), peak_threads.load(std::memory_order_relaxed)};
+    }
+
+    /**
+     * @brief Get the queue depth samples taken since instrumentation was last enabled, oldest first.
+     *
+     * @return The samples.
+     */
+    [[nodiscard]] std::vector<queue_depth_sample> get_queue_depth_samples() const
+    {
+        const std::scoped_lock statistics_lock(statistics_mutex);
+        return std::vector<queue_depth_sample>(depth_samples.begin(), depth_samples.end());
+    }
+
+    /**
+     * @brief Get the time tasks spent running, merged over every worker. Only recorded while instrumentation is enabled.
+     *
+     * @return A snapshot of the run time histogram.
+     */
+    [[nodiscard]] latency_histogram get_run_time_histogram() const
+    {
+        const std::scoped_lock statistics_lock(statistics_mutex);
+        latency_histogram merged = retired_statistics.run_time;
+        for (const worker_statistics& statistics : worker_histograms)
+            merged.merge(statistics.run_time);
+        return merged;
+    }
+
+    /**
+     * @brief Get the time tasks spent in the queue between being pushed and starting to run, merged over every worker. Only recorded while instrumentation is enabled.
+     *
+     * @return A snapshot of the wait time histogram.
+     */
+    [[nodiscard]] latency_histogram get_wait_time_histogram() const
+    {
+        const std::scoped_lock statistics_lock(statistics_mutex);
+        latency_histogram merged = retired_statistics.wait_time;
+        for (const worker_statistics& statistics : worker_histograms)
+            merged.merge(statistics.wait_time);
+        return merged;
+    }
+
+    /**
+     * @brief Get counts of what the workers have done while idle since the pool was created.
+     *
+     * @return The idle statistics.
+     */
+    [[nodiscard]] idle_stats get_idle_stats() const
+    {
+        return {spins.load(std::memory_order_relaxed), yields.load(std::memory_order_relaxed), parks.load(std::memory_order_relaxed), wakes.load(std::memory_order_relaxed)};
+    }
+
     /**
      * @brief Get the number of tasks currently waiting in the queue to be executed by the threads.
      *
@@ -274,8 +1417,7 @@ public:
      */
     [[nodiscard]] size_t get_tasks_queued() const
     {
-        const std::scoped_lock tasks_lock(tasks_mutex);
-        return tasks.size();
+        return tasks_queued;
     }
 
     /**
@@ -285,8 +1427,7 @@ public:
      */
     [[nodiscard]] size_t get_tasks_running() const
     {
-        const std::scoped_lock tasks_lock(tasks_mutex);
-        return tasks_total - tasks.size();
+        return tasks_total - tasks_queued;
     }
 
     /**
@@ -300,7 +1441,7 @@ public:
     }
 
     /**
-     * @brief Get the number of threads in the pool.
+     * @brief Get the number of threads in the pool. In elastic mode, this changes as the pool resizes itself.
      *
      * @return The number of threads.
      */
@@ -309,6 +1450,26 @@ public:
         return thread_count;
     }
 
+    /**
+     * @brief Check whether the pool is in elastic mode.
+     *
+     * @return true if the pool resizes itself, false if it has a fixed number of threads.
+     */
+    [[nodiscard]] bool is_elastic() const
+    {
+        return elastic_mode;
+    }
+
+    /**
+     * @brief Check whether instrumentation is enabled.
+     *
+     * @return true if task times and queue depth are being recorded, false otherwise.
+     */
+    [[nodiscard]] bool is_instrumented() const
+    {
+        return instrumented;
+    }
+
     /**
      * @brief Check whether the pool is currently paused.
      *
@@ -336,7 +1497,7 @@ public:
     template <typename F, typename T1, typename T2, typename T = std::common_type_t<T1, T2>, typename R = std::invoke_result_t<std::decay_t<F>, T, T>>
     [[nodiscard]] multi_future<R> parallelize_loop(const T1 first_index, const T2 index_after_last, F&& loop, const size_t num_blocks = 0)
     {
-        blocks blks(first_index, index_after_last, num_blocks ? num_blocks : thread_count);
+        blocks blks(first_index, index_after_last, num_blocks ? num_blocks : thread_count.load());
         if (blks.get_total_size() > 0)
         {
             multi_future<R> mf(blks.get_num_blocks());
@@ -368,7 +1529,7 @@ public:
     }
 
     /**
-     * @brief Pause the pool. The workers will temporarily stop retrieving new tasks out of the queue, although any tasks already executed will keep running until they are finished.
+     * @brief Pause the pool. The workers will temporarily stop retrieving new tasks out of the queue, although any tasks already retrieved will keep running until they are finished.
      */
     void pause()
     {
@@ -390,7 +1551,7 @@ public:
     template <typename F, typename T1, typename T2, typename T = std::common_type_t<T1, T2>>
     void push_loop(const T1 first_index, const T2 index_after_last, F&& loop, const size_t num_blocks = 0)
     {
-        blocks blks(first_index, index_after_last, num_blocks ? num_blocks : thread_count);
+        blocks blks(first_index, index_after_last, num_blocks ? num_blocks : thread_count.load());
         if (blks.get_total_size() > 0)
         {
             for (size_t i = 0; i < blks.get_num_blocks(); ++i)
@@ -410,48 +1571,158 @@ public:
     template <typename F, typename T>
     void push_loop(const T index_after_last, F&& loop, const size_t num_blocks = 0)
     {
-        push_loop(0, index_after_last, std::forward<F>(loop), num_blocks);
+        push_loop(0, index_after_last, std::forward<F>(loop), num_blocks);
+    }
+
+    /**
+     * @brief Push a function with zero or more arguments, but no return value, into the task queue. Does not return a future, so the user must use wait_for_tasks() or some other method to ensure that the task finishes executing, otherwise bad things will happen. If the queue is bounded and full, waits until there is room.
+     *
+     * @tparam F The type of the function.
+     * @tparam A The types of the arguments.
+     * @param task The function to push.
+     * @param args The zero or more arguments to pass to the function. Note that if the task is a class member function, the first argument must be a pointer to the object, i.e. &object (or this), followed by the actual arguments.
+     */
+    template <typename F, typename... A>
+    void push_task(F&& task, A&&... args)
+    {
+        inline_task task_function;
+        if (instrumented)
+            task_function = instrument_task(std::bind(std::forward<F>(task), std::forward<A>(args)...));
+        else
+            task_function = inline_task(std::bind(std::forward<F>(task), std::forward<A>(args)...));
+        ++tasks_total;
+        ++tasks_queued;
+        while (!tasks.try_push(task_function))
+            std::this_thread::yield();
+        if (sleeping > 0)
+        {
+            wakes.fetch_add(1, std::memory_order_relaxed);
+            const std::scoped_lock tasks_lock(tasks_mutex);
+            task_available_cv.notify_one();
+        }
+        else if (elastic_mode && thread_count < elastic_settings.max_threads && tasks_queued > elastic_settings.target_queue_depth * thread_count)
+        {
+            if (add_thread())
+                grows_for_depth.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Reset the number of threads in the pool. Waits for all currently running tasks to be completed, then destroys all threads in the pool and creates a new thread pool with the new number of threads. Any tasks that were waiting in the queue before the pool was reset will then be executed by the new threads. If the pool was paused before resetting it, the new pool will be paused as well. The new pool has a fixed number of threads, even if the old one was in elastic mode.
+     *
+     * @param thread_count_ The number of threads to use. The default value is the total number of hardware threads available, as reported by the implementation. This is usually determined by the number of cores in the CPU. If a core is hyperthreaded, it will count as two threads.
+     */
+    void reset(const concurrency_t thread_count_ = 0)
+    {
+        const bool was_paused = paused;
+        paused = true;
+        wait_for_tasks();
+        destroy_threads();
+        elastic_mode = false;
+        paused = was_paused;
+        create_threads(determine_thread_count(thread_count_));
+    }
+
+    /**
+     * @brief Reset the pool into elastic mode with a new elastic policy. Waits for all currently running tasks to be completed like the other overload of reset(), and should not be called while other threads are pushing tasks. Note that an elastic pool never needs to be reset to change its number of threads.
+     *
+     * @param elastic_policy_ The bounds and targets for resizing the pool.
+     */
+    void reset(const elastic_policy& elastic_policy_)
+    {
+        const bool was_paused = paused;
+        paused = true;
+        wait_for_tasks();
+        destroy_threads();
+        set_elastic_policy(elastic_policy_);
+        paused = was_paused;
+        create_threads(elastic_settings.min_threads);
+    }
+
+    /**
+     * @brief Stop recording task times and sampling the queue depth. Everything recorded so far is kept until instrumentation is enabled again.
+     */
+    void disable_instrumentation()
+    {
+        instrumented = false;
+        {
+            const std::scoped_lock sampler_lock(sampler_mutex);
+            sampler_cv.notify_all();
+        }
+        if (sampler_thread.joinable())
+            sampler_thread.join();
     }
 
     /**
-     * @brief Push a function with zero or more arguments, but no return value, into the task queue. Does not return a future, so the user must use wait_for_tasks() or some other method to ensure that the task finishes executing, otherwise bad things will happen.
+     * @brief Start recording, for every task pushed from now on, how long it waited in the queue and how long it ran, and sample the queue depth periodically. Clears anything recorded before. While enabled, every task is wrapped to carry the time it was pushed, which costs two clock reads per task and may move a large task's storage to the heap. Tasks pushed earlier are not recorded. Waits for the tasks already in the pool to finish first, since workers record without read-modify-write operations and a clear that overlaps a recording task could be lost or mixed with its sample, so this must not be called from inside a task of this pool.
      *
-     * @tparam F The type of the function.
-     * @tparam A The types of the arguments.
-     * @param task The function to push.
-     * @param args The zero or more arguments to pass to the function. Note that if the task is a class member function, the first argument must be a pointer to the object, i.e. &object (or this), followed by the actual arguments.
+     * @param sample_interval How often to sample the queue depth.
      */
-    template <typename F, typename... A>
-    void push_task(F&& task, A&&... args)
+    void enable_instrumentation(const std::chrono::microseconds sample_interval = std::chrono::milliseconds(1))
     {
-        std::function<void()> task_function = std::bind(std::forward<F>(task), std::forward<A>(args)...);
+        disable_instrumentation();
+        // Tasks wrapped while instrumentation was last enabled may still be queued or running, and record when they finish
+        wait_for_tasks();
         {
-            const std::scoped_lock tasks_lock(tasks_mutex);
-            tasks.push(task_function);
-            ++tasks_total;
+            const std::scoped_lock statistics_lock(statistics_mutex);
+            for (worker_statistics& statistics : worker_histograms)
+                statistics.clear();
+            retired_statistics.clear();
+            depth_samples.clear();
         }
-        task_available_cv.notify_one();
+        instrumented = true;
+        sampler_thread = std::thread(&basic_thread_pool::sample_queue_depth, this, sample_interval);
     }
 
     /**
-     * @brief Reset the number of threads in the pool. Waits for all currently running tasks to be completed, then destroys all threads in the pool and creates a new thread pool with the new number of threads. Any tasks that were waiting in the queue before the pool was reset will then be executed by the new threads. If the pool was paused before resetting it, the new pool will be paused as well.
+     * @brief Change how the workers wait for new tasks. Workers that are already waiting keep the old policy until they next run out of tasks.
      *
-     * @param thread_count_ The number of threads to use. The default value is the total number of hardware threads available, as reported by the implementation. This is usually determined by the number of cores in the CPU. If a core is hyperthreaded, it will count as two threads.
+     * @param idle_policy_ The new idle policy.
      */
-    void reset(const concurrency_t thread_count_ = 0)
+    void set_idle_policy(const idle_policy& idle_policy_)
     {
-        const bool was_paused = paused;
-        paused = true;
-        wait_for_tasks();
-        destroy_threads();
-        thread_count = determine_thread_count(thread_count_);
-        threads = std::make_unique<std::thread[]>(thread_count);
-        paused = was_paused;
-        create_threads();
+        spin_count.store(idle_policy_.spin_count, std::memory_order_relaxed);
+        yield_count.store(idle_policy_.yield_count, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Write everything recorded by the instrumentation as a JSON object: the wait and run time histograms merged over every worker, the same for each current worker separately and for all the workers that have exited together, and the queue depth samples as [time (us), queued, running, threads] arrays. All times are in nanoseconds unless stated otherwise.
+     *
+     * @param out The stream to write to.
+     */
+    void write_instrumentation_json(std::ostream& out) const
+    {
+        out << "{\n  \"wait_time_ns\": ";
+        get_wait_time_histogram().write_json(out);
+        out << ",\n  \"run_time_ns\": ";
+        get_run_time_histogram().write_json(out);
+        out << ",\n  \"workers\": [";
+        {
+            const std::scoped_lock statistics_lock(statistics_mutex);
+            bool first = true;
+            for (const worker_statistics& statistics : worker_histograms)
+            {
+                if (!statistics.in_use)
+                    continue;
+                out << (first ? "\n    " : ",\n    ");
+                statistics.write_json(out);
+                first = false;
+            }
+            out << "\n  ],\n  \"exited_workers\": ";
+            retired_statistics.write_json(out);
+        }
+        out << ",\n  \"queue_depth\": [";
+        bool first = true;
+        for (const queue_depth_sample& sample : get_queue_depth_samples())
+        {
+            out << (first ? "" : ", ") << "[" << sample.time_us << ", " << sample.tasks_queued << ", " << sample.tasks_running << ", " << sample.thread_count << "]";
+            first = false;
+        }
+        out << "]\n}\n";
     }
 
     /**
-     * @brief Submit a function with zero or more arguments into the task queue. If the function has a return value, get a future for the eventual returned value. If the function has no return value, get an std::future<void> which can be used to wait until the task finishes.
+     * @brief Submit a function with zero or more arguments into the task queue. If the function has a return value, get a future for the eventual returned value. If the function has no return value, get an std::future<void> which can be used to wait until the task finishes. The promise is moved into the task itself rather than shared, and its shared state is allocated with recycling_allocator.
      *
      * @tparam F The type of the function.
      * @tparam A The types of the zero or more arguments to pass to the function.
@@ -463,35 +1734,56 @@ public:
     template <typename F, typename... A, typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>
     [[nodiscard]] std::future<R> submit(F&& task, A&&... args)
     {
-        std::function<R()> task_function = std::bind(std::forward<F>(task), std::forward<A>(args)...);
-        std::shared_ptr<std::promise<R>> task_promise = std::make_shared<std::promise<R>>();
+        std::promise<R> task_promise(std::allocator_arg, recycling_allocator<char>());
+        std::future<R> task_future = task_promise.get_future();
         push_task(
-            [task_function, task_promise]
+            [task_function = std::bind(std::forward<F>(task), std::forward<A>(args)...), task_promise = std::move(task_promise)]() mutable
             {
                 try
                 {
                     if constexpr (std::is_void_v<R>)
                     {
                         std::invoke(task_function);
-                        task_promise->set_value();
+                        task_promise.set_value();
                     }
                     else
                     {
-                        task_promise->set_value(std::invoke(task_function));
+                        task_promise.set_value(std::invoke(task_function));
                     }
                 }
                 catch (...)
                 {
                     try
                     {
-                        task_promise->set_exception(std::current_exception());
+                        task_promise.set_exception(std::current_exception());
                     }
                     catch (...)
                     {
                     }
                 }
             });
-        return task_promise->get_future();
+        return task_future;
+    }
+
+    /**
+     * @brief Submit a function with zero or more arguments into the task queue, and add its result to a completion queue once it finishes instead of returning a future.
+     *
+     * @tparam F The type of the function.
+     * @tparam A The types of the zero or more arguments to pass to the function.
+     * @tparam R The return type of the function (can be void).
+     * @param queue The completion queue to add the result to. Must outlive the task.
+     * @param tag The tag to add the result with.
+     * @param task The function to submit.
+     * @param args The zero or more arguments to pass to the function.
+     */
+    template <typename F, typename... A, typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>
+    void submit_to(completion_queue<R>& queue, const size_t tag, F&& task, A&&... args)
+    {
+        push_task(
+            [task_function = std::bind(std::forward<F>(task), std::forward<A>(args)...), &queue, tag]() mutable
+            {
+                queue.complete(tag, task_function);
+            });
     }
 
     /**
@@ -500,6 +1792,8 @@ public:
     void unpause()
     {
         paused = false;
+        const std::scoped_lock tasks_lock(tasks_mutex);
+        task_available_cv.notify_all();
     }
 
     /**
@@ -511,7 +1805,7 @@ public:
         {
             waiting = true;
             std::unique_lock<std::mutex> tasks_lock(tasks_mutex);
-            task_done_cv.wait(tasks_lock, [this] { return (tasks_total == (paused ? tasks.size() : 0)); });
+            task_done_cv.wait(tasks_lock, [this] { return tasks_done(); });
             waiting = false;
         }
     }
@@ -531,7 +1825,7 @@ public:
         {
             waiting = true;
             std::unique_lock<std::mutex> tasks_lock(tasks_mutex);
-            const bool status = task_done_cv.wait_for(tasks_lock, duration, [this] { return (tasks_total == (paused ? tasks.size() : 0)); });
+            const bool status = task_done_cv.wait_for(tasks_lock, duration, [this] { return tasks_done(); });
             waiting = false;
             return status;
         }
@@ -553,7 +1847,7 @@ public:
         {
             waiting = true;
             std::unique_lock<std::mutex> tasks_lock(tasks_mutex);
-            const bool status = task_done_cv.wait_until(tasks_lock, timeout_time, [this] { return (tasks_total == (paused ? tasks.size() : 0)); });
+            const bool status = task_done_cv.wait_until(tasks_lock, timeout_time, [this] { return tasks_done(); });
             waiting = false;
             return status;
         }
@@ -566,19 +1860,51 @@ private:
     // ========================
 
     /**
-     * @brief Create the threads in the pool and assign a worker to each thread.
+     * @brief Add a worker thread, unless the pool is already at its maximum size or shutting down. Only used in elastic mode.
+     *
+     * @return true if a thread was added, false otherwise.
+     */
+    bool add_thread()
+    {
+        const std::scoped_lock threads_lock(threads_mutex);
+        if (!running || thread_count >= elastic_settings.max_threads)
+            return false;
+        threads.emplace_back(&basic_thread_pool::worker, this);
+        ++thread_count;
+        if (thread_count > peak_threads.load(std::memory_order_relaxed))
+            peak_threads.store(thread_count, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Create the threads in the pool and assign a worker to each thread. In elastic mode, also start the monitor thread.
+     *
+     * @param thread_count_ The number of threads to create.
      */
-    void create_threads()
+    void create_threads(const concurrency_t thread_count_)
     {
         running = true;
-        for (concurrency_t i = 0; i < thread_count; ++i)
         {
-            threads[i] = std::thread(&thread_pool::worker, this);
+            const std::scoped_lock threads_lock(threads_mutex);
+            for (concurrency_t i = 0; i < thread_count_; ++i)
+            {
+                threads.emplace_back(&basic_thread_pool::worker, this);
+            }
+            thread_count = thread_count_;
+        }
+        if (elastic_mode)
+        {
+            grows_for_depth = 0;
+            grows_for_wait = 0;
+            shrinks = 0;
+            peak_threads = thread_count_;
+            last_dequeue_time = std::chrono::steady_clock::now().time_since_epoch().count();
+            monitor_thread = std::thread(&basic_thread_pool::monitor, this);
         }
     }
 
     /**
-     * @brief Destroy the threads in the pool.
+     * @brief Destroy the threads in the pool, including any that retired themselves in elastic mode and the monitor thread.
      */
     void destroy_threads()
     {
@@ -587,9 +1913,26 @@ private:
             const std::scoped_lock tasks_lock(tasks_mutex);
             task_available_cv.notify_all();
         }
-        for (concurrency_t i = 0; i < thread_count; ++i)
+        if (monitor_thread.joinable())
+        {
+            {
+                const std::scoped_lock monitor_lock(monitor_mutex);
+                monitor_cv.notify_all();
+            }
+            monitor_thread.join();
+        }
+        // Workers can retire themselves until they see running == false, which needs threads_mutex, so don't hold it while joining
+        std::vector<std::thread> exiting_threads;
+        {
+            const std::scoped_lock threads_lock(threads_mutex);
+            exiting_threads.swap(threads);
+            for (std::thread& thread : retired_threads)
+                exiting_threads.push_back(std::move(thread));
+            retired_threads.clear();
+        }
+        for (std::thread& thread : exiting_threads)
         {
-            threads[i].join();
+            thread.join();
         }
     }
 
@@ -613,27 +1956,267 @@ private:
     }
 
     /**
-     * @brief A worker function to be assigned to each thread in the pool. Waits until it is notified by push_task() that a task is available, and then retrieves the task from the queue and executes it. Once the task finishes, the worker notifies wait_for_tasks() in case it is waiting.
+     * @brief Watch for tasks waiting too long in elastic mode, and add a thread when they do. Also joins the threads of workers that retired. Checks several times per target wait time.
+     */
+    void monitor()
+    {
+        using clock = std::chrono::steady_clock;
+        const clock::duration check_interval = std::max<clock::duration>(elastic_settings.target_wait_time / 4, std::chrono::microseconds(100));
+        std::optional<clock::time_point> stalled_since = std::nullopt;
+        std::unique_lock<std::mutex> monitor_lock(monitor_mutex);
+        while (!monitor_cv.wait_for(monitor_lock, check_interval, [this] { return !running; }))
+        {
+            join_retired_threads();
+
+            // The queue is stalled if tasks are waiting and no worker is free to take them
+            if (paused || tasks_queued == 0 || sleeping > 0)
+            {
+                stalled_since = std::nullopt;
+                continue;
+            }
+            const clock::time_point now = clock::now();
+            if (!stalled_since)
+                stalled_since = now;
+            const clock::time_point last_dequeue(clock::duration(last_dequeue_time.load(std::memory_order_relaxed)));
+            if (now - std::max(*stalled_since, last_dequeue) >= elastic_settings.target_wait_time && add_thread())
+            {
+                grows_for_wait.fetch_add(1, std::memory_order_relaxed);
+                stalled_since = now;
+            }
+        }
+    }
+
+    /**
+     * @brief Join the threads of workers that retired themselves.
+     */
+    void join_retired_threads()
+    {
+        std::vector<std::thread> exited_threads;
+        {
+            const std::scoped_lock threads_lock(threads_mutex);
+            exited_threads.swap(retired_threads);
+        }
+        for (std::thread& thread : exited_threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Remove the calling worker from the pool, if the pool is above its minimum size. Only used in elastic mode. Its thread is joined later by the monitor thread or destroy_threads().
+     *
+     * @return true if the worker should exit, false if it should keep waiting for tasks.
+     */
+    bool retire_worker()
+    {
+        const std::scoped_lock threads_lock(threads_mutex);
+        if (!running || thread_count <= elastic_settings.min_threads)
+            return false;
+        const std::thread::id id = std::this_thread::get_id();
+        for (size_t i = 0; i < threads.size(); ++i)
+        {
+            if (threads[i].get_id() == id)
+            {
+                retired_threads.push_back(std::move(threads[i]));
+                threads.erase(threads.begin() + static_cast<std::ptrdiff_t>(i));
+                --thread_count;
+                shrinks.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Set the elastic policy and switch to elastic mode. Must only be called while there are no threads.
+     *
+     * @param elastic_policy_ The elastic policy. The bounds are clamped so that 1 <= min_threads <= max_threads.
+     */
+    void set_elastic_policy(const elastic_policy& elastic_policy_)
+    {
+        elastic_settings = elastic_policy_;
+        elastic_settings.max_threads = determine_thread_count(elastic_policy_.max_threads);
+        elastic_settings.min_threads = std::clamp<concurrency_t>(elastic_policy_.min_threads, 1, elastic_settings.max_threads);
+        elastic_mode = true;
+    }
+
+    /**
+     * @brief Wrap a task so that it records how long it waited in the queue and how long it ran into the histograms of the worker that runs it.
+     *
+     * @tparam F The type of the task.
+     * @param task The task.
+     * @return The wrapped task.
+     */
+    template <typename F>
+    [[nodiscard]] static inline_task instrument_task(F&& task)
+    {
+        return inline_task(
+            [pushed = std::chrono::steady_clock::now(), task = std::forward<F>(task)]() mutable
+            {
+                const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+                std::invoke(task);
+                const std::chrono::steady_clock::time_point finished = std::chrono::steady_clock::now();
+                if (current_worker_statistics)
+                {
+                    current_worker_statistics->wait_time.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(started - pushed).count()));
+                    current_worker_statistics->run_time.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(finished - started).count()));
+                }
+            });
+    }
+
+    /**
+     * @brief Sample the queue depth until instrumentation is disabled. Keeps at most max_depth_samples samples, dropping the oldest.
+     *
+     * @param sample_interval How often to sample.
+     */
+    void sample_queue_depth(const std::chrono::microseconds sample_interval)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> sampler_lock(sampler_mutex);
+        do
+        {
+            queue_depth_sample sample;
+            sample.time_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            sample.tasks_queued = tasks_queued;
+            sample.tasks_running = get_tasks_running();
+            sample.thread_count = thread_count;
+            const std::scoped_lock statistics_lock(statistics_mutex);
+            if (depth_samples.size() == max_depth_samples)
+                depth_samples.pop_front();
+            depth_samples.push_back(sample);
+        } while (!sampler_cv.wait_for(sampler_lock, sample_interval, [this] { return !instrumented; }));
+    }
+
+    /**
+     * @brief Check whether wait_for_tasks() can stop waiting.
+     *
+     * @return true if there are no unfinished tasks, or, if the pool is paused, if no tasks are running.
+     */
+    [[nodiscard]] bool tasks_done() const
+    {
+        return tasks_total == (paused ? tasks_queued.load() : 0);
+    }
+
+    /**
+     * @brief Check whether an idle worker should stop waiting.
+     *
+     * @return true if there is a task the worker is allowed to take, or if the pool is shutting down.
+     */
+    [[nodiscard]] bool worker_has_work() const
+    {
+        return (tasks_queued > 0 && !paused) || !running;
+    }
+
+    /**
+     * @brief Wait for a task to become available, following the idle policy: spin, then yield, then park on task_available_cv. The counts are added to the shared statistics once at the end, so that spinning workers don't fight over their cache lines. In elastic mode, a parked worker retires once it has been idle for the idle timeout.
+     *
+     * @return true if the worker should keep running, false if it retired.
+     */
+    bool wait_for_work()
+    {
+        size_t spun = 0;
+        size_t yielded = 0;
+        const size_t spin_limit = spin_count.load(std::memory_order_relaxed);
+        while (spun < spin_limit && !worker_has_work())
+        {
+            cpu_relax();
+            ++spun;
+        }
+        if (spun == spin_limit)
+        {
+            const size_t yield_limit = yield_count.load(std::memory_order_relaxed);
+            while (yielded < yield_limit && !worker_has_work())
+            {
+                std::this_thread::yield();
+                ++yielded;
+            }
+        }
+        if (spun)
+            spins.fetch_add(spun, std::memory_order_relaxed);
+        if (yielded)
+            yields.fetch_add(yielded, std::memory_order_relaxed);
+        if (worker_has_work())
+            return true;
+
+        // tasks_queued is counted before a task is actually in the queue, so only park if there really is nothing to do
+        std::unique_lock<std::mutex> tasks_lock(tasks_mutex);
+        ++sleeping;
+        if (!worker_has_work())
+        {
+            parks.fetch_add(1, std::memory_order_relaxed);
+            if (elastic_mode)
+            {
+                while (!task_available_cv.wait_for(tasks_lock, elastic_settings.idle_timeout, [this] { return worker_has_work(); }))
+                {
+                    // Stop counting as sleeping before the final check, so a task pushed after it wakes someone else
+                    --sleeping;
+                    if (!worker_has_work() && retire_worker())
+                        return false;
+                    ++sleeping;
+                }
+            }
+            else
+            {
+                task_available_cv.wait(tasks_lock, [this] { return worker_has_work(); });
+            }
+        }
+        --sleeping;
+        return true;
+    }
+
+    /**
+     * @brief Give the calling worker a slot for its histograms, reusing one left by a worker that exited if there is one.
+     */
+    void acquire_worker_statistics()
+    {
+        const std::scoped_lock statistics_lock(statistics_mutex);
+        const auto free_slot = std::find_if(worker_histograms.begin(), worker_histograms.end(), [](const worker_statistics& statistics) { return !statistics.in_use; });
+        current_worker_statistics = free_slot != worker_histograms.end() ? &*free_slot : &worker_histograms.emplace_back();
+        current_worker_statistics->in_use = true;
+    }
+
+    /**
+     * @brief Fold the histograms of the calling worker into retired_statistics and free its slot for the next worker, so that an elastic pool that keeps adding and retiring workers doesn't keep adding slots.
+     */
+    void release_worker_statistics()
+    {
+        const std::scoped_lock statistics_lock(statistics_mutex);
+        retired_statistics.wait_time.merge(current_worker_statistics->wait_time);
+        retired_statistics.run_time.merge(current_worker_statistics->run_time);
+        current_worker_statistics->clear();
+        current_worker_statistics->in_use = false;
+        current_worker_statistics = nullptr;
+    }
+
+    /**
+     * @brief A worker function to be assigned to each thread in the pool. Keeps retrieving tasks from the queue and executing them, and waits for more according to the idle policy whenever the queue is empty. Once a task finishes, the worker notifies wait_for_tasks() in case it is waiting.
      */
     void worker()
     {
-        while (running)
+        acquire_worker_statistics();
+        inline_task task;
+        while (true)
         {
-            std::function<void()> task;
-            std::unique_lock<std::mutex> tasks_lock(tasks_mutex);
-            task_available_cv.wait(tasks_lock, [this] { return !tasks.empty() || !running; });
-            if (running && !paused)
+            if (!paused && tasks.try_pop(task))
             {
-                task = std::move(tasks.front());
-                tasks.pop();
-                tasks_lock.unlock();
+                --tasks_queued;
+                if (elastic_mode)
+                    last_dequeue_time.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
                 task();
-                tasks_lock.lock();
+                task = inline_task();
                 --tasks_total;
                 if (waiting)
+                {
+                    const std::scoped_lock tasks_lock(tasks_mutex);
                     task_done_cv.notify_one();
+                }
+                continue;
             }
+
+            if (!running || !wait_for_work())
+                break;
         }
+        release_worker_statistics();
     }
 
     // ============
@@ -663,7 +2246,12 @@ private:
     /**
      * @brief A queue of tasks to be executed by the threads.
      */
-    std::queue<std::function<void()>> tasks = {};
+    Queue tasks = {};
+
+    /**
+     * @brief An atomic variable to keep track of the number of tasks that have been pushed but not yet retrieved by a worker.
+     */
+    std::atomic<size_t> tasks_queued = 0;
 
     /**
      * @brief An atomic variable to keep track of the total number of unfinished tasks - either still in the queue, or running in a thread.
@@ -671,19 +2259,176 @@ private:
     std::atomic<size_t> tasks_total = 0;
 
     /**
-     * @brief A mutex to synchronize access to the task queue by different threads.
+     * @brief The number of workers currently waiting on task_available_cv, so that push_task() only has to take the lock when someone needs waking.
+     */
+    std::atomic<size_t> sleeping = 0;
+
+    /**
+     * @brief The number of times an idle worker checks for new tasks while spinning. See idle_policy.
+     */
+    std::atomic<size_t> spin_count = 0;
+
+    /**
+     * @brief The number of times an idle worker yields before parking. See idle_policy.
+     */
+    std::atomic<size_t> yield_count = 0;
+
+    /**
+     * @brief Counters for get_idle_stats().
+     */
+    std::atomic<size_t> spins = 0, yields = 0, parks = 0, wakes = 0;
+
+    /**
+     * @brief A mutex used together with task_available_cv and task_done_cv. The queue synchronizes itself.
      */
     mutable std::mutex tasks_mutex = {};
 
     /**
      * @brief The number of threads in the pool.
      */
-    concurrency_t thread_count = 0;
+    std::atomic<concurrency_t> thread_count = 0;
+
+    /**
+     * @brief The threads of the workers in the pool.
+     */
+    std::vector<std::thread> threads = {};
+
+    /**
+     * @brief The threads of workers that retired themselves in elastic mode, waiting to be joined.
+     */
+    std::vector<std::thread> retired_threads = {};
+
+    /**
+     * @brief A mutex to synchronize adding and removing threads in elastic mode.
+     */
+    std::mutex threads_mutex = {};
+
+    /**
+     * @brief Whether the pool resizes itself. Only changed while there are no threads.
+     */
+    std::atomic<bool> elastic_mode = false;
+
+    /**
+     * @brief The elastic policy, if in elastic mode. Only changed while there are no threads.
+     */
+    elastic_policy elastic_settings = {};
+
+    /**
+     * @brief The time a worker last took a task out of the queue, as a count of std::chrono::steady_clock ticks. Only updated in elastic mode.
+     */
+    std::atomic<std::chrono::steady_clock::rep> last_dequeue_time = 0;
+
+    /**
+     * @brief A thread that adds workers when tasks wait too long, only running in elastic mode.
+     */
+    std::thread monitor_thread = {};
+
+    /**
+     * @brief A condition variable used to stop the monitor thread.
+     */
+    std::condition_variable monitor_cv = {};
+
+    /**
+     * @brief A mutex used together with monitor_cv.
+     */
+    std::mutex monitor_mutex = {};
+
+    /**
+     * @brief The histograms of one worker. Only that worker records into them.
+     */
+    struct worker_statistics
+    {
+        latency_histogram wait_time;
+        latency_histogram run_time;
+
+        /**
+         * @brief Whether a worker currently owns these histograms. Slots of workers that exited are reused.
+         */
+        bool in_use = false;
+
+        /**
+         * @brief Reset both histograms to zero.
+         */
+        void clear()
+        {
+            wait_time.clear();
+            run_time.clear();
+        }
+
+        /**
+         * @brief Write both histograms as a JSON object.
+         *
+         * @param out The stream to write to.
+         */
+        void write_json(std::ostream& out) const
+        {
+            out << "{\"wait_time_ns\": ";
+            wait_time.write_json(out);
+            out << ", \"run_time_ns\": ";
+            run_time.write_json(out);
+            out << "}";
+        }
+    };
+
+    /**
+     * @brief The maximum number of queue depth samples to keep.
+     */
+    static constexpr size_t max_depth_samples = 100000;
+
+    /**
+     * @brief One slot of histograms per worker, never more than the most workers the pool has had at once. A deque, so that adding a slot doesn't move the histograms of the others.
+     */
+    std::deque<worker_statistics> worker_histograms = {};
+
+    /**
+     * @brief The histograms of every worker that has exited, merged together.
+     */
+    worker_statistics retired_statistics = {};
+
+    /**
+     * @brief The histograms of the worker running on the current thread, if any.
+     */
+    inline static thread_local worker_statistics* current_worker_statistics = nullptr;
+
+    /**
+     * @brief The queue depth samples, oldest first.
+     */
+    std::deque<queue_depth_sample> depth_samples = {};
+
+    /**
+     * @brief A mutex to synchronize adding histograms and samples with reading them.
+     */
+    mutable std::mutex statistics_mutex = {};
+
+    /**
+     * @brief Whether instrumentation is enabled.
+     */
+    std::atomic<bool> instrumented = false;
+
+    /**
+     * @brief A thread that samples the queue depth while instrumentation is enabled.
+     */
+    std::thread sampler_thread = {};
+
+    /**
+     * @brief A condition variable used to stop the sampler thread.
+     */
+    std::condition_variable sampler_cv = {};
+
+    /**
+     * @brief A mutex used together with sampler_cv.
+     */
+    std::mutex sampler_mutex = {};
+
+    /**
+     * @brief Counters for get_elastic_stats().
+     */
+    std::atomic<size_t> grows_for_depth = 0, grows_for_wait = 0, shrinks = 0;
 
     /**
-     * @brief A smart pointer to manage the memory allocated for the threads.
+     * @brief The largest number of threads the pool has had at once, for get_elastic_stats().
      */
-    std::unique_ptr<std::thread[]> threads = nullptr;
+    std::atomic<concurrency_t> peak_threads = 0;
 
     /**
      * @brief An atomic variable indicating that wait_for_tasks() is active and expects to be notified whenever a task is done.
@@ -691,7 +2436,17 @@ private:
     std::atomic<bool> waiting = false;
 };
 
-//                                     End class thread_pool                                     //
+/**
+ * @brief A thread pool with the default mutex-protected task queue.
+ */
+using thread_pool = basic_thread_pool<locked_task_queue>;
+
+/**
+ * @brief A thread pool with a bounded lock-free task queue.
+ */
+using lock_free_thread_pool = basic_thread_pool<mpmc_task_queue<>>;
+
+//                                  End class basic_thread_pool                                  //
 // ============================================================================================= //
 
 // ============================================================================================= //
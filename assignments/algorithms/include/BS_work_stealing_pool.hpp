@@ -0,0 +1,859 @@
+#pragma once
+
+/**
+ * @file BS_work_stealing_pool.hpp
+ *
+ * @brief BS::work_stealing_pool: a drop-in alternative to BS::thread_pool that gives every worker its own Chase-Lev deque instead of sharing one mutex-protected queue. Tasks pushed from inside a worker go to that worker's deque, and idle workers steal from randomly chosen victims. Tasks pushed from outside the pool go through a shared injection queue, which workers drain in batches into their own deques. Exposes the same API as BS::thread_pool, and reuses its helper classes BS::multi_future and BS::blocks.
+ *
+ * @cite David Chase & Yossi Lev, Dynamic Circular Work-Stealing Deque, (2005), SPAA '05
+ * @cite Nhat Minh Lê, Antoniu Pop, Albert Cohen & Francesco Zappa Nardelli, Correct and Efficient Work-Stealing for Weak Memory Models, (2013), PPoPP '13
+ */
+
+#include <algorithm>          // std::min
+#include <atomic>             // std::atomic, std::atomic_thread_fence
+#include <chrono>             // std::chrono
+#include <condition_variable> // std::condition_variable
+#include <cstdint>            // std::int64_t, std::uint64_t
+#include <deque>              // std::deque
+#include <exception>          // std::current_exception
+#include <functional>         // std::bind, std::function, std::invoke
+#include <future>             // std::future, std::promise
+#include <memory>             // std::make_shared, std::make_unique, std::shared_ptr, std::unique_ptr
+#include <mutex>              // std::mutex, std::scoped_lock, std::unique_lock
+#include <thread>             // std::thread
+#include <type_traits>        // std::common_type_t, std::decay_t, std::invoke_result_t, std::is_void_v
+#include <utility>            // std::forward, std::move
+#include <vector>             // std::vector
+
+#include "BS_thread_pool.hpp"
+
+namespace BS
+{
+// ============================================================================================= //
+//                                Begin class work_stealing_deque                                //
+
+/**
+ * @brief A Chase-Lev work-stealing deque of pointers. The owning thread pushes and pops at the bottom without any locks, while any other thread can steal from the top with a single compare-and-swap. The underlying circular array grows when it is full. Old arrays are kept until the deque is destroyed, since a thief may still be reading from one.
+ *
+ * @tparam T The type pointed to by the stored pointers.
+ */
+template <typename T>
+class [[nodiscard]] work_stealing_deque
+{
+public:
+    /**
+     * @brief Construct an empty deque.
+     *
+     * @param capacity_ The initial capacity of the deque. Must be a power of two.
+     */
+    work_stealing_deque(const size_t capacity_ = 256)
+    {
+        arrays.push_back(std::make_unique<ring>(capacity_));
+        array = arrays.back().get();
+    }
+
+    /**
+     * @brief Push an item onto the bottom of the deque. Must only be called by the owning thread.
+     *
+     * @param item The item to push.
+     */
+    void push(T* item)
+    {
+        const std::int64_t b = bottom.load(std::memory_order_relaxed);
+        const std::int64_t t = top.load(std::memory_order_acquire);
+        ring* a = array.load(std::memory_order_relaxed);
+        if (b - t > static_cast<std::int64_t>(a->capacity) - 1)
+        {
+            a = grow(a, b, t);
+        }
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Pop an item from the bottom of the deque. Must only be called by the owning thread.
+     *
+     * @return The most recently pushed item, or nullptr if the deque is empty or the last item was stolen first.
+     */
+    [[nodiscard]] T* pop()
+    {
+        const std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        ring* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T* item = a->get(b);
+        if (t == b)
+        {
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /**
+     * @brief Steal an item from the top of the deque. Can be called by any thread.
+     *
+     * @return The oldest item in the deque, or nullptr if the deque is empty or another thread took the item first.
+     */
+    [[nodiscard]] T* steal()
+    {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+        T* item = array.load(std::memory_order_acquire)->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return item;
+    }
+
+    /**
+     * @brief Get an estimate of the number of items in the deque. Only exact when no other thread is using the deque.
+     *
+     * @return The number of items.
+     */
+    [[nodiscard]] size_t size() const
+    {
+        const std::int64_t b = bottom.load(std::memory_order_relaxed);
+        const std::int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+private:
+    /**
+     * @brief A fixed-size circular array of atomic pointers, indexed by the ever-increasing top and bottom positions.
+     */
+    struct ring
+    {
+        ring(const size_t capacity_) : capacity(capacity_), mask(capacity_ - 1), slots(std::make_unique<std::atomic<T*>[]>(capacity_)) {}
+
+        [[nodiscard]] T* get(const std::int64_t i) const
+        {
+            return slots[static_cast<size_t>(i) & mask].load(std::memory_order_relaxed);
+        }
+
+        void put(const std::int64_t i, T* item)
+        {
+            slots[static_cast<size_t>(i) & mask].store(item, std::memory_order_relaxed);
+        }
+
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+    };
+
+    /**
+     * @brief Replace the array with one twice as large, copying over the items between top and bottom.
+     *
+     * @param old_array The current array.
+     * @param b The current bottom position.
+     * @param t The current top position.
+     * @return The new array.
+     */
+    ring* grow(ring* old_array, const std::int64_t b, const std::int64_t t)
+    {
+        arrays.push_back(std::make_unique<ring>(old_array->capacity * 2));
+        ring* new_array = arrays.back().get();
+        for (std::int64_t i = t; i < b; ++i)
+            new_array->put(i, old_array->get(i));
+        array.store(new_array, std::memory_order_release);
+        return new_array;
+    }
+
+    /**
+     * @brief The position of the next item to steal. Kept on its own cache line, since thieves write to it.
+     */
+    alignas(64) std::atomic<std::int64_t> top = 0;
+
+    /**
+     * @brief The position after the most recently pushed item. Only written to by the owning thread.
+     */
+    alignas(64) std::atomic<std::int64_t> bottom = 0;
+
+    /**
+     * @brief The array currently in use.
+     */
+    std::atomic<ring*> array = nullptr;
+
+    /**
+     * @brief Every array the deque has used, so that arrays which thieves may still be reading are not freed early. Only touched by the owning thread.
+     */
+    std::vector<std::unique_ptr<ring>> arrays = {};
+};
+
+//                                 End class work_stealing_deque                                 //
+// ============================================================================================= //
+
+// ============================================================================================= //
+//                                Begin class work_stealing_pool                                 //
+
+/**
+ * @brief A thread pool with one work-stealing deque per worker. Has the same interface as BS::thread_pool, so the two can be swapped freely.
+ */
+class [[nodiscard]] work_stealing_pool
+{
+public:
+    // ============================
+    // Constructors and destructors
+    // ============================
+
+    /**
+     * @brief Construct a new work-stealing pool.
+     *
+     * @param thread_count_ The number of threads to use. The default value is the total number of hardware threads available, as reported by the implementation.
+     */
+    work_stealing_pool(const concurrency_t thread_count_ = 0) : thread_count(determine_thread_count(thread_count_))
+    {
+        create_threads();
+    }
+
+    /**
+     * @brief Destruct the pool. Waits for all tasks to complete, then destroys all threads. If the pool is paused, then any tasks still queued are discarded without being executed.
+     */
+    ~work_stealing_pool()
+    {
+        wait_for_tasks();
+        destroy_threads();
+        for (task_type* task : drain_deques())
+            delete task;
+        for (task_type* task : injected_tasks)
+            delete task;
+    }
+
+    // =======================
+    // Public member functions
+    // =======================
+
+    /**
+     * @brief Get the number of tasks currently waiting in the injection queue or the workers' deques.
+     *
+     * @return The number of queued tasks.
+     */
+    [[nodiscard]] size_t get_tasks_queued() const
+    {
+        return tasks_queued;
+    }
+
+    /**
+     * @brief Get the number of tasks currently being executed by the threads.
+     *
+     * @return The number of running tasks.
+     */
+    [[nodiscard]] size_t get_tasks_running() const
+    {
+        return tasks_total - tasks_queued;
+    }
+
+    /**
+     * @brief Get the total number of unfinished tasks: either still queued, or running in a thread.
+     *
+     * @return The total number of tasks.
+     */
+    [[nodiscard]] size_t get_tasks_total() const
+    {
+        return tasks_total;
+    }
+
+    /**
+     * @brief Get the number of threads in the pool.
+     *
+     * @return The number of threads.
+     */
+    [[nodiscard]] concurrency_t get_thread_count() const
+    {
+        return thread_count;
+    }
+
+    /**
+     * @brief Check whether the pool is currently paused.
+     *
+     * @return true if the pool is paused, false if it is not paused.
+     */
+    [[nodiscard]] bool is_paused() const
+    {
+        return paused;
+    }
+
+    /**
+     * @brief Parallelize a loop by automatically splitting it into blocks and submitting each block separately. See BS::thread_pool::parallelize_loop().
+     *
+     * @tparam F The type of the function to loop through.
+     * @tparam T1 The type of the first index in the loop. Should be a signed or unsigned integer.
+     * @tparam T2 The type of the index after the last index in the loop. Should be a signed or unsigned integer. If T1 is not the same as T2, a common type will be automatically inferred.
+     * @tparam T The common type of T1 and T2.
+     * @tparam R The return value of the loop function F (can be void).
+     * @param first_index The first index in the loop.
+     * @param index_after_last The index after the last index in the loop.
+     * @param loop The function to loop through. Will be called once per block with the first index in the block and the index after the last index in the block.
+     * @param num_blocks The maximum number of blocks to split the loop into. The default is to use the number of threads in the pool.
+     * @return A multi_future object that can be used to wait for all the blocks to finish, and obtain their results if the loop function returns a value.
+     */
+    template <typename F, typename T1, typename T2, typename T = std::common_type_t<T1, T2>, typename R = std::invoke_result_t<std::decay_t<F>, T, T>>
+    [[nodiscard]] multi_future<R> parallelize_loop(const T1 first_index, const T2 index_after_last, F&& loop, const size_t num_blocks = 0)
+    {
+        blocks blks(first_index, index_after_last, num_blocks ? num_blocks : thread_count);
+        if (blks.get_total_size() > 0)
+        {
+            multi_future<R> mf(blks.get_num_blocks());
+            for (size_t i = 0; i < blks.get_num_blocks(); ++i)
+                mf[i] = submit(std::forward<F>(loop), blks.start(i), blks.end(i));
+            return mf;
+        }
+        else
+        {
+            return multi_future<R>();
+        }
+    }
+
+    /**
+     * @brief Parallelize a loop by automatically splitting it into blocks and submitting each block separately. This overload is used for the special case where the first index is 0.
+     *
+     * @tparam F The type of the function to loop through.
+     * @tparam T The type of the loop indices. Should be a signed or unsigned integer.
+     * @tparam R The return value of the loop function F (can be void).
+     * @param index_after_last The index after the last index in the loop.
+     * @param loop The function to loop through. Will be called once per block with the first index in the block and the index after the last index in the block.
+     * @param num_blocks The maximum number of blocks to split the loop into. The default is to use the number of threads in the pool.
+     * @return A multi_future object that can be used to wait for all the blocks to finish, and obtain their results if the loop function returns a value.
+     */
+    template <typename F, typename T, typename R = std::invoke_result_t<std::decay_t<F>, T, T>>
+    [[nodiscard]] multi_future<R> parallelize_loop(const T index_after_last, F&& loop, const size_t num_blocks = 0)
+    {
+        return parallelize_loop(0, index_after_last, std::forward<F>(loop), num_blocks);
+    }
+
+    /**
+     * @brief Pause the pool. The workers will temporarily stop taking new tasks, although any tasks already executed will keep running until they are finished.
+     */
+    void pause()
+    {
+        paused = true;
+    }
+
+    /**
+     * @brief Parallelize a loop by automatically splitting it into blocks and pushing each block separately. Does not return a multi_future, so the user must use wait_for_tasks() to ensure that the loop finishes executing.
+     *
+     * @tparam F The type of the function to loop through.
+     * @tparam T1 The type of the first index in the loop. Should be a signed or unsigned integer.
+     * @tparam T2 The type of the index after the last index in the loop. Should be a signed or unsigned integer. If T1 is not the same as T2, a common type will be automatically inferred.
+     * @tparam T The common type of T1 and T2.
+     * @param first_index The first index in the loop.
+     * @param index_after_last The index after the last index in the loop.
+     * @param loop The function to loop through. Will be called once per block with the first index in the block and the index after the last index in the block.
+     * @param num_blocks The maximum number of blocks to split the loop into. The default is to use the number of threads in the pool.
+     */
+    template <typename F, typename T1, typename T2, typename T = std::common_type_t<T1, T2>>
+    void push_loop(const T1 first_index, const T2 index_after_last, F&& loop, const size_t num_blocks = 0)
+    {
+        blocks blks(first_index, index_after_last, num_blocks ? num_blocks : thread_count);
+        if (blks.get_total_size() > 0)
+        {
+            for (size_t i = 0; i < blks.get_num_blocks(); ++i)
+                push_task(std::forward<F>(loop), blks.start(i), blks.end(i));
+        }
+    }
+
+    /**
+     * @brief Parallelize a loop by automatically splitting it into blocks and pushing each block separately. This overload is used for the special case where the first index is 0.
+     *
+     * @tparam F The type of the function to loop through.
+     * @tparam T The type of the loop indices. Should be a signed or unsigned integer.
+     * @param index_after_last The index after the last index in the loop.
+     * @param loop The function to loop through. Will be called once per block with the first index in the block and the index after the last index in the block.
+     * @param num_blocks The maximum number of blocks to split the loop into. The default is to use the number of threads in the pool.
+     */
+    template <typename F, typename T>
+    void push_loop(const T index_after_last, F&& loop, const size_t num_blocks = 0)
+    {
+        push_loop(0, index_after_last, std::forward<F>(loop), num_blocks);
+    }
+
+    /**
+     * @brief Push a function with zero or more arguments, but no return value, into the pool. If called from one of the pool's own workers, the task goes onto that worker's deque without taking any lock. Otherwise it goes into the injection queue. Does not return a future, so the user must use wait_for_tasks() to ensure that the task finishes executing.
+     *
+     * @tparam F The type of the function.
+     * @tparam A The types of the arguments.
+     * @param task The function to push.
+     * @param args The zero or more arguments to pass to the function.
+     */
+    template <typename F, typename... A>
+    void push_task(F&& task, A&&... args)
+    {
+        task_type* task_function = new task_type(std::bind(std::forward<F>(task), std::forward<A>(args)...));
+        ++tasks_total;
+        ++tasks_queued;
+        if (current_pool == this)
+        {
+            deques[current_worker]->push(task_function);
+        }
+        else
+        {
+            const std::scoped_lock injection_lock(injection_mutex);
+            injected_tasks.push_back(task_function);
+        }
+        wake_one();
+    }
+
+    /**
+     * @brief Reset the number of threads in the pool. Waits for all currently running tasks to be completed, then destroys all threads and creates new ones. Any tasks that were still queued are moved into the injection queue and executed by the new threads. If the pool was paused before resetting it, the new pool will be paused as well.
+     *
+     * @param thread_count_ The number of threads to use. The default value is the total number of hardware threads available, as reported by the implementation.
+     */
+    void reset(const concurrency_t thread_count_ = 0)
+    {
+        const bool was_paused = paused;
+        paused = true;
+        wait_for_tasks();
+        destroy_threads();
+        {
+            const std::scoped_lock injection_lock(injection_mutex);
+            for (task_type* task : drain_deques())
+                injected_tasks.push_back(task);
+        }
+        thread_count = determine_thread_count(thread_count_);
+        paused = was_paused;
+        create_threads();
+    }
+
+    /**
+     * @brief Submit a function with zero or more arguments into the pool. If the function has a return value, get a future for the eventual returned value. If the function has no return value, get an std::future<void> which can be used to wait until the task finishes.
+     *
+     * @tparam F The type of the function.
+     * @tparam A The types of the zero or more arguments to pass to the function.
+     * @tparam R The return type of the function (can be void).
+     * @param task The function to submit.
+     * @param args The zero or more arguments to pass to the function.
+     * @return A future to be used later to wait for the function to finish executing and/or obtain its returned value if it has one.
+     */
+    template <typename F, typename... A, typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>
+    [[nodiscard]] std::future<R> submit(F&& task, A&&... args)
+    {
+        std::function<R()> task_function = std::bind(std::forward<F>(task), std::forward<A>(args)...);
+        std::shared_ptr<std::promise<R>> task_promise = std::make_shared<std::promise<R>>();
+        push_task(
+            [task_function, task_promise]
+            {
+                try
+                {
+                    if constexpr (std::is_void_v<R>)
+                    {
+                        std::invoke(task_function);
+                        task_promise->set_value();
+                    }
+                    else
+                    {
+                        task_promise->set_value(std::invoke(task_function));
+                    }
+                }
+                catch (...)
+                {
+                    try
+                    {
+                        task_promise->set_exception(std::current_exception());
+                    }
+                    catch (...)
+                    {
+                    }
+                }
+            });
+        return task_promise->get_future();
+    }
+
+    /**
+     * @brief Submit a function with zero or more arguments into the pool, and add its result to a completion queue once it finishes instead of returning a future.
+     *
+     * @tparam F The type of the function.
+     * @tparam A The types of the zero or more arguments to pass to the function.
+     * @tparam R The return type of the function (can be void).
+     * @param queue The completion queue to add the result to. Must outlive the task.
+     * @param tag The tag to add the result with.
+     * @param task The function to submit.
+     * @param args The zero or more arguments to pass to the function.
+     */
+    template <typename F, typename... A, typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>
+    void submit_to(completion_queue<R>& queue, const size_t tag, F&& task, A&&... args)
+    {
+        std::function<R()> task_function = std::bind(std::forward<F>(task), std::forward<A>(args)...);
+        push_task(
+            [task_function, &queue, tag]
+            {
+                queue.complete(tag, task_function);
+            });
+    }
+
+    /**
+     * @brief Unpause the pool. The workers will resume taking tasks.
+     */
+    void unpause()
+    {
+        paused = false;
+        const std::scoped_lock sleep_lock(sleep_mutex);
+        task_available_cv.notify_all();
+    }
+
+    /**
+     * @brief Wait for tasks to be completed. Normally, this function waits for all tasks, both those that are currently running in the threads and those that are still queued. However, if the pool is paused, this function only waits for the currently running tasks. Must not be called from inside one of the pool's own tasks.
+     */
+    void wait_for_tasks()
+    {
+        if (!waiting)
+        {
+            waiting = true;
+            std::unique_lock<std::mutex> done_lock(done_mutex);
+            task_done_cv.wait(done_lock, [this] { return tasks_done(); });
+            waiting = false;
+        }
+    }
+
+    /**
+     * @brief Wait for tasks to be completed, but stop waiting after the specified duration has passed.
+     *
+     * @tparam R An arithmetic type representing the number of ticks to wait.
+     * @tparam P An std::ratio representing the length of each tick in seconds.
+     * @param duration The time duration to wait.
+     * @return true if finished waiting before the duration expired, false if timed out or the pool is already waiting.
+     */
+    template <typename R, typename P>
+    bool wait_for_tasks_duration(const std::chrono::duration<R, P>& duration)
+    {
+        if (!waiting)
+        {
+            waiting = true;
+            std::unique_lock<std::mutex> done_lock(done_mutex);
+            const bool status = task_done_cv.wait_for(done_lock, duration, [this] { return tasks_done(); });
+            waiting = false;
+            return status;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Wait for tasks to be completed, but stop waiting after the specified time point has been reached.
+     *
+     * @tparam C The type of the clock used to measure time.
+     * @tparam D An std::chrono::duration type used to indicate the time point.
+     * @param timeout_time The time point at which to stop waiting.
+     * @return true if finished waiting before the time point was reached, false if timed out or the pool is already waiting.
+     */
+    template <typename C, typename D>
+    bool wait_for_tasks_until(const std::chrono::time_point<C, D>& timeout_time)
+    {
+        if (!waiting)
+        {
+            waiting = true;
+            std::unique_lock<std::mutex> done_lock(done_mutex);
+            const bool status = task_done_cv.wait_until(done_lock, timeout_time, [this] { return tasks_done(); });
+            waiting = false;
+            return status;
+        }
+        return false;
+    }
+
+private:
+    /**
+     * @brief The type of a task as stored in the queues. Tasks are heap-allocated so that the deques only have to move pointers around.
+     */
+    using task_type = std::function<void()>;
+
+    /**
+     * @brief The maximum number of tasks a worker moves from the injection queue into its own deque at once, where the other workers can steal them.
+     */
+    static constexpr size_t injection_batch_size = 32;
+
+    // ========================
+    // Private member functions
+    // ========================
+
+    /**
+     * @brief Create one deque per thread, then create the threads and assign a worker to each.
+     */
+    void create_threads()
+    {
+        running = true;
+        deques.clear();
+        for (concurrency_t i = 0; i < thread_count; ++i)
+            deques.push_back(std::make_unique<work_stealing_deque<task_type>>());
+        threads = std::make_unique<std::thread[]>(thread_count);
+        for (concurrency_t i = 0; i < thread_count; ++i)
+        {
+            threads[i] = std::thread(&work_stealing_pool::worker, this, i);
+        }
+    }
+
+    /**
+     * @brief Destroy the threads in the pool. The deques are kept, since they may still hold tasks if the pool is paused.
+     */
+    void destroy_threads()
+    {
+        running = false;
+        {
+            const std::scoped_lock sleep_lock(sleep_mutex);
+            task_available_cv.notify_all();
+        }
+        for (concurrency_t i = 0; i < thread_count; ++i)
+        {
+            threads[i].join();
+        }
+    }
+
+    /**
+     * @brief Determine how many threads the pool should have. See BS::thread_pool.
+     *
+     * @param thread_count_ The parameter passed to the constructor or reset().
+     * @return The number of threads to use for constructing the pool.
+     */
+    [[nodiscard]] concurrency_t determine_thread_count(const concurrency_t thread_count_)
+    {
+        if (thread_count_ > 0)
+            return thread_count_;
+        else
+        {
+            if (std::thread::hardware_concurrency() > 0)
+                return std::thread::hardware_concurrency();
+            else
+                return 1;
+        }
+    }
+
+    /**
+     * @brief Take every task left in the workers' deques. Must only be called while no workers are running.
+     *
+     * @return The tasks, oldest first within each deque.
+     */
+    [[nodiscard]] std::vector<task_type*> drain_deques()
+    {
+        std::vector<task_type*> drained;
+        for (auto& deque : deques)
+        {
+            while (deque->size() > 0)
+            {
+                if (task_type* task = deque->steal())
+                    drained.push_back(task);
+            }
+        }
+        return drained;
+    }
+
+    /**
+     * @brief Find a task for a worker to run: first from its own deque, then from the injection queue, then by stealing from the other workers starting at a random victim.
+     *
+     * @param index The index of the worker.
+     * @return The task, or nullptr if none could be found.
+     */
+    [[nodiscard]] task_type* find_task(const concurrency_t index)
+    {
+        if (task_type* task = deques[index]->pop())
+            return task;
+
+        if (task_type* task = take_injected_tasks(index))
+            return task;
+
+        // xorshift is plenty for picking victims, and keeps every worker on its own sequence without any locking
+        thread_local std::uint64_t rng_state = std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+        rng_state ^= rng_state << 13;
+        rng_state ^= rng_state >> 7;
+        rng_state ^= rng_state << 17;
+        const concurrency_t first_victim = static_cast<concurrency_t>(rng_state % thread_count);
+        for (concurrency_t i = 0; i < thread_count; ++i)
+        {
+            const concurrency_t victim = (first_victim + i) % thread_count;
+            if (victim == index)
+                continue;
+            if (task_type* task = deques[victim]->steal())
+                return task;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Take a batch of tasks out of the injection queue. One is returned to be run right away, and the rest are pushed onto the worker's own deque so that idle workers can steal them.
+     *
+     * @param index The index of the worker.
+     * @return The first task of the batch, or nullptr if the injection queue is empty.
+     */
+    [[nodiscard]] task_type* take_injected_tasks(const concurrency_t index)
+    {
+        const std::scoped_lock injection_lock(injection_mutex);
+        if (injected_tasks.empty())
+            return nullptr;
+
+        // Leave some for the other workers instead of taking everything at once
+        const size_t batch_size = std::min(injection_batch_size, (injected_tasks.size() + thread_count - 1) / thread_count);
+        task_type* first_task = injected_tasks.front();
+        injected_tasks.pop_front();
+        for (size_t i = 1; i < batch_size; ++i)
+        {
+            deques[index]->push(injected_tasks.front());
+            injected_tasks.pop_front();
+        }
+        return first_task;
+    }
+
+    /**
+     * @brief Check whether wait_for_tasks() can stop waiting.
+     *
+     * @return true if there are no unfinished tasks, or, if the pool is paused, if no tasks are running.
+     */
+    [[nodiscard]] bool tasks_done() const
+    {
+        return tasks_total == (paused ? tasks_queued.load() : 0);
+    }
+
+    /**
+     * @brief Wake up one sleeping worker, if there are any. Only takes the lock when a worker is actually asleep.
+     */
+    void wake_one()
+    {
+        if (sleeping > 0)
+        {
+            const std::scoped_lock sleep_lock(sleep_mutex);
+            task_available_cv.notify_one();
+        }
+    }
+
+    /**
+     * @brief A worker function to be assigned to each thread in the pool. Keeps finding and running tasks, and only goes to sleep when no task could be found anywhere. Once a task finishes, the worker notifies wait_for_tasks() in case it is waiting.
+     *
+     * @param index The index of the worker, which is also the index of its deque.
+     */
+    void worker(const concurrency_t index)
+    {
+        current_pool = this;
+        current_worker = index;
+        while (true)
+        {
+            task_type* task = paused ? nullptr : find_task(index);
+            if (task && paused)
+            {
+                // The pool was paused while the task was being found, so put it back instead of running it
+                deques[index]->push(task);
+                task = nullptr;
+            }
+            if (task)
+            {
+                --tasks_queued;
+                (*task)();
+                delete task;
+                --tasks_total;
+                if (waiting)
+                {
+                    const std::scoped_lock done_lock(done_mutex);
+                    task_done_cv.notify_one();
+                }
+                continue;
+            }
+
+            // A steal can lose a race while tasks are still queued, so only sleep if there really is nothing to do
+            std::unique_lock<std::mutex> sleep_lock(sleep_mutex);
+            ++sleeping;
+            task_available_cv.wait(sleep_lock, [this] { return (tasks_queued > 0 && !paused) || !running; });
+            --sleeping;
+            if (!running)
+                break;
+        }
+        current_pool = nullptr;
+    }
+
+    // ============
+    // Private data
+    // ============
+
+    /**
+     * @brief The pool that the current thread is a worker of, if any. Used to send tasks pushed from inside a worker to its own deque.
+     */
+    inline static thread_local work_stealing_pool* current_pool = nullptr;
+
+    /**
+     * @brief The index of the current thread within current_pool.
+     */
+    inline static thread_local concurrency_t current_worker = 0;
+
+    /**
+     * @brief An atomic variable indicating whether the workers should pause.
+     */
+    std::atomic<bool> paused = false;
+
+    /**
+     * @brief An atomic variable indicating to the workers to keep running. When set to false, the workers permanently stop working.
+     */
+    std::atomic<bool> running = false;
+
+    /**
+     * @brief One work-stealing deque per worker.
+     */
+    std::vector<std::unique_ptr<work_stealing_deque<task_type>>> deques = {};
+
+    /**
+     * @brief Tasks pushed from outside the pool, waiting for a worker to take them.
+     */
+    std::deque<task_type*> injected_tasks = {};
+
+    /**
+     * @brief A mutex to synchronize access to the injection queue.
+     */
+    std::mutex injection_mutex = {};
+
+    /**
+     * @brief The number of tasks that have been pushed but not yet taken by a worker.
+     */
+    std::atomic<size_t> tasks_queued = 0;
+
+    /**
+     * @brief An atomic variable to keep track of the total number of unfinished tasks - either still queued, or running in a thread.
+     */
+    std::atomic<size_t> tasks_total = 0;
+
+    /**
+     * @brief The number of workers currently asleep, so that pushing a task only has to take the lock when someone needs waking.
+     */
+    std::atomic<size_t> sleeping = 0;
+
+    /**
+     * @brief A condition variable used to wake up sleeping workers when a new task has become available.
+     */
+    std::condition_variable task_available_cv = {};
+
+    /**
+     * @brief A mutex used together with task_available_cv.
+     */
+    std::mutex sleep_mutex = {};
+
+    /**
+     * @brief A condition variable used to notify wait_for_tasks() that a tasks is done.
+     */
+    std::condition_variable task_done_cv = {};
+
+    /**
+     * @brief A mutex used together with task_done_cv.
+     */
+    std::mutex done_mutex = {};
+
+    /**
+     * @brief The number of threads in the pool.
+     */
+    concurrency_t thread_count = 0;
+
+    /**
+     * @brief A smart pointer to manage the memory allocated for the threads.
+     */
+    std::unique_ptr<std::thread[]> threads = nullptr;
+
+    /**
+     * @brief An atomic variable indicating that wait_for_tasks() is active and expects to be notified whenever a task is done.
+     */
+    std::atomic<bool> waiting = false;
+};
+
+//                                 End class work_stealing_pool                                  //
+// ============================================================================================= //
+
+} // namespace BS
@@ -0,0 +1,250 @@
+#pragma once
+
+/**
+ * @file BS_worker_arena.hpp
+ *
+ * @brief BS::worker_arena: a monotonic std::pmr memory resource for each thread, meant for tasks that make a burst of short-lived allocations. Every worker of any of the thread pools gets its own arena, so tasks running at the same time never contend on the global heap, and once an arena has grown to fit a task, allocating in the next one is a pointer bump.
+ */
+
+#include <algorithm>       // std::min
+#include <bit>             // std::bit_ceil
+#include <cstddef>         // std::byte, std::max_align_t, std::size_t
+#include <memory_resource> // std::pmr::memory_resource, std::pmr::new_delete_resource
+#include <vector>          // std::vector
+
+namespace BS
+{
+// ============================================================================================= //
+//                                    Begin class worker_arena                                   //
+
+/**
+ * @brief A monotonic memory resource owned by a single thread. Allocations bump a pointer through one retained buffer, deallocations do nothing, and reset() frees everything at once. If a round of allocations doesn't fit in the buffer, the rest comes from the heap, and the buffer is grown on the next reset() so that the same round fits next time. Use worker_arena::scope to get the arena of the current thread and reset it when the outermost scope ends.
+ */
+class worker_arena : public std::pmr::memory_resource
+{
+public:
+    /**
+     * @brief The largest buffer an arena keeps between resets. Rounds that need more than this keep going to the heap for the excess, so one huge task doesn't pin its memory to the thread forever.
+     */
+    static constexpr std::size_t max_retained_bytes = std::size_t(64) << 20;
+
+    worker_arena() = default;
+
+    // An arena hands out pointers into itself, so it can't be copied or moved.
+    worker_arena(const worker_arena&) = delete;
+    worker_arena& operator=(const worker_arena&) = delete;
+
+    /**
+     * @brief Destruct the arena, freeing its buffer and any heap memory from the current round.
+     */
+    ~worker_arena() override
+    {
+        release();
+        if (buffer)
+            std::pmr::new_delete_resource()->deallocate(buffer, capacity, alignof(std::max_align_t));
+    }
+
+    /**
+     * @brief Get the number of bytes allocated since the last reset, including any that didn't fit in the buffer.
+     *
+     * @return The number of bytes.
+     */
+    [[nodiscard]] std::size_t get_bytes_used() const
+    {
+        return used + overflow_bytes;
+    }
+
+    /**
+     * @brief Get the size of the retained buffer.
+     *
+     * @return The number of bytes.
+     */
+    [[nodiscard]] std::size_t get_capacity() const
+    {
+        return capacity;
+    }
+
+    /**
+     * @brief Get the number of allocations that didn't fit in the buffer and went to the heap since the arena was created. Once the arena has warmed up, this should stop growing.
+     *
+     * @return The number of allocations.
+     */
+    [[nodiscard]] std::size_t get_overflow_count() const
+    {
+        return overflow_count;
+    }
+
+    /**
+     * @brief Get the arena of the current thread.
+     *
+     * @return A reference to the arena.
+     */
+    [[nodiscard]] static worker_arena& local()
+    {
+        thread_local worker_arena arena;
+        return arena;
+    }
+
+    /**
+     * @brief Free everything allocated from the arena at once. If the last round didn't fit in the buffer, grow it to fit. Every pointer handed out since the last reset becomes invalid.
+     */
+    void reset()
+    {
+        const std::size_t needed = get_bytes_used();
+        release();
+        if (needed > capacity && capacity < max_retained_bytes)
+        {
+            if (buffer)
+                std::pmr::new_delete_resource()->deallocate(buffer, capacity, alignof(std::max_align_t));
+            capacity = std::min(std::bit_ceil(needed), max_retained_bytes);
+            buffer = static_cast<std::byte*>(std::pmr::new_delete_resource()->allocate(capacity, alignof(std::max_align_t)));
+        }
+    }
+
+    /**
+     * @brief Gives access to the arena of the current thread, and resets it once the outermost scope on this thread ends. Nothing allocated from the arena may outlive the outermost scope, or be used on another thread.
+     */
+    class scope
+    {
+    public:
+        /**
+         * @brief Enter a scope on the current thread's arena.
+         */
+        scope() : arena(local())
+        {
+            ++arena.depth;
+        }
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+        /**
+         * @brief Leave the scope, resetting the arena if this was the outermost one.
+         */
+        ~scope()
+        {
+            if (--arena.depth == 0)
+                arena.reset();
+        }
+
+        /**
+         * @brief Get the arena as a memory resource, for std::pmr containers.
+         *
+         * @return A pointer to the arena.
+         */
+        [[nodiscard]] std::pmr::memory_resource* resource() const
+        {
+            return &arena;
+        }
+
+    private:
+        /**
+         * @brief The arena of the thread that entered the scope.
+         */
+        worker_arena& arena;
+    };
+
+private:
+    /**
+     * @brief A heap allocation that didn't fit in the buffer, kept so that it can be freed on reset.
+     */
+    struct overflow_block
+    {
+        void* pointer;
+        std::size_t bytes;
+        std::size_t alignment;
+    };
+
+    /**
+     * @brief Allocate by bumping the offset into the buffer, or from the heap if it doesn't fit.
+     *
+     * @param bytes The number of bytes needed.
+     * @param alignment The alignment needed.
+     * @return A pointer to the memory.
+     */
+    void* do_allocate(const std::size_t bytes, const std::size_t alignment) override
+    {
+        if (alignment <= alignof(std::max_align_t))
+        {
+            const std::size_t offset = (used + alignment - 1) & ~(alignment - 1);
+            if (offset + bytes <= capacity)
+            {
+                used = offset + bytes;
+                return buffer + offset;
+            }
+        }
+        void* pointer = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        overflow.push_back({pointer, bytes, alignment});
+        overflow_bytes += bytes;
+        ++overflow_count;
+        return pointer;
+    }
+
+    /**
+     * @brief Do nothing. Memory is only freed by reset().
+     */
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    /**
+     * @brief Check whether memory allocated from another resource can be freed by this one, which is only the case if they are the same arena.
+     *
+     * @param other The other resource.
+     * @return true if they are the same object.
+     */
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    /**
+     * @brief Free the heap allocations from the current round and rewind the buffer, without resizing it.
+     */
+    void release()
+    {
+        for (const overflow_block& block : overflow)
+            std::pmr::new_delete_resource()->deallocate(block.pointer, block.bytes, block.alignment);
+        overflow.clear();
+        overflow_bytes = 0;
+        used = 0;
+    }
+
+    /**
+     * @brief The retained buffer.
+     */
+    std::byte* buffer = nullptr;
+
+    /**
+     * @brief The size of the buffer.
+     */
+    std::size_t capacity = 0;
+
+    /**
+     * @brief The number of bytes of the buffer used since the last reset, including alignment padding.
+     */
+    std::size_t used = 0;
+
+    /**
+     * @brief The allocations that didn't fit in the buffer since the last reset.
+     */
+    std::vector<overflow_block> overflow = {};
+
+    /**
+     * @brief The total size of the allocations in overflow.
+     */
+    std::size_t overflow_bytes = 0;
+
+    /**
+     * @brief The total number of allocations that didn't fit in the buffer.
+     */
+    std::size_t overflow_count = 0;
+
+    /**
+     * @brief The number of scopes currently open on the arena.
+     */
+    std::size_t depth = 0;
+};
+
+//                                     End class worker_arena                                    //
+// ============================================================================================= //
+
+} // namespace BS
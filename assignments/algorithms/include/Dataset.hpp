@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Vehicle.hpp"
+
+/**
+ * Header at the start of every dataset file. All values are stored in the host's byte order.
+ */
+struct DatasetHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vehicleCount;
+    uint32_t nameCount;
+    uint32_t nameBytes;
+    uint64_t payloadSize;
+    uint64_t checksum;
+};
+
+/**
+ * Byte offsets of every column in a dataset file, relative to the start of the file.
+ */
+struct DatasetLayout {
+    uint64_t prices;
+    uint64_t mileages;
+    uint64_t horsepowers;
+    uint64_t maxSpeeds;
+    uint64_t nameIndices;
+    uint64_t wheels;
+    uint64_t doors;
+    uint64_t seats;
+    uint64_t nameOffsets;
+    uint64_t nameData;
+    uint64_t end;
+
+    /**
+     * Compute where each column lives for a dataset of a given size
+     * @param vehicleCount number of vehicles in the dataset
+     * @param nameCount number of unique names in the name table
+     * @param nameBytes total length of all unique names
+     * @return the layout of the file
+     */
+    static DatasetLayout compute(uint32_t vehicleCount, uint32_t nameCount, uint32_t nameBytes);
+};
+
+/**
+ * A read-only, memory-mapped set of vehicles stored in a compact binary file. The file is laid out in columns
+ * (all prices, then all mileages, etc.) followed by a table of interned vehicle names, so that key columns can be
+ * used directly from the mapping without parsing anything.
+ */
+class Dataset {
+public:
+    /**
+     * Magic bytes that every dataset file starts with
+     */
+    static constexpr char magic[8] = {'V', 'E', 'H', 'D', 'S', 'E', 'T', '\0'};
+
+    /**
+     * Version of the file format written by generate()
+     */
+    static constexpr uint32_t version = 1;
+
+    /**
+     * Write a set of vehicles into a dataset file, interning their names.
+     * @param path path of the file to write
+     * @param vehicles the vehicles to store, in order
+     * @return the checksum of the written dataset
+     * @throws runtime_error if the file could not be written
+     */
+    static uint64_t generate(const std::string &path, const std::vector<Vehicle *> &vehicles);
+
+    /**
+     * Map a dataset file into memory and validate it.
+     * @param path path of the dataset file
+     * @throws runtime_error if the file does not exist, is malformed, or its checksum does not match
+     */
+    explicit Dataset(const std::string &path);
+
+    /**
+     * Destructor for Dataset, unmaps the file.
+     */
+    ~Dataset();
+
+    Dataset(const Dataset &) = delete;
+    Dataset &operator=(const Dataset &) = delete;
+
+    /**
+     * Get the number of vehicles in the dataset
+     * @return # of vehicles
+     */
+    size_t size() const;
+
+    /**
+     * Get the checksum of the dataset's contents
+     * @return 64-bit FNV-1a checksum of everything after the header
+     */
+    uint64_t getChecksum() const;
+
+    /**
+     * Get the checksum of the dataset's contents as a hex string, for recording in results
+     * @return checksum as 16 hex digits
+     */
+    std::string getChecksumHex() const;
+
+    /**
+     * Get the price column of the dataset, straight from the mapping
+     * @return all prices, in vehicle order
+     */
+    std::span<const double> getPrices() const;
+
+    /**
+     * Get the name of a vehicle in the dataset
+     * @param idx index of the vehicle
+     * @return view of the name, valid while the Dataset is alive
+     */
+    std::string_view getName(size_t idx) const;
+
+    /**
+     * Construct a new Vehicle from an entry in the dataset
+     * @param idx index of the vehicle
+     * @return Pointer to new Vehicle instance
+     */
+    Vehicle *buildVehicle(size_t idx) const;
+
+    /**
+     * Construct new Vehicles from the first entries in the dataset
+     * @param count number of vehicles to build, must not be larger than size()
+     * @return Pointers to the new Vehicle instances
+     */
+    std::vector<Vehicle *> buildVehicles(size_t count) const;
+
+private:
+    /**
+     * Release the mapping of the file, if there is one
+     */
+    void unmap();
+
+    /**
+     * Get a typed pointer to a column in the mapping
+     * @tparam T element type of the column
+     * @param offset offset of the column from the start of the file
+     * @return pointer to the first element of the column
+     */
+    template<class T>
+    const T *column(uint64_t offset) const {
+        return reinterpret_cast<const T *>(data + offset);
+    }
+
+    const char *data;
+    size_t dataSize;
+    DatasetHeader header;
+    DatasetLayout layout;
+};
+
+/**
+ * Compute the 64-bit FNV-1a hash of a block of bytes
+ * @param bytes pointer to the first byte
+ * @param size number of bytes to hash
+ * @return the hash
+ */
+uint64_t fnv1a64(const char *bytes, size_t size);
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Hash the exact bit pattern of a price. Uses the splitmix64 finalizer so that nearby prices end up far apart.
+ * @param key price to hash
+ * @return 64-bit hash of the price
+ */
+uint64_t hashPrice(double key);
+
+/**
+ * A piecewise-linear learned index over a sorted column of prices. A root linear model picks which segment a key
+ * belongs to, and that segment's own least-squares line predicts its position. Each segment remembers how far off its
+ * predictions can be, so a lookup only has to binary search a small window around the prediction.
+ */
+class LearnedIndex {
+public:
+    /**
+     * Constructor for LearnedIndex, which copies the keys and fits all of the models.
+     * @param sortedKeys the keys to index, in ascending order
+     * @param keysPerSegment the average number of keys each linear segment should cover
+     */
+    LearnedIndex(const std::vector<double> &sortedKeys, size_t keysPerSegment = 64);
+
+    /**
+     * Find the position of a key
+     * @param key key to look for
+     * @return index of the first occurrence of the key in sortedKeys, -1 if it does not exist
+     */
+    int find(double key) const;
+
+    /**
+     * Get the number of linear segments in the index
+     * @return # of segments
+     */
+    size_t getSegmentCount() const;
+
+    /**
+     * Get the memory used by the index, including its copy of the keys
+     * @return memory usage in bytes
+     */
+    size_t memoryUsage() const;
+
+private:
+    /**
+     * A linear model over a contiguous run of keys, with the error bounds of its predictions.
+     */
+    struct Segment {
+        double slope;
+        double intercept;
+        int minError;
+        int maxError;
+    };
+
+    std::vector<double> keys;
+    std::vector<Segment> segments;
+    double rootSlope;
+    double rootIntercept;
+};
+
+/**
+ * A hash map from exact price to position that uses open addressing with linear probing. All slots live in a single
+ * flat array, so a lookup usually touches one cache line.
+ */
+class OpenAddressingPriceMap {
+public:
+    /**
+     * Constructor for OpenAddressingPriceMap, which sizes the table to keep the load factor at or below 0.5.
+     * @param expectedSize number of keys that will be inserted
+     */
+    explicit OpenAddressingPriceMap(size_t expectedSize);
+
+    /**
+     * Insert a key into the map. If the key already exists, the original value is kept.
+     * @param key price to insert
+     * @param value position to associate with the price, must be non-negative
+     */
+    void insert(double key, int value);
+
+    /**
+     * Find the value associated with a key
+     * @param key price to look for
+     * @return the value of the key, -1 if it does not exist
+     */
+    int find(double key) const;
+
+    /**
+     * Get the memory used by the table
+     * @return memory usage in bytes
+     */
+    size_t memoryUsage() const;
+
+private:
+    /**
+     * A slot in the table. A negative value marks the slot as empty.
+     */
+    struct Slot {
+        double key;
+        int value;
+    };
+
+    std::vector<Slot> slots;
+    size_t mask;
+};
+
+/**
+ * A hash map from exact price to position modelled on Swiss tables. A separate array of one-byte control tags (7 bits
+ * of the hash, or empty) is probed 16 at a time, with SSE2 when it is available, so most misses are rejected without
+ * ever touching the keys.
+ */
+class SwissPriceMap {
+public:
+    /**
+     * Number of control bytes that are checked at once
+     */
+    static constexpr size_t groupWidth = 16;
+
+    /**
+     * Constructor for SwissPriceMap, which sizes the table to keep the load factor at or below 7/8.
+     * @param expectedSize number of keys that will be inserted
+     */
+    explicit SwissPriceMap(size_t expectedSize);
+
+    /**
+     * Insert a key into the map. If the key already exists, the original value is kept.
+     * @param key price to insert
+     * @param value position to associate with the price
+     */
+    void insert(double key, int value);
+
+    /**
+     * Find the value associated with a key
+     * @param key price to look for
+     * @return the value of the key, -1 if it does not exist
+     */
+    int find(double key) const;
+
+    /**
+     * Get the memory used by the table
+     * @return memory usage in bytes
+     */
+    size_t memoryUsage() const;
+
+private:
+    /**
+     * Set the control byte of a slot, keeping the mirrored copy past the end of the table in sync
+     * @param idx index of the slot
+     * @param tag new control byte
+     */
+    void setControl(size_t idx, int8_t tag);
+
+    std::vector<int8_t> control;
+    std::vector<double> keys;
+    std::vector<int> values;
+    size_t mask;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/**
+ * Rearrange a vector so that the element at index k is the one that would be there if the vector was sorted, with
+ * every element before it not greater and every element after it not smaller. Average O(n)
+ * @tparam T Vector element type
+ * @tparam Compare Function type to compare two elements
+ * @param vec Vector to rearrange in place
+ * @param k Index of the element to select
+ * @param compareFunc Function to compare one element to another. Should return true if a < b
+ */
+template<class T, class Compare>
+void quickselect(std::vector<T> &vec, int k, Compare compareFunc) {
+    int lo = 0, hi = (int) vec.size() - 1;
+    while (lo < hi) {
+        // Median of three as the pivot to avoid worst cases on sorted input
+        int mid = lo + (hi - lo) / 2;
+        if (compareFunc(vec[mid], vec[lo])) std::swap(vec[mid], vec[lo]);
+        if (compareFunc(vec[hi], vec[lo])) std::swap(vec[hi], vec[lo]);
+        if (compareFunc(vec[hi], vec[mid])) std::swap(vec[hi], vec[mid]);
+        T pivot = vec[mid];
+
+        // Hoare partition around the pivot
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (compareFunc(vec[i], pivot)) i++;
+            while (compareFunc(pivot, vec[j])) j--;
+            if (i <= j) {
+                std::swap(vec[i++], vec[j--]);
+            }
+        }
+
+        // Only keep going on the side that contains k
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            return;
+        }
+    }
+}
+
+/**
+ * Find the k smallest elements by keeping a max-heap of the best k seen so far. O(n log k), and only needs O(k) extra
+ * space, so the input doesn't have to be copied.
+ * @tparam T Vector element type
+ * @tparam Compare Function type to compare two elements
+ * @param vec Vector to select from, left unchanged
+ * @param k Number of elements to select
+ * @param compareFunc Function to compare one element to another. Should return true if a < b
+ * @return The k smallest elements in ascending order
+ */
+template<class T, class Compare>
+std::vector<T> boundedHeapSelect(const std::vector<T> &vec, int k, Compare compareFunc) {
+    std::vector<T> heap;
+    if (k <= 0) return heap;
+    auto count = (size_t) k;
+    heap.reserve(count);
+
+    for (const T &element: vec) {
+        if (heap.size() < count) {
+            heap.push_back(element);
+            std::push_heap(heap.begin(), heap.end(), compareFunc);
+        } else if (compareFunc(element, heap.front())) {
+            // Smaller than the largest of the best k, so it replaces it
+            std::pop_heap(heap.begin(), heap.end(), compareFunc);
+            heap.back() = element;
+            std::push_heap(heap.begin(), heap.end(), compareFunc);
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), compareFunc);
+    return heap;
+}
+
+/**
+ * Find the indices of the k smallest prices in a price column. A threshold is first estimated from a sample of the
+ * column, then the whole column is scanned with SIMD compares (AVX2 if compiled for it, otherwise SSE2) to keep only
+ * prices at or below the threshold. Only those few candidates are actually selected and sorted. If the estimate turns
+ * out too low, the threshold is raised and the scan is repeated.
+ * @param prices Column of prices to select from
+ * @param k Number of prices to select
+ * @return Indices of the k smallest prices, in ascending order of price
+ */
+std::vector<int> simdFilteredTopK(const std::vector<double> &prices, int k);
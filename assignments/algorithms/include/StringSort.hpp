@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Partitions smaller than this are finished with insertion sort by the string sorts, since counting or
+ * partitioning by a single character isn't worth it for a handful of elements.
+ */
+const int stringSortCutoff = 32;
+
+/**
+ * Get the character of a key at a specific depth, treating the end of the string as smaller than any character.
+ * @param key key to get character from
+ * @param depth index of the character
+ * @return 0 if the key is shorter than depth, otherwise the character + 1
+ */
+inline int charAt(std::string_view key, size_t depth) {
+    return depth < key.size() ? (unsigned char) key[depth] + 1 : 0;
+}
+
+/**
+ * Get the first 8 bytes of a key packed big-endian into an integer, so that comparing two prefixes as integers gives
+ * the same order as comparing the first 8 characters of the keys. Shorter keys are padded with zeros.
+ * @param key key to get the prefix of
+ * @return the packed prefix
+ */
+inline uint64_t bigEndianPrefix(std::string_view key) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; i++) {
+        prefix = (prefix << 8) | (i < key.size() ? (unsigned char) key[i] : 0);
+    }
+
+    return prefix;
+}
+
+/**
+ * Insertion sort a range by string key, skipping the first depth characters which are known to be equal.
+ * @tparam T Vector element type
+ * @tparam Alloc Vector allocator type
+ * @tparam KeyFunc Function type to extract a std::string_view key from an element
+ * @param vec Vector containing the range
+ * @param lo First index of the range
+ * @param hi Last index of the range (inclusive)
+ * @param depth Number of leading characters known to be equal
+ * @param extractKey Function to extract key value from
+ */
+template<class T, class Alloc, class KeyFunc>
+void insertionSortByKeyFrom(std::vector<T, Alloc> &vec, int lo, int hi, size_t depth, KeyFunc extractKey) {
+    for (int i = lo + 1; i <= hi; i++) {
+        T element = vec[i];
+        std::string_view key = extractKey(element);
+        key.remove_prefix(std::min(depth, key.size()));
+        int j = i - 1;
+
+        // While the element before it is larger, shift it up
+        for (; j >= lo; j--) {
+            std::string_view other = extractKey(vec[j]);
+            other.remove_prefix(std::min(depth, other.size()));
+            if (other <= key) break;
+            vec[j + 1] = vec[j];
+        }
+
+        vec[j + 1] = element;
+    }
+}
+
+/**
+ * Recursive step of msdRadixSort, sorts a range by the character at depth and recurses into each bucket.
+ * @tparam T Vector element type
+ * @tparam Alloc Vector allocator type
+ * @tparam KeyFunc Function type to extract a std::string_view key from an element
+ * @param vec Vector containing the range
+ * @param aux Scratch space at least as large as the range
+ * @param lo First index of the range
+ * @param hi Last index of the range (inclusive)
+ * @param depth Index of the character to distribute by
+ * @param extractKey Function to extract key value from
+ */
+template<class T, class Alloc, class KeyFunc>
+void msdRadixSortStep(std::vector<T, Alloc> &vec, std::vector<T, Alloc> &aux, int lo, int hi, size_t depth, KeyFunc extractKey) {
+    if (hi - lo < stringSortCutoff) {
+        insertionSortByKeyFrom(vec, lo, hi, depth, extractKey);
+        return;
+    }
+
+    // Count how many keys fall into each bucket (0 is end of string, 1-256 are characters)
+    int count[258] = {};
+    for (int i = lo; i <= hi; i++) {
+        count[charAt(extractKey(vec[i]), depth) + 1]++;
+    }
+
+    // Turn the counts into starting indices
+    for (int r = 0; r < 257; r++) {
+        count[r + 1] += count[r];
+    }
+
+    // Distribute into the auxiliary array, then copy back
+    for (int i = lo; i <= hi; i++) {
+        aux[count[charAt(extractKey(vec[i]), depth)]++] = vec[i];
+    }
+    std::copy(aux.begin(), aux.begin() + (hi - lo + 1), vec.begin() + lo);
+
+    // Recursively sort every bucket except end-of-string, which is already in its final order
+    for (int r = 1; r < 257; r++) {
+        int bucketLo = lo + count[r - 1];
+        int bucketHi = lo + count[r] - 1;
+        if (bucketLo < bucketHi) {
+            msdRadixSortStep(vec, aux, bucketLo, bucketHi, depth + 1, extractKey);
+        }
+    }
+}
+
+/**
+ * Sort a vector by string key using most-significant-digit radix sort. O(n * average key length)
+ * The auxiliary array is allocated with the vector's allocator.
+ * @tparam T Vector element type
+ * @tparam Alloc Vector allocator type
+ * @tparam KeyFunc Function type to extract a std::string_view key from an element
+ * @param vec Vector to sort in place
+ * @param extractKey Function to extract key value from
+ */
+template<class T, class Alloc, class KeyFunc>
+void msdRadixSort(std::vector<T, Alloc> &vec, KeyFunc extractKey) {
+    if (vec.size() < 2) return;
+
+    std::vector<T, Alloc> aux(vec.size(), vec.get_allocator());
+    msdRadixSortStep(vec, aux, 0, (int) vec.size() - 1, 0, extractKey);
+}
+
+/**
+ * Recursive step of multikeyQuicksort, partitions a range around the character at depth and recurses.
+ * @tparam T Vector element type
+ * @tparam Alloc Vector allocator type
+ * @tparam KeyFunc Function type to extract a std::string_view key from an element
+ * @param vec Vector containing the range
+ * @param lo First index of the range
+ * @param hi Last index of the range (inclusive)
+ * @param depth Index of the character to partition by
+ * @param extractKey Function to extract key value from
+ */
+template<class T, class Alloc, class KeyFunc>
+void multikeyQuicksortStep(std::vector<T, Alloc> &vec, int lo, int hi, size_t depth, KeyFunc extractKey) {
+    if (hi - lo < stringSortCutoff) {
+        insertionSortByKeyFrom(vec, lo, hi, depth, extractKey);
+        return;
+    }
+
+    // Use the middle element's character as the pivot to avoid worst cases on sorted input
+    std::swap(vec[lo], vec[lo + (hi - lo) / 2]);
+    int pivot = charAt(extractKey(vec[lo]), depth);
+
+    // Three way partition: [lo, lt) < pivot, [lt, gt] == pivot, (gt, hi] > pivot
+    int lt = lo, gt = hi, i = lo + 1;
+    while (i <= gt) {
+        int c = charAt(extractKey(vec[i]), depth);
+        if (c < pivot) {
+            std::swap(vec[lt++], vec[i++]);
+        } else if (c > pivot) {
+            std::swap(vec[i], vec[gt--]);
+        } else {
+            i++;
+        }
+    }
+
+    multikeyQuicksortStep(vec, lo, lt - 1, depth, extractKey);
+    if (pivot > 0) {
+        // Only keep going deeper if the keys haven't ended yet
+        multikeyQuicksortStep(vec, lt, gt, depth + 1, extractKey);
+    }
+    multikeyQuicksortStep(vec, gt + 1, hi, depth, extractKey);
+}
+
+/**
+ * Sort a vector by string key using multikey (three-way radix) quicksort.
+ * @tparam T Vector element type
+ * @tparam Alloc Vector allocator type
+ * @tparam KeyFunc Function type to extract a std::string_view key from an element
+ * @param vec Vector to sort in place
+ * @param extractKey Function to extract key value from
+ */
+template<class T, class Alloc, class KeyFunc>
+void multikeyQuicksort(std::vector<T, Alloc> &vec, KeyFunc extractKey) {
+    if (vec.size() < 2) return;
+
+    multikeyQuicksortStep(vec, 0, (int) vec.size() - 1, 0, extractKey);
+}
+
+/**
+ * Sort a vector by string key by first caching the first 8 bytes of each key as a big-endian integer. Most
+ * comparisons are then a single integer compare, and the full keys are only compared when the prefixes tie. The prefixes are allocated with the vector's allocator.
+ * @tparam T Vector element type
+ * @tparam Alloc Vector allocator type
+ * @tparam KeyFunc Function type to extract a std::string_view key from an element
+ * @param vec Vector to sort in place
+ * @param extractKey Function to extract key value from
+ */
+template<class T, class Alloc, class KeyFunc>
+void prefixSort(std::vector<T, Alloc> &vec, KeyFunc extractKey) {
+    // Decorate every element with its cached prefix, allocating the same way as the vector
+    using DecoratedAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<std::pair<uint64_t, T>>;
+    std::vector<std::pair<uint64_t, T>, DecoratedAlloc> decorated{DecoratedAlloc(vec.get_allocator())};
+    decorated.reserve(vec.size());
+    for (const T &element: vec) {
+        decorated.emplace_back(bigEndianPrefix(extractKey(element)), element);
+    }
+
+    std::sort(decorated.begin(), decorated.end(), [&extractKey](const auto &a, const auto &b) {
+        if (a.first != b.first) return a.first < b.first;
+
+        // Prefixes tie, so the first 8 characters are equal and only the rest needs comparing
+        std::string_view aKey = extractKey(a.second), bKey = extractKey(b.second);
+        return aKey.substr(std::min<size_t>(8, aKey.size())) < bKey.substr(std::min<size_t>(8, bKey.size()));
+    });
+
+    // Undecorate back into the original vector
+    for (size_t i = 0; i < vec.size(); i++) {
+        vec[i] = decorated[i].second;
+    }
+}
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 
 /**
  * A class representing a Vehicle. Serves as a base class for specific types of vehicles (sedans, motorcycles, etc.).
@@ -22,6 +23,11 @@ public:
     Vehicle(std::string name, double price, int wheels, int doors, int seats,
             double mileage, double horsepower, double maxSpeed);
 
+    /**
+     * Destructor for Vehicle, virtual so that specific types of vehicles can be deleted through a Vehicle pointer
+     */
+    virtual ~Vehicle() = default;
+
     /**
      * Change the price of the vehicle
      * @param newPrice the new price
@@ -65,12 +71,31 @@ public:
      */
     double getPrice() const;
 
+    /**
+     * Get the mileage of the vehicle in kilometres
+     * @return mileage of the vehicle in kilometres
+     */
+    double getMileage() const;
+
     /**
      * Get the name of the vehicle
      * @return name of the vehicle
      */
     std::string getName() const;
 
+    /**
+     * Get a view of the name of the vehicle without copying it
+     * @return view of the name of the vehicle, valid as long as the vehicle is
+     */
+    std::string_view getNameView() const;
+
+    /**
+     * Roughly approximate the fuel usage for the vehicle to travel a certain amount of kilometres.
+     * @param kilometres Number of kilometres
+     * @return Fuel usage in litres
+     */
+    virtual double approximateFuelUsageFromKm(double kilometres) const;
+
     /**
      * Convert the data in the instance into a string
      * @param out the current output stream to add onto
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Vehicle.hpp"
+
+enum MOTORCYCLE_TYPE {
+    SPORT,
+    CRUISER,
+    SCOOTER,
+    TOURING
+};
+
+/**
+ * A class that represents a Motorcycle, a type of vehicle. As such, it inherits from Vehicle.
+ */
+class Motorcycle final : public Vehicle {
+public:
+    /**
+     * Constructor for Motorcycle, inherits from Vehicle.
+     * @param name name of motorcycle
+     * @param price price of motorcycle in dollars
+     * @param mileage mileage of motorcycle in kilometres
+     * @param horsepower horsepower of motorcycle
+     * @param maxSpeed max speed of motorcycle in km/h
+     * @param engineSize size of the engine in cc
+     * @param maxAcceleration max acceleration of motorcycle in m/s^2
+     * @param motorcycleType type of motorcycle
+     */
+    Motorcycle(std::string name, double price, double mileage, double horsepower, double maxSpeed,
+               double engineSize, double maxAcceleration, MOTORCYCLE_TYPE motorcycleType);
+
+    /**
+     * Get the size of the motorcycle's engine
+     * @return engine size in cc
+     */
+    double getEngineSize() const;
+
+    /**
+     * Get the max acceleration of the motorcycle
+     * @return max acceleration in m/s^2
+     */
+    double getMaxAcceleration() const;
+
+    /**
+     * Get the type of the motorcycle
+     * @return type of motorcycle
+     */
+    MOTORCYCLE_TYPE getMotorcycleType() const;
+
+    /**
+     * Roughly approximate the fuel usage for the vehicle to travel a certain amount of kilometres.
+     * @param kilometres Number of kilometres
+     * @return Fuel usage in litres
+     */
+    double approximateFuelUsageFromKm(double kilometres) const override;
+
+private:
+    double engineSize;
+    double maxAcceleration;
+    MOTORCYCLE_TYPE motorcycleType;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Vehicle.hpp"
+
+/**
+ * A class that represents a PickupTruck, a type of vehicle. As such, it inherits from Vehicle.
+ */
+class PickupTruck final : public Vehicle {
+public:
+    /**
+     * Constructor for PickupTruck, inherits from Vehicle.
+     * @param name name of pickup
+     * @param price price of pickup, in dollars
+     * @param mileage mileage of pickup, in kilometres
+     * @param horsepower horsepower of pickup
+     * @param maxSpeed max speed of pickup, in km/h
+     * @param bedCapacity trunk bed capacity available in pickup, in kg
+     * @param towingMaxLoad max weight that can be towed, in kg
+     * @param engineCylinderCount the number of cylinders in the pickup's engine
+     */
+    PickupTruck(std::string name, double price, double mileage, double horsepower, double maxSpeed,
+                double bedCapacity, double towingMaxLoad, int engineCylinderCount);
+
+    /**
+     * Get the max weight that can be in the trunk bed.
+     * @return the bed capacity in kg
+     */
+    double getBedCapacity() const;
+
+    /**
+     * Get the max weight that can be towed by the pickup truck.
+     * @return The max towable weight in kilograms.
+     */
+    double getTowingMaxLoad() const;
+
+    /**
+     * Get the number of cylinders in the pickup truck's engine.
+     * @return The number of cylinders in its engine.
+     */
+    int getEngineCylinderCount() const;
+
+    /**
+     * Roughly approximate the fuel usage for the vehicle to travel a certain amount of kilometres.
+     * @param kilometres Number of kilometres
+     * @return Fuel usage in litres
+     */
+    double approximateFuelUsageFromKm(double kilometres) const override;
+
+private:
+    double bedCapacity;
+    double towingMaxLoad;
+    int engineCylinderCount;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Vehicle.hpp"
+
+/**
+ * A class that represents a Sedan, a type of vehicle. As such, it inherits from Vehicle.
+ */
+class Sedan final : public Vehicle {
+public:
+    /**
+     * Constructor for Sedan, inherits from Vehicle.
+     * @param name name of sedan
+     * @param price price of sedan, in dollars
+     * @param mileage mileage of sedan, in kilometres
+     * @param horsepower horsepower of sedan
+     * @param maxSpeed max speed of sedan, in km/h
+     * @param trunkCapacity trunk capacity available in sedan, in kilograms
+     * @param engineCylinderCount number of cylinders in the engine
+     */
+    Sedan(std::string name, double price, double mileage, double horsepower, double maxSpeed,
+          double trunkCapacity, int engineCylinderCount);
+
+    /**
+     * Get the max weight that can be in the trunk.
+     * @return the trunk capacity in kg
+     */
+    double getTrunkCapacity() const;
+
+    /**
+     * Get the number of cylinders in the sedan's engine.
+     * @return The number of cylinders in its engine.
+     */
+    int getEngineCylinderCount() const;
+
+    /**
+     * Roughly approximate the fuel usage for the vehicle to travel a certain amount of kilometres.
+     * @param kilometres Number of kilometres
+     * @return Fuel usage in litres
+     */
+    double approximateFuelUsageFromKm(double kilometres) const override;
+
+private:
+    double trunkCapacity;
+    int engineCylinderCount;
+};
@@ -0,0 +1,239 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include "Dataset.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+/**
+ * Round an offset up so the column starting at it is 8-byte aligned
+ * @param offset offset to round
+ * @return the aligned offset
+ */
+static uint64_t alignColumn(uint64_t offset) {
+    return (offset + 7) & ~uint64_t{7};
+}
+
+uint64_t fnv1a64(const char *bytes, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char) bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+DatasetLayout DatasetLayout::compute(uint32_t vehicleCount, uint32_t nameCount, uint32_t nameBytes) {
+    DatasetLayout layout{};
+
+    // Doubles first so that every column stays naturally aligned
+    layout.prices = alignColumn(sizeof(DatasetHeader));
+    layout.mileages = alignColumn(layout.prices + vehicleCount * sizeof(double));
+    layout.horsepowers = alignColumn(layout.mileages + vehicleCount * sizeof(double));
+    layout.maxSpeeds = alignColumn(layout.horsepowers + vehicleCount * sizeof(double));
+    layout.nameIndices = alignColumn(layout.maxSpeeds + vehicleCount * sizeof(double));
+    layout.wheels = alignColumn(layout.nameIndices + vehicleCount * sizeof(uint32_t));
+    layout.doors = alignColumn(layout.wheels + vehicleCount * sizeof(uint8_t));
+    layout.seats = alignColumn(layout.doors + vehicleCount * sizeof(uint8_t));
+    layout.nameOffsets = alignColumn(layout.seats + vehicleCount * sizeof(uint8_t));
+    layout.nameData = alignColumn(layout.nameOffsets + (nameCount + 1) * sizeof(uint32_t));
+    layout.end = layout.nameData + nameBytes;
+
+    return layout;
+}
+
+uint64_t Dataset::generate(const std::string &path, const std::vector<Vehicle *> &vehicles) {
+    // Intern all the names so that repeated names are only stored once
+    std::unordered_map<std::string, uint32_t> nameToIdx;
+    std::vector<std::string> names;
+    std::vector<uint32_t> nameIndices;
+    nameIndices.reserve(vehicles.size());
+    uint32_t nameBytes = 0;
+    for (Vehicle *vehicle: vehicles) {
+        std::string name = vehicle->getName();
+        auto [it, inserted] = nameToIdx.try_emplace(name, (uint32_t) names.size());
+        if (inserted) {
+            nameBytes += name.size();
+            names.push_back(std::move(name));
+        }
+        nameIndices.push_back(it->second);
+    }
+
+    auto vehicleCount = (uint32_t) vehicles.size();
+    auto nameCount = (uint32_t) names.size();
+    DatasetLayout layout = DatasetLayout::compute(vehicleCount, nameCount, nameBytes);
+
+    // Build the entire file in memory, then write it out at once
+    std::vector<char> buffer(layout.end, 0);
+    auto *prices = reinterpret_cast<double *>(buffer.data() + layout.prices);
+    auto *mileages = reinterpret_cast<double *>(buffer.data() + layout.mileages);
+    auto *horsepowers = reinterpret_cast<double *>(buffer.data() + layout.horsepowers);
+    auto *maxSpeeds = reinterpret_cast<double *>(buffer.data() + layout.maxSpeeds);
+    auto *wheels = reinterpret_cast<uint8_t *>(buffer.data() + layout.wheels);
+    auto *doors = reinterpret_cast<uint8_t *>(buffer.data() + layout.doors);
+    auto *seats = reinterpret_cast<uint8_t *>(buffer.data() + layout.seats);
+    for (uint32_t i = 0; i < vehicleCount; i++) {
+        prices[i] = vehicles[i]->getPrice();
+        mileages[i] = vehicles[i]->getMileage();
+        horsepowers[i] = vehicles[i]->getHorsepower();
+        maxSpeeds[i] = vehicles[i]->getMaxSpeed();
+        wheels[i] = (uint8_t) vehicles[i]->getWheels();
+        doors[i] = (uint8_t) vehicles[i]->getDoors();
+        seats[i] = (uint8_t) vehicles[i]->getSeats();
+    }
+    std::memcpy(buffer.data() + layout.nameIndices, nameIndices.data(), vehicleCount * sizeof(uint32_t));
+
+    // Name table is an offset array followed by all the characters back to back
+    auto *nameOffsets = reinterpret_cast<uint32_t *>(buffer.data() + layout.nameOffsets);
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < nameCount; i++) {
+        nameOffsets[i] = offset;
+        std::memcpy(buffer.data() + layout.nameData + offset, names[i].data(), names[i].size());
+        offset += names[i].size();
+    }
+    nameOffsets[nameCount] = offset;
+
+    // Fill in the header last since it needs the checksum of everything else
+    DatasetHeader header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.vehicleCount = vehicleCount;
+    header.nameCount = nameCount;
+    header.nameBytes = nameBytes;
+    header.payloadSize = layout.end - sizeof(DatasetHeader);
+    header.checksum = fnv1a64(buffer.data() + sizeof(DatasetHeader), header.payloadSize);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    std::ofstream file(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open " + path + " for writing");
+    }
+    file.write(buffer.data(), (std::streamsize) buffer.size());
+    file.close();
+
+    return header.checksum;
+}
+
+Dataset::Dataset(const std::string &path) {
+    if (!fs::exists(path)) {
+        // File needs to exist to read anything
+        throw std::runtime_error(path + " does not exist");
+    }
+
+    dataSize = fs::file_size(path);
+    if (dataSize < sizeof(DatasetHeader)) {
+        throw std::runtime_error(path + " is too small to be a dataset");
+    }
+
+#ifdef _WIN32
+    // No mmap available, fall back to reading the file in one go
+    char *buffer = new char[dataSize];
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    file.read(buffer, (std::streamsize) dataSize);
+    data = buffer;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    void *mapping = mmap(nullptr, dataSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Could not map " + path);
+    }
+    data = static_cast<const char *>(mapping);
+#endif
+
+    // Validate the header before trusting any of the offsets
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version) {
+        unmap();
+        throw std::runtime_error(path + " is not a version " + std::to_string(version) + " dataset");
+    }
+
+    layout = DatasetLayout::compute(header.vehicleCount, header.nameCount, header.nameBytes);
+    if (layout.end != dataSize || header.payloadSize != dataSize - sizeof(DatasetHeader)) {
+        unmap();
+        throw std::runtime_error(path + " is truncated or corrupt");
+    }
+
+    if (fnv1a64(data + sizeof(DatasetHeader), header.payloadSize) != header.checksum) {
+        unmap();
+        throw std::runtime_error(path + " failed its checksum");
+    }
+}
+
+Dataset::~Dataset() {
+    unmap();
+}
+
+void Dataset::unmap() {
+    if (data == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    delete[] data;
+#else
+    munmap(const_cast<char *>(data), dataSize);
+#endif
+    data = nullptr;
+}
+
+size_t Dataset::size() const {
+    return header.vehicleCount;
+}
+
+uint64_t Dataset::getChecksum() const {
+    return header.checksum;
+}
+
+std::string Dataset::getChecksumHex() const {
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << header.checksum;
+    return ss.str();
+}
+
+std::span<const double> Dataset::getPrices() const {
+    return {column<double>(layout.prices), size()};
+}
+
+std::string_view Dataset::getName(size_t idx) const {
+    const uint32_t *nameOffsets = column<uint32_t>(layout.nameOffsets);
+    uint32_t nameIdx = column<uint32_t>(layout.nameIndices)[idx];
+
+    return {data + layout.nameData + nameOffsets[nameIdx], nameOffsets[nameIdx + 1] - nameOffsets[nameIdx]};
+}
+
+Vehicle *Dataset::buildVehicle(size_t idx) const {
+    return new Vehicle(std::string(getName(idx)), column<double>(layout.prices)[idx],
+                       column<uint8_t>(layout.wheels)[idx], column<uint8_t>(layout.doors)[idx],
+                       column<uint8_t>(layout.seats)[idx], column<double>(layout.mileages)[idx],
+                       column<double>(layout.horsepowers)[idx], column<double>(layout.maxSpeeds)[idx]);
+}
+
+std::vector<Vehicle *> Dataset::buildVehicles(size_t count) const {
+    if (count > size()) {
+        throw std::runtime_error("Dataset only has " + std::to_string(size()) + " vehicles, " +
+                                 std::to_string(count) + " were requested");
+    }
+
+    std::vector<Vehicle *> vehicles;
+    vehicles.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        vehicles.push_back(buildVehicle(i));
+    }
+
+    return vehicles;
+}
@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include "PriceIndex.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Control byte of an empty slot in a SwissPriceMap. Full slots store the low 7 bits of their hash instead.
+ */
+const int8_t emptyControl = -128;
+
+/**
+ * Round a size up to the next power of two
+ * @param size size to round
+ * @return the smallest power of two that is at least size
+ */
+static size_t roundUpToPowerOfTwo(size_t size) {
+    return std::bit_ceil(std::max<size_t>(size, 1));
+}
+
+/**
+ * Find which bytes in a group of control bytes equal a tag
+ * @param group pointer to the first of SwissPriceMap::groupWidth control bytes
+ * @param tag the control byte to look for
+ * @return bitmask with bit i set if group[i] == tag
+ */
+static uint32_t matchControl(const int8_t *group, int8_t tag) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+#else
+    uint32_t matches = 0;
+    for (size_t i = 0; i < SwissPriceMap::groupWidth; i++) {
+        matches |= (uint32_t) (group[i] == tag) << i;
+    }
+    return matches;
+#endif
+}
+
+uint64_t hashPrice(double key) {
+    uint64_t x = std::bit_cast<uint64_t>(key);
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+
+    return x;
+}
+
+LearnedIndex::LearnedIndex(const std::vector<double> &sortedKeys, size_t keysPerSegment) {
+    this->keys = sortedKeys;
+
+    size_t segmentCount = std::max<size_t>(1, keys.size() / std::max<size_t>(1, keysPerSegment));
+    segments.resize(segmentCount);
+
+    // Root model spreads the key range evenly over the segments
+    double minKey = keys.empty() ? 0 : keys.front();
+    double maxKey = keys.empty() ? 0 : keys.back();
+    rootSlope = maxKey > minKey ? (double) segmentCount / (maxKey - minKey) : 0;
+    rootIntercept = -minKey * rootSlope;
+
+    // Keys are sorted and the root model is monotonic, so each segment covers a contiguous run of keys
+    size_t start = 0;
+    for (size_t s = 0; s < segmentCount; s++) {
+        size_t end = start;
+        while (end < keys.size() &&
+               std::clamp<long long>((long long) (rootSlope * keys[end] + rootIntercept), 0, (long long) segmentCount - 1) == (long long) s) {
+            end++;
+        }
+
+        Segment &segment = segments[s];
+        size_t count = end - start;
+        if (count == 0) {
+            // Nothing maps here, so every lookup that lands here is a miss
+            segment = {0, 0, 1, 0};
+            continue;
+        }
+
+        // Least squares fit of position against key
+        double meanKey = 0, meanPos = 0;
+        for (size_t i = start; i < end; i++) {
+            meanKey += keys[i];
+            meanPos += (double) i;
+        }
+        meanKey /= (double) count;
+        meanPos /= (double) count;
+
+        double covariance = 0, variance = 0;
+        for (size_t i = start; i < end; i++) {
+            covariance += (keys[i] - meanKey) * ((double) i - meanPos);
+            variance += (keys[i] - meanKey) * (keys[i] - meanKey);
+        }
+        segment.slope = variance > 0 ? covariance / variance : 0;
+        segment.intercept = meanPos - segment.slope * meanKey;
+
+        // Record how far off the predictions are so lookups know how wide of a window to search
+        segment.minError = 0;
+        segment.maxError = 0;
+        for (size_t i = start; i < end; i++) {
+            int predicted = (int) std::lround(segment.slope * keys[i] + segment.intercept);
+            segment.minError = std::min(segment.minError, (int) i - predicted);
+            segment.maxError = std::max(segment.maxError, (int) i - predicted);
+        }
+
+        start = end;
+    }
+}
+
+int LearnedIndex::find(double key) const {
+    if (keys.empty()) return -1;
+
+    long long segmentIdx = (long long) (rootSlope * key + rootIntercept);
+    const Segment &segment = segments[std::clamp<long long>(segmentIdx, 0, (long long) segments.size() - 1)];
+    if (segment.minError > segment.maxError) return -1;
+
+    // Only search the window that the segment's error bounds allow
+    long long predicted = std::lround(segment.slope * key + segment.intercept);
+    long long lo = std::clamp<long long>(predicted + segment.minError, 0, (long long) keys.size() - 1);
+    long long hi = std::clamp<long long>(predicted + segment.maxError, 0, (long long) keys.size() - 1);
+
+    auto it = std::lower_bound(keys.begin() + lo, keys.begin() + hi + 1, key);
+    if (it == keys.begin() + hi + 1 || *it != key) return -1;
+
+    return (int) (it - keys.begin());
+}
+
+size_t LearnedIndex::getSegmentCount() const {
+    return segments.size();
+}
+
+size_t LearnedIndex::memoryUsage() const {
+    return sizeof(LearnedIndex) + keys.capacity() * sizeof(double) + segments.capacity() * sizeof(Segment);
+}
+
+OpenAddressingPriceMap::OpenAddressingPriceMap(size_t expectedSize) {
+    slots.assign(roundUpToPowerOfTwo(expectedSize * 2), Slot{0, -1});
+    mask = slots.size() - 1;
+}
+
+void OpenAddressingPriceMap::insert(double key, int value) {
+    for (size_t idx = hashPrice(key) & mask;; idx = (idx + 1) & mask) {
+        if (slots[idx].value < 0) {
+            slots[idx] = {key, value};
+            return;
+        }
+
+        if (slots[idx].key == key) {
+            // Keep the first value inserted for a price
+            return;
+        }
+    }
+}
+
+int OpenAddressingPriceMap::find(double key) const {
+    for (size_t idx = hashPrice(key) & mask;; idx = (idx + 1) & mask) {
+        if (slots[idx].value < 0) return -1;
+        if (slots[idx].key == key) return slots[idx].value;
+    }
+}
+
+size_t OpenAddressingPriceMap::memoryUsage() const {
+    return sizeof(OpenAddressingPriceMap) + slots.capacity() * sizeof(Slot);
+}
+
+SwissPriceMap::SwissPriceMap(size_t expectedSize) {
+    size_t capacity = roundUpToPowerOfTwo(std::max(groupWidth, expectedSize * 8 / 7 + 1));
+
+    // The first group is mirrored past the end so that a group can always be loaded without wrapping around
+    control.assign(capacity + groupWidth, emptyControl);
+    keys.resize(capacity);
+    values.resize(capacity);
+    mask = capacity - 1;
+}
+
+void SwissPriceMap::setControl(size_t idx, int8_t tag) {
+    control[idx] = tag;
+    if (idx < groupWidth) {
+        control[keys.size() + idx] = tag;
+    }
+}
+
+void SwissPriceMap::insert(double key, int value) {
+    uint64_t hash = hashPrice(key);
+    auto tag = (int8_t) (hash & 0x7f);
+
+    for (size_t pos = (hash >> 7) & mask;; pos = (pos + groupWidth) & mask) {
+        // Check whether the key is already in this group
+        for (uint32_t matches = matchControl(&control[pos], tag); matches; matches &= matches - 1) {
+            size_t idx = (pos + std::countr_zero(matches)) & mask;
+            if (keys[idx] == key) return;
+        }
+
+        // Otherwise take the first empty slot in the group, if there is one
+        uint32_t empties = matchControl(&control[pos], emptyControl);
+        if (empties) {
+            size_t idx = (pos + std::countr_zero(empties)) & mask;
+            setControl(idx, tag);
+            keys[idx] = key;
+            values[idx] = value;
+            return;
+        }
+    }
+}
+
+int SwissPriceMap::find(double key) const {
+    uint64_t hash = hashPrice(key);
+    auto tag = (int8_t) (hash & 0x7f);
+
+    for (size_t pos = (hash >> 7) & mask;; pos = (pos + groupWidth) & mask) {
+        for (uint32_t matches = matchControl(&control[pos], tag); matches; matches &= matches - 1) {
+            size_t idx = (pos + std::countr_zero(matches)) & mask;
+            if (keys[idx] == key) return values[idx];
+        }
+
+        // An empty slot means the key would have been inserted here, so it doesn't exist
+        if (matchControl(&control[pos], emptyControl)) return -1;
+    }
+}
+
+size_t SwissPriceMap::memoryUsage() const {
+    return sizeof(SwissPriceMap) + control.capacity() * sizeof(int8_t) + keys.capacity() * sizeof(double) +
+           values.capacity() * sizeof(int);
+}
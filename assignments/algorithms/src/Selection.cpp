@@ -0,0 +1,82 @@
+#include <limits>
+#include "Selection.hpp"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Number of prices sampled to estimate the selection threshold
+ */
+const int thresholdSampleSize = 1024;
+
+/**
+ * Append the indices of all prices at or below a threshold
+ * @param prices Column of prices to scan
+ * @param threshold Largest price to keep
+ * @param candidates Vector to append indices to
+ */
+static void filterAtOrBelow(const std::vector<double> &prices, double threshold, std::vector<int> &candidates) {
+    const double *data = prices.data();
+    int n = (int) prices.size();
+    int i = 0;
+
+#if defined(__AVX2__)
+    __m256d limit = _mm256_set1_pd(threshold);
+    for (; i + 4 <= n; i += 4) {
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + i), limit, _CMP_LE_OQ));
+        for (; mask; mask &= mask - 1) {
+            candidates.push_back(i + __builtin_ctz(mask));
+        }
+    }
+#elif defined(__SSE2__)
+    __m128d limit = _mm_set1_pd(threshold);
+    for (; i + 2 <= n; i += 2) {
+        int mask = _mm_movemask_pd(_mm_cmple_pd(_mm_loadu_pd(data + i), limit));
+        if (mask & 1) candidates.push_back(i);
+        if (mask & 2) candidates.push_back(i + 1);
+    }
+#endif
+
+    // Whatever doesn't fit in a full vector
+    for (; i < n; i++) {
+        if (data[i] <= threshold) candidates.push_back(i);
+    }
+}
+
+std::vector<int> simdFilteredTopK(const std::vector<double> &prices, int k) {
+    int n = (int) prices.size();
+    k = std::min(k, n);
+    if (k <= 0) return {};
+
+    // Estimate the k-th smallest price from an evenly spaced sample, aiming a bit high so one scan is usually enough
+    int sampleSize = std::min(n, thresholdSampleSize);
+    std::vector<double> sample;
+    sample.reserve(sampleSize);
+    for (int i = 0; i < sampleSize; i++) {
+        sample.push_back(prices[(long long) i * n / sampleSize]);
+    }
+    int rank = (int) std::min<long long>(sampleSize - 1, (long long) k * sampleSize / n * 2 + 8);
+
+    std::vector<int> candidates;
+    candidates.reserve(std::min(n, k * 4 + 64));
+    while (true) {
+        std::nth_element(sample.begin(), sample.begin() + rank, sample.end());
+        double threshold = rank == sampleSize - 1 ? std::numeric_limits<double>::infinity() : sample[rank];
+
+        candidates.clear();
+        filterAtOrBelow(prices, threshold, candidates);
+        if (candidates.size() >= (size_t) k) break;
+
+        // Threshold was too low to catch k prices, widen it and scan again
+        rank = std::min(sampleSize - 1, rank * 2 + 1);
+    }
+
+    // Only the candidates need to be selected and sorted
+    auto comparePrices = [&prices](int a, int b) { return prices[a] < prices[b]; };
+    std::nth_element(candidates.begin(), candidates.begin() + (k - 1), candidates.end(), comparePrices);
+    candidates.resize(k);
+    std::sort(candidates.begin(), candidates.end(), comparePrices);
+
+    return candidates;
+}
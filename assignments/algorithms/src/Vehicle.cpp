@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <filesystem>
 #include <utility>
 #include "Vehicle.hpp"
@@ -51,10 +52,29 @@ double Vehicle::getPrice() const {
     return price;
 }
 
+double Vehicle::getMileage() const {
+    return mileage;
+}
+
 std::string Vehicle::getName() const {
     return name;
 }
 
+std::string_view Vehicle::getNameView() const {
+    return name;
+}
+
+double Vehicle::approximateFuelUsageFromKm(double kilometres) const {
+    // Nothing is known about the type of vehicle, so assume it's around the average of 11 km/L and that a
+    // stronger engine is less efficient. Specific types of vehicles have better estimates.
+    double fuelEfficiency = 11.0;
+    fuelEfficiency -= std::clamp((this->horsepower - 100) * 0.02, -2.0, 3.0);
+
+    // Find litres from fuel efficient and km driven using km/(km/L) = L
+    double litresUsed = kilometres / fuelEfficiency;
+    return litresUsed;
+}
+
 std::ostream &operator<<(std::ostream &out, const Vehicle &obj) {
     out << "Vehicle Name: " << obj.name
         << ", Price: $" << formatWithCommas(obj.price)
@@ -7,12 +7,26 @@
  * multithreading in order to speed up the benchmarking processes and utilize
  * the entire CPU.
  *
+ * Running "Algorithms generate [path] [count]" writes a binary dataset of random vehicles to a file instead of
+ * benchmarking. Running "Algorithms [path]" then benchmarks on that dataset if it exists (vehicles.dset by default),
+ * which makes the inputs identical across runs and skips fetching car names. The dataset's checksum is recorded
+ * with every row of the results. Passing "--work-stealing" anywhere runs the benchmarks on BS::work_stealing_pool
+ * instead of BS::thread_pool.
+ *
+ * Alongside the main results in data.csv, indexes.csv compares point-lookup structures on exact price (sorted
+ * arrays, a learned index and several hash maps) by build time, lookup time and memory footprint. selection.csv
+ * times finding the cheapest K vehicles with several selection algorithms against a full sort, for K of 1, 10, 100
+ * and 1% of the array. fleet.csv times sorting a mixed fleet of sedans, pickup trucks and motorcycles by fuel usage,
+ * which is a virtual call, with the key computed in the comparator, cached once per vehicle, and cached with one
+ * devirtualized pass per type of vehicle.
+ *
  * @cite Feng Wang, Colorize, (2020), GitHub repository, https://github.com/fengwang/colorize
  * @cite Niels Lohmann, JSON for Modern C++, (2022), https://github.com/nlohmann/json
  * @cite Barak Shoshany, BS::thread_pool (2023), GitHub repository, https://github.com/bshoshany/thread-pool.git
  * @cite GeeksForGeeks, Binary Search – Data Structure and Algorithm Tutorials, Article, https://www.geeksforgeeks.org/binary-search/
  * @cite GeeksForGeeks, Insertion Sort – Data Structure and Algorithm Tutorials, Article, https://www.geeksforgeeks.org/insertion-sort/
  * @cite GeeksForGeeks, IntroSort or Introspective Sort, Article, https://www.geeksforgeeks.org/introsort-or-introspective-sort/
+ * @cite Jon Bentley & Robert Sedgewick, Fast Algorithms for Sorting and Searching Strings, (1997), SODA '97
  *
  * @author Aritro Saha
  * Last edited: May 17, 2023
@@ -26,6 +40,11 @@
 #define RAND_SEED() srand(time(nullptr))
 #endif
 
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
 #include <iostream>
 #include <vector>
 #include <chrono>
@@ -33,9 +52,21 @@
 #include <nlohmann/json.hpp>
 #include <cpr/cpr.h>
 #include <algorithm>
+#include <random>
+#include <unordered_map>
+#include "Dataset.hpp"
+#include "PriceIndex.hpp"
+#include "Selection.hpp"
+#include "StringSort.hpp"
 #include "Vehicle.hpp"
+#include "vehicles/Motorcycle.hpp"
+#include "vehicles/PickupTruck.hpp"
+#include "vehicles/Sedan.hpp"
 #include "colorize.h"
 #include "BS_thread_pool.hpp"
+#include "BS_work_stealing_pool.hpp"
+#include "BS_task_graph.hpp"
+#include "BS_worker_arena.hpp"
 
 using namespace nlohmann;
 using namespace std::chrono;
@@ -44,10 +75,29 @@ namespace fs = std::filesystem;
 const int numToPrint = 40;
 const int arrSizes[]{5, 10, 100, 1000, 10000, 30000, 50000, 75000};
 const int sampleSize = 200;
+const unsigned int pipelinesPerThread = 4; // Caps how many sort and search samples hold sorted copies at once
+const auto progressInterval = milliseconds(250);
 const std::string dataPath = "data.csv";
+const std::string indexDataPath = "indexes.csv";
+const int lookupsPerSample = 1000;
+const std::string selectionDataPath = "selection.csv";
+const int selectionKs[]{1, 10, 100, -1}; // -1 is 1% of the array size
+const std::string fleetDataPath = "fleet.csv";
+const unsigned int fleetSeed = 4; // Fixed so that the same dataset always turns into the same fleet
+const double fuelKeyKilometres = 100.0;
+const std::string defaultDatasetPath = "vehicles.dset";
+const std::string absentName = "Nonexistent Vehicle 0000";
+const std::string workStealingFlag = "--work-stealing";
+const std::string lockFreeFlag = "--lock-free";
+const std::string elasticFlag = "--elastic";
+const std::string instrumentFlag = "--instrument";
+const std::string schedulerDataPath = "scheduler.json";
 
 json carData;
 
+// Results of timed lookups are written here so the compiler can't optimize the lookups away
+volatile long long lookupSink;
+
 /**
  * Round a value to a specific precision
  * @param value Value to round
@@ -77,6 +127,100 @@ bool compareVehicles(Vehicle* a, Vehicle* b) {
     return getKeyFromVehicle(a) < getKeyFromVehicle(b);
 }
 
+/**
+ * Gets the name of a vehicle as a key. Copies the name, just like Vehicle::getName() does.
+ * @param vehicle Vehicle object to get key from
+ * @return key value
+ */
+std::string getNameFromVehicle(Vehicle* vehicle) {
+    return vehicle->getName();
+}
+
+/**
+ * Gets the name of a vehicle as a key without copying it.
+ * @param vehicle Vehicle object to get key from
+ * @return key value, valid as long as the vehicle is
+ */
+std::string_view getNameViewFromVehicle(Vehicle* vehicle) {
+    return vehicle->getNameView();
+}
+
+/**
+ * Compares the names of two vehicle objects, copying both names on every comparison
+ * @param a first vehicle
+ * @param b second vehicle
+ * @return if a's name < b's name
+ */
+bool compareVehicleNames(Vehicle* a, Vehicle* b) {
+    return getNameFromVehicle(a) < getNameFromVehicle(b);
+}
+
+/**
+ * Compares the names of two vehicle objects without copying them
+ * @param a first vehicle
+ * @param b second vehicle
+ * @return if a's name < b's name
+ */
+bool compareVehicleNameViews(Vehicle* a, Vehicle* b) {
+    return getNameViewFromVehicle(a) < getNameViewFromVehicle(b);
+}
+
+/**
+ * Gets the fuel usage of a vehicle as a key. This is a virtual call, so it can't be inlined.
+ * @param vehicle Vehicle object to get key from
+ * @return key value, in litres per 100 km
+ */
+double getFuelKeyFromVehicle(Vehicle* vehicle) {
+    return vehicle->approximateFuelUsageFromKm(fuelKeyKilometres);
+}
+
+/**
+ * Compares the fuel usage of two vehicle objects, computing both keys on every comparison
+ * @param a first vehicle
+ * @param b second vehicle
+ * @return if a uses less fuel than b
+ */
+bool compareVehicleFuelUsage(Vehicle* a, Vehicle* b) {
+    return getFuelKeyFromVehicle(a) < getFuelKeyFromVehicle(b);
+}
+
+/**
+ * A mixed fleet of vehicles, kept both in one array and grouped by type of vehicle.
+ */
+struct Fleet {
+    std::vector<Vehicle*> all;
+    std::vector<Sedan*> sedans;
+    std::vector<PickupTruck*> pickupTrucks;
+    std::vector<Motorcycle*> motorcycles;
+};
+
+/**
+ * The benchmarks run on every sample, used to tag their results and pick which CSV file they go into.
+ */
+enum Benchmark {
+    SortSearchBenchmark,
+    IndexBenchmark,
+    SelectionBenchmark,
+    FleetBenchmark,
+    BenchmarkCount
+};
+
+/**
+ * A sorted copy of some vehicles, and how long sorting it took.
+ */
+struct SortedVehicles {
+    std::vector<Vehicle*> vehicles;
+    long long duration;
+};
+
+/**
+ * The existing price and name that one sample of the sort and search benchmark looks for.
+ */
+struct SearchTargets {
+    double price;
+    std::string_view name;
+};
+
 /**
  * Print the first and last 20 values of pointers in order with nice formatting
  * @tparam T the type used in the vector
@@ -115,7 +259,7 @@ void printArray(std::vector<T *> &vec) {
  * @return Index of item
  */
 template<class T1, class T2>
-int linearSearch(std::vector<T1>& vec, T2 value, std::function<T2(T1)> extractKey) {
+int linearSearch(const std::vector<T1>& vec, T2 value, std::function<T2(T1)> extractKey) {
     for (int i = 0; i < vec.size(); i++) {
         if (extractKey(vec[i]) == value) {
             return i;
@@ -135,7 +279,7 @@ int linearSearch(std::vector<T1>& vec, T2 value, std::function<T2(T1)> extractKe
  * @return Index of item
  */
 template<class T1, class T2>
-int binarySearch(std::vector<T1>& vec, T2 value, std::function<T2(T1)> extractKey) {
+int binarySearch(const std::vector<T1>& vec, T2 value, std::function<T2(T1)> extractKey) {
     int start = 0, end = vec.size() - 1;
     while (start <= end) {
         int middle = (start + end) / 2;
@@ -153,15 +297,146 @@ int binarySearch(std::vector<T1>& vec, T2 value, std::function<T2(T1)> extractKe
     return -1;
 }
 
+/**
+ * Search for a value using interpolation search. Probes where the value should be if the keys were evenly spread
+ * between the current bounds, which takes O(log log n) on uniformly distributed keys.
+ * @tparam T1 Vector element type
+ * @tparam T2 Element key type, must be arithmetic
+ * @param vec Sorted vector to search
+ * @param value Value to search for
+ * @param extractKey Function to extract key value from
+ * @return Index of item
+ */
+template<class T1, class T2>
+int interpolationSearch(const std::vector<T1>& vec, T2 value, std::function<T2(T1)> extractKey) {
+    int start = 0, end = vec.size() - 1;
+    while (start <= end) {
+        T2 startKey = extractKey(vec[start]), endKey = extractKey(vec[end]);
+        if (value < startKey || value > endKey) {
+            // Outside of the remaining range, can't exist
+            return -1;
+        }
+
+        if (startKey == endKey) {
+            // Every remaining key is the same, avoid dividing by zero
+            return startKey == value ? start : -1;
+        }
+
+        int probe = start + (int) ((double) (value - startKey) / (double) (endKey - startKey) * (end - start));
+        T2 key = extractKey(vec[probe]);
+
+        if (key == value) {
+            return probe;
+        } else if (key < value) {
+            start = probe + 1;
+        } else {
+            end = probe - 1;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Time a batch of lookups.
+ * @tparam F Function type of the lookup
+ * @param keys Keys to look up, in order
+ * @param lookup Function that looks up a key and returns its index (or -1)
+ * @return Average time per lookup in nanoseconds
+ */
+template<class F>
+double timePerLookup(const std::vector<double>& keys, F lookup) {
+    long long found = 0;
+    auto start = high_resolution_clock::now();
+    for (double key : keys) {
+        found += lookup(key);
+    }
+    auto stop = high_resolution_clock::now();
+    lookupSink = found;
+
+    return (double) duration_cast<nanoseconds>(stop - start).count() / (double) keys.size();
+}
+
+/**
+ * Open a CSV file for results to be streamed into as they come in.
+ * @param file Stream to open the file with
+ * @param path Path of the file to (over)write
+ * @param header Header row of the file, without a trailing newline
+ */
+void openResults(std::fstream& file, const std::string& path, const std::string& header) {
+    file.open(path, std::ios::out | std::ios::trunc);
+    file << header << "\n";
+}
+
+/**
+ * Overwrite the current line of the terminal with the progress of the benchmarks.
+ * @param done Number of benchmark tasks that have finished
+ * @param total Total number of benchmark tasks
+ * @param elapsedSeconds Time since the benchmarks started
+ * @param doneBySize Number of finished tasks of each array size, in the same order as arrSizes
+ * @param tasksPerSize Total number of tasks of each array size
+ */
+void printProgress(size_t done, size_t total, double elapsedSeconds, const std::vector<size_t>& doneBySize,
+                   size_t tasksPerSize) {
+    std::stringstream line;
+    line << "\r\033[K" << std::fixed << std::setprecision(1) << 100.0 * (double) done / (double) total << "% ("
+         << done << "/" << total << " tasks), " << (elapsedSeconds > 0 ? (double) done / elapsedSeconds : 0)
+         << " tasks/s, ETA ";
+    if (done == 0) {
+        line << "?";
+    } else {
+        line << (long long) (elapsedSeconds * (double) (total - done) / (double) done) << "s";
+    }
+
+    // Only list the sizes that are partway done, the rest are summed up
+    size_t sizesDone = 0;
+    for (size_t i = 0; i < doneBySize.size(); i++) {
+        if (doneBySize[i] == tasksPerSize) {
+            sizesDone++;
+        } else if (doneBySize[i] > 0) {
+            line << " | " << arrSizes[i] << ": " << 100 * doneBySize[i] / tasksPerSize << "%";
+        }
+    }
+    line << " | " << sizesDone << "/" << doneBySize.size() << " sizes done";
+
+    std::cout << line.str() << std::flush;
+}
+
+/**
+ * Write what a thread pool's instrumentation recorded to a JSON file, and print how much of the time tasks spent in
+ * the pool was spent waiting in the queue rather than running.
+ * @tparam Pool Type of the thread pool
+ * @param pool Thread pool with instrumentation enabled, which gets disabled
+ * @param path Path of the file to (over)write
+ */
+template<class Pool>
+void writeSchedulerReport(Pool& pool, const std::string& path) {
+    pool.disable_instrumentation();
+
+    std::fstream file;
+    file.open(path, std::ios::out | std::ios::trunc);
+    pool.write_instrumentation_json(file);
+    file.close();
+
+    BS::latency_histogram waitTime = pool.get_wait_time_histogram();
+    BS::latency_histogram runTime = pool.get_run_time_histogram();
+    double queuedSeconds = (double) waitTime.sum() / 1e9;
+    double runningSeconds = (double) runTime.sum() / 1e9;
+    double queuedPercent = queuedSeconds + runningSeconds > 0 ? 100 * queuedSeconds / (queuedSeconds + runningSeconds) : 0;
+    std::cout << waitTime.count() << " tasks spent " << queuedSeconds << "s queued and " << runningSeconds
+              << "s running (" << queuedPercent << "% queued, wait p50 " << (double) waitTime.percentile(50) / 1e6
+              << "ms, p99 " << (double) waitTime.percentile(99) / 1e6 << "ms), details in " << path << ".\n";
+}
+
 /**
  * Runs insertion sort on a vector array. Changes the vector in place.
  * @tparam T1 Data type for unsorted vector
+ * @tparam Alloc Allocator type of the vector
  * @param vec Vector to sort
  * @param compareFunc Function to compare one element to another. Should return true if a < b
- * @return A sorted version of the array.
  */
-template<class T1>
-std::vector<T1> insertionSort(std::vector<T1>& vec, std::function<bool(T1 a, T1 b)> compareFunc) {
+template<class T1, class Alloc>
+void insertionSort(std::vector<T1, Alloc>& vec, std::function<bool(T1 a, T1 b)> compareFunc) {
     for (int i = 0; i <= vec.size() - 1; i++) {
         Vehicle* element = vec[i];
         int j = i - 1; // set idx to start comparison with
@@ -174,8 +449,6 @@ std::vector<T1> insertionSort(std::vector<T1>& vec, std::function<bool(T1 a, T1
         // Swap original comparison element to the last swapped element
         vec[j + 1] = element;
     }
-
-    return vec;
 }
 
 /**
@@ -206,29 +479,203 @@ Vehicle* generateRandomVehicle() {
     return new Vehicle(name, price, wheels, doors, seats, mileage, horsepower, maxSpeed);
 }
 
-int main() {
-    // Set the seed for our random number generator
-    RAND_SEED();
+/**
+ * Turns generic vehicles into a mixed fleet of sedans, pickup trucks and motorcycles. Each keeps the name, price,
+ * mileage, horsepower and max speed of the vehicle it came from, and gets random type-specific data from a fixed seed.
+ * @param baseVehicles Vehicles to base the fleet on
+ * @return Fleet with one new vehicle per base vehicle, in the same order
+ */
+Fleet buildMixedFleet(const std::vector<Vehicle*>& baseVehicles) {
+    std::mt19937 rng(fleetSeed);
+    auto randDec = [&rng]() { return std::uniform_real_distribution<double>(0.0, 1.0)(rng); };
+
+    Fleet fleet;
+    fleet.all.reserve(baseVehicles.size());
+    for (Vehicle* base : baseVehicles) {
+        std::string name = base->getName();
+        double price = base->getPrice(), mileage = base->getMileage();
+        double horsepower = base->getHorsepower(), maxSpeed = base->getMaxSpeed();
+
+        switch (rng() % 3) {
+            case 0: {
+                auto sedan = new Sedan(name, price, mileage, horsepower, maxSpeed,
+                                       roundTo(randDec() * 300.0, 0.01), 4 + (int) (rng() % 3) * 2);
+                fleet.sedans.push_back(sedan);
+                fleet.all.push_back(sedan);
+                break;
+            }
+            case 1: {
+                auto pickupTruck = new PickupTruck(name, price, mileage, horsepower, maxSpeed,
+                                                   roundTo(randDec() * 1000.0, 0.01), roundTo(randDec() * 5000.0, 0.01),
+                                                   4 + (int) (rng() % 3) * 2);
+                fleet.pickupTrucks.push_back(pickupTruck);
+                fleet.all.push_back(pickupTruck);
+                break;
+            }
+            default: {
+                auto motorcycle = new Motorcycle(name, price, mileage, horsepower, maxSpeed,
+                                                 roundTo(50.0 + randDec() * 1750.0, 0.01), roundTo(randDec() * 10.0, 0.01),
+                                                 (MOTORCYCLE_TYPE) (rng() % 4));
+                fleet.motorcycles.push_back(motorcycle);
+                fleet.all.push_back(motorcycle);
+            }
+        }
+    }
+
+    return fleet;
+}
 
-    // Thread pool to speed up tasks
-    BS::thread_pool thread_pool;
+/**
+ * Get a fleet made of the first vehicles of another fleet, keeping the grouping by type.
+ * @param fleet Fleet to take vehicles from
+ * @param count Number of vehicles to take
+ * @return Fleet that shares its vehicles with the original
+ */
+Fleet getFleetPrefix(const Fleet& fleet, int count) {
+    Fleet prefix;
+    prefix.all = std::vector<Vehicle*>(fleet.all.begin(), fleet.all.begin() + count);
+    for (Vehicle* vehicle : prefix.all) {
+        if (auto sedan = dynamic_cast<Sedan*>(vehicle)) {
+            prefix.sedans.push_back(sedan);
+        } else if (auto pickupTruck = dynamic_cast<PickupTruck*>(vehicle)) {
+            prefix.pickupTrucks.push_back(pickupTruck);
+        } else if (auto motorcycle = dynamic_cast<Motorcycle*>(vehicle)) {
+            prefix.motorcycles.push_back(motorcycle);
+        }
+    }
 
-    // Fetch the json data for all car names
+    return prefix;
+}
+
+/**
+ * Fetch the json data for all car names into carData.
+ */
+void fetchCarData() {
     cpr::Response res = cpr::Get(cpr::Url{"https://raw.githubusercontent.com/matthlavacka/car-list/master/car-list.json"});
     assert(res.header["content-type"] == "text/plain; charset=utf-8");
     assert(res.status_code == 200);
     carData = json::parse(res.text);
+}
+
+int main(int argc, char* argv[]) {
+    // Set the seed for our random number generator
+    RAND_SEED();
+
+    const int largestArrSize = arrSizes[(sizeof(arrSizes) / sizeof(arrSizes[0])) - 1];
+
+    // Separate flags from the rest of the arguments
+    std::vector<std::string> args;
+    bool useWorkStealing = false;
+    bool useLockFree = false;
+    bool useElastic = false;
+    bool useInstrumentation = false;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i] == workStealingFlag) {
+            useWorkStealing = true;
+        } else if (argv[i] == lockFreeFlag) {
+            useLockFree = true;
+        } else if (argv[i] == elasticFlag) {
+            useElastic = true;
+        } else if (argv[i] == instrumentFlag) {
+            useInstrumentation = true;
+        } else {
+            args.emplace_back(argv[i]);
+        }
+    }
+
+    // Write a dataset file instead of benchmarking if requested
+    if (!args.empty() && args[0] == "generate") {
+        std::string path = args.size() >= 2 ? args[1] : defaultDatasetPath;
+        int count = args.size() >= 3 ? std::stoi(args[2]) : largestArrSize;
+        if (count < largestArrSize) {
+            // The benchmarks take every array from the start of the dataset, so it needs at least the largest one
+            std::cout << "A dataset needs at least " << largestArrSize << " vehicles to run the benchmarks, " << count
+                      << " were requested.\n";
+            return 1;
+        }
+
+        fetchCarData();
+        std::vector<Vehicle*> vehicles;
+        vehicles.reserve(count);
+        for (int i = 0; i < count; i++) {
+            vehicles.push_back(generateRandomVehicle());
+        }
+
+        uint64_t checksum = Dataset::generate(path, vehicles);
+        std::cout << "Wrote " << count << " vehicles to " << path << " (checksum " << std::hex << checksum
+                  << std::dec << ")\n";
+        return 0;
+    }
+
+    // Thread pool to speed up tasks, only the chosen one gets created
+    std::unique_ptr<BS::thread_pool> sharedQueuePool;
+    std::unique_ptr<BS::lock_free_thread_pool> lockFreePool;
+    std::unique_ptr<BS::work_stealing_pool> workStealingPool;
+    if (useWorkStealing) {
+        workStealingPool = std::make_unique<BS::work_stealing_pool>();
+        std::cout << "Using work-stealing thread pool.\n";
+        if (useInstrumentation) {
+            std::cout << instrumentFlag << " only works with the shared queue thread pools, ignoring it.\n";
+            useInstrumentation = false;
+        }
+    } else if (useLockFree) {
+        lockFreePool = useElastic ? std::make_unique<BS::lock_free_thread_pool>(BS::elastic_policy{})
+                                  : std::make_unique<BS::lock_free_thread_pool>();
+        std::cout << "Using " << (useElastic ? "elastic " : "") << "lock-free shared queue thread pool.\n";
+    } else {
+        sharedQueuePool = useElastic ? std::make_unique<BS::thread_pool>(BS::elastic_policy{})
+                                     : std::make_unique<BS::thread_pool>();
+        std::cout << "Using " << (useElastic ? "elastic " : "") << "shared queue thread pool.\n";
+    }
+
+    // All the pools have the same interface, so submitting only has to pick which one
+    auto submitTo = [&](auto& queue, size_t tag, auto& task, int arrSize, int testNum) {
+        if (useWorkStealing) {
+            workStealingPool->submit_to(queue, tag, task, arrSize, testNum);
+        } else if (useLockFree) {
+            lockFreePool->submit_to(queue, tag, task, arrSize, testNum);
+        } else {
+            sharedQueuePool->submit_to(queue, tag, task, arrSize, testNum);
+        }
+    };
+
+    // Benchmarks split into dependent stages go through a task graph on the same pool
+    BS::task_graph graph = useWorkStealing ? BS::task_graph(*workStealingPool)
+                                           : useLockFree ? BS::task_graph(*lockFreePool)
+                                                         : BS::task_graph(*sharedQueuePool);
 
     // Store all the random sets of Vehicles first, don't have to re-gen per thread
     std::map<int, std::vector<Vehicle*>> randomVehiclesSet;
 
-    // Only generate a random set of Vehicles for the largest array size
-    const int largestArrSize = arrSizes[(sizeof(arrSizes) / sizeof(arrSizes[0])) - 1];
-    randomVehiclesSet[largestArrSize] = std::vector<Vehicle*>();
-    randomVehiclesSet[largestArrSize].reserve(largestArrSize);
-    for (int i = 0; i < largestArrSize; i++) {
-        randomVehiclesSet[largestArrSize].push_back(generateRandomVehicle());
+    // Only get a set of Vehicles for the largest array size, preferring a dataset file so runs are repeatable
+    std::string datasetPath = !args.empty() ? args[0] : defaultDatasetPath;
+    std::string datasetChecksum = "random";
+    auto setupStart = high_resolution_clock::now();
+    bool loadedDataset = false;
+    if (fs::exists(datasetPath)) {
+        Dataset dataset(datasetPath);
+        if (dataset.size() >= (size_t) largestArrSize) {
+            randomVehiclesSet[largestArrSize] = dataset.buildVehicles(largestArrSize);
+            datasetChecksum = dataset.getChecksumHex();
+            loadedDataset = true;
+        } else {
+            std::cout << datasetPath << " only has " << dataset.size() << " vehicles, but " << largestArrSize
+                      << " are needed. Generating random vehicles instead.\n";
+        }
+    } else {
+        std::cout << datasetPath << " does not exist, generating random vehicles instead.\n";
     }
+    if (!loadedDataset) {
+        fetchCarData();
+        randomVehiclesSet[largestArrSize] = std::vector<Vehicle*>();
+        randomVehiclesSet[largestArrSize].reserve(largestArrSize);
+        for (int i = 0; i < largestArrSize; i++) {
+            randomVehiclesSet[largestArrSize].push_back(generateRandomVehicle());
+        }
+    }
+    auto setupStop = high_resolution_clock::now();
+    std::cout << "Set up " << largestArrSize << " vehicles (dataset " << datasetChecksum << ") in "
+              << duration_cast<milliseconds>(setupStop - setupStart).count() << "ms.\n";
 
     // Fill the rest of the arrays by getting subsets of the largest array
     for (int i = 0; i < (sizeof(arrSizes) / sizeof(arrSizes[0])) - 1; i++) {
@@ -239,134 +686,572 @@ int main() {
         );
     }
 
-    auto runBenchmarkOnArrSize = [&](int arrSize, int testNum) {
-        std::stringstream ss("");
+    // Same idea for the mixed fleets, only the largest one is built from scratch
+    std::map<int, Fleet> fleets;
+    fleets[largestArrSize] = buildMixedFleet(randomVehiclesSet[largestArrSize]);
+    for (size_t i = 0; i < (sizeof(arrSizes) / sizeof(arrSizes[0])) - 1; i++) {
+        fleets[arrSizes[i]] = getFleetPrefix(fleets[largestArrSize], arrSizes[i]);
+    }
 
-        // Generate necessary number of vehicles
+    // The sort and search benchmark is split into a graph of stages per sample. Every sort copies the vehicles and runs
+    // as its own stage, and the searches that need sorted vehicles run as soon as their sort is done. Stages of
+    // different samples overlap, and nothing in the pool ever blocks waiting on another stage.
+    auto addSortSearchPipeline = [&](int arrSize, int testNum) {
         std::vector<Vehicle*>& vehicles = randomVehiclesSet[arrSize];
 
-        // Cloned so we don't have to generate vehicles for each sample
-        std::vector<Vehicle*> sortedVehicles{vehicles};
-        std::vector<Vehicle*> builtInSortedVehicles{vehicles};
+        // Copy the vehicles into the worker's arena and time sorting the copy with the given sort. Both the copy and
+        // any scratch space the sort needs are freed at once when the stage ends, so only use this if nothing else
+        // needs the sorted vehicles.
+        auto arenaSortStage = [&vehicles](auto sort) {
+            return [&vehicles, sort] {
+                BS::worker_arena::scope arena;
+                std::pmr::vector<Vehicle*> sorted(vehicles.begin(), vehicles.end(), arena.resource());
+                auto start = high_resolution_clock::now();
+                sort(sorted);
+                auto stop = high_resolution_clock::now();
+                return (long long) duration_cast<nanoseconds>(stop - start).count();
+            };
+        };
+
+        // Same, but keep the sorted copy on the heap for the stages that search it
+        auto sortStage = [&vehicles](auto sort) {
+            return [&vehicles, sort] {
+                SortedVehicles sorted{vehicles, 0};
+                auto start = high_resolution_clock::now();
+                sort(sorted.vehicles);
+                auto stop = high_resolution_clock::now();
+                sorted.duration = duration_cast<nanoseconds>(stop - start).count();
+                return sorted;
+            };
+        };
+        auto getSortDuration = [](const SortedVehicles& sorted) { return sorted.duration; };
+
+        // Pick an existing price and name to look for
+        BS::task_future<SearchTargets> targets = graph.submit([&vehicles] {
+            return SearchTargets{vehicles[rand() % vehicles.size()]->getPrice(),
+                                 vehicles[rand() % vehicles.size()]->getNameView()};
+        });
+
+        // Run linear searches on the unsorted array for an existing and an absent object
+        auto unsortedSearchDurations = targets.then([&vehicles](const SearchTargets& target) {
+            auto start = high_resolution_clock::now();
+            linearSearch<Vehicle*, double>(vehicles, target.price, getKeyFromVehicle);
+            auto stop = high_resolution_clock::now();
+            auto existingDuration = duration_cast<nanoseconds>(stop - start).count();
+
+            start = high_resolution_clock::now();
+            linearSearch<Vehicle*, double>(vehicles, 1.0e10, getKeyFromVehicle);
+            stop = high_resolution_clock::now();
+            auto nonExistingDuration = duration_cast<nanoseconds>(stop - start).count();
+
+            return std::array<long long, 2>{existingDuration, nonExistingDuration};
+        });
+
+        // Sort the entire array using insertion sort
+        auto insertionSortDuration = graph.submit(arenaSortStage([](auto& sorted) {
+            insertionSort<Vehicle*>(sorted, compareVehicles);
+        }));
 
-        // Run a linear search for an existing object
-        double valToLookFor = sortedVehicles[rand() % vehicles.size()]->getPrice();
+        // Sort the entire array using func from STD
+        BS::task_future<SortedVehicles> builtInSorted = graph.submit(sortStage([](std::vector<Vehicle*>& sorted) {
+            std::sort(sorted.begin(), sorted.end(), compareVehicles);
+        }));
+        auto builtInSortDuration = builtInSorted.then(getSortDuration);
+
+        // Run linear and binary searches on the sorted array for an existing and an absent object
+        auto sortedSearchDurations = graph.add_node([builtInSorted, targets] {
+            const std::vector<Vehicle*>& sorted = builtInSorted.get().vehicles;
+            double valToLookFor = targets.get().price;
+
+            auto start = high_resolution_clock::now();
+            linearSearch<Vehicle*, double>(sorted, valToLookFor, getKeyFromVehicle);
+            auto stop = high_resolution_clock::now();
+            auto existingLinearDuration = duration_cast<nanoseconds>(stop - start).count();
+
+            start = high_resolution_clock::now();
+            linearSearch<Vehicle*, double>(sorted, 1.0e10, getKeyFromVehicle);
+            stop = high_resolution_clock::now();
+            auto nonExistingLinearDuration = duration_cast<nanoseconds>(stop - start).count();
+
+            start = high_resolution_clock::now();
+            binarySearch<Vehicle*, double>(sorted, valToLookFor, getKeyFromVehicle);
+            stop = high_resolution_clock::now();
+            auto existingBinaryDuration = duration_cast<nanoseconds>(stop - start).count();
+
+            start = high_resolution_clock::now();
+            binarySearch<Vehicle*, double>(sorted, 1.0e10, getKeyFromVehicle);
+            stop = high_resolution_clock::now();
+            auto nonExistingBinaryDuration = duration_cast<nanoseconds>(stop - start).count();
+
+            return std::array<long long, 4>{existingLinearDuration, nonExistingLinearDuration,
+                                            existingBinaryDuration, nonExistingBinaryDuration};
+        }, builtInSorted, targets);
+
+        // Sort by name using getName(), which copies both names on every comparison
+        auto copyingNameSortDuration = graph.submit(arenaSortStage([](auto& sorted) {
+            std::sort(sorted.begin(), sorted.end(), compareVehicleNames);
+        }));
+
+        // Sort by name using views of the names, the difference from above is the cost of the copies
+        BS::task_future<SortedVehicles> nameSorted = graph.submit(sortStage([](std::vector<Vehicle*>& sorted) {
+            std::sort(sorted.begin(), sorted.end(), compareVehicleNameViews);
+        }));
+        auto nameSortDuration = nameSorted.then(getSortDuration);
+
+        // Sort by name using MSD radix sort
+        auto msdRadixSortDuration = graph.submit(arenaSortStage([](auto& sorted) {
+            msdRadixSort(sorted, getNameViewFromVehicle);
+        }));
+
+        // Sort by name using multikey quicksort
+        auto multikeyQuicksortDuration = graph.submit(arenaSortStage([](auto& sorted) {
+            multikeyQuicksort(sorted, getNameViewFromVehicle);
+        }));
+
+        // Sort by name using cached 8-byte prefixes
+        auto prefixSortDuration = graph.submit(arenaSortStage([](auto& sorted) {
+            prefixSort(sorted, getNameViewFromVehicle);
+        }));
+
+        // Run binary searches on the name-sorted array for an existing and an absent name
+        auto nameSearchDurations = graph.add_node([nameSorted, targets] {
+            const std::vector<Vehicle*>& sorted = nameSorted.get().vehicles;
+
+            auto start = high_resolution_clock::now();
+            binarySearch<Vehicle*, std::string_view>(sorted, targets.get().name, getNameViewFromVehicle);
+            auto stop = high_resolution_clock::now();
+            auto existingDuration = duration_cast<nanoseconds>(stop - start).count();
+
+            start = high_resolution_clock::now();
+            binarySearch<Vehicle*, std::string_view>(sorted, absentName, getNameViewFromVehicle);
+            stop = high_resolution_clock::now();
+            auto nonExistingDuration = duration_cast<nanoseconds>(stop - start).count();
+
+            return std::array<long long, 2>{existingDuration, nonExistingDuration};
+        }, nameSorted, targets);
+
+        // Push all our CSV data into a row once every stage is done
+        return graph.add_node([=] {
+            BS::worker_arena::scope arena;
+            std::basic_ostringstream<char, std::char_traits<char>, std::pmr::polymorphic_allocator<char>> ss(
+                    std::ios_base::out, arena.resource());
+            ss << arrSize << ","
+               << testNum << ","
+               << unsortedSearchDurations.get()[0] << ","
+               << unsortedSearchDurations.get()[1] << ","
+               << insertionSortDuration.get() << ","
+               << builtInSortDuration.get() << ","
+               << sortedSearchDurations.get()[0] << ","
+               << sortedSearchDurations.get()[1] << ","
+               << sortedSearchDurations.get()[2] << ","
+               << sortedSearchDurations.get()[3] << ","
+               << copyingNameSortDuration.get() << ","
+               << nameSortDuration.get() << ","
+               << copyingNameSortDuration.get() - nameSortDuration.get() << ","
+               << msdRadixSortDuration.get() << ","
+               << multikeyQuicksortDuration.get() << ","
+               << prefixSortDuration.get() << ","
+               << nameSearchDurations.get()[0] << ","
+               << nameSearchDurations.get()[1] << ","
+               << datasetChecksum << "\n";
+
+            // Copy it out of the arena into a string before returning
+            return std::string(ss.view());
+        }, unsortedSearchDurations, insertionSortDuration, builtInSortDuration, sortedSearchDurations,
+           copyingNameSortDuration, nameSortDuration, msdRadixSortDuration, multikeyQuicksortDuration,
+           prefixSortDuration, nameSearchDurations);
+    };
+
+    auto runIndexBenchmarkOnArrSize = [&](int arrSize, int testNum) {
+        std::stringstream ss("");
+        std::vector<Vehicle*>& vehicles = randomVehiclesSet[arrSize];
+
+        // Pick the keys to look up ahead of time. Prices are rounded to the cent, so half a cent off never exists.
+        std::vector<double> existingKeys, absentKeys;
+        existingKeys.reserve(lookupsPerSample);
+        absentKeys.reserve(lookupsPerSample);
+        for (int i = 0; i < lookupsPerSample; i++) {
+            existingKeys.push_back(vehicles[rand() % vehicles.size()]->getPrice());
+            absentKeys.push_back(existingKeys.back() + 0.005);
+        }
+
+        // Adds a row of results for one structure
+        auto addRow = [&](const std::string& structure, long long buildDuration, double existingLookup,
+                          double absentLookup, size_t memoryUsage) {
+            ss << arrSize << ","
+               << testNum << ","
+               << structure << ","
+               << buildDuration << ","
+               << existingLookup << ","
+               << absentLookup << ","
+               << memoryUsage << ","
+               << datasetChecksum << "\n";
+        };
+
+        // Sorted array of vehicles, shared by binary and interpolation search
         auto start = high_resolution_clock::now();
-        linearSearch<Vehicle*, double>(vehicles, valToLookFor, getKeyFromVehicle);
+        std::vector<Vehicle*> sortedVehicles{vehicles};
+        std::sort(sortedVehicles.begin(), sortedVehicles.end(), compareVehicles);
         auto stop = high_resolution_clock::now();
-        auto existingLinearSearchBeforeSortDuration = duration_cast<nanoseconds>(stop - start).count();
+        auto sortedArrayBuildDuration = duration_cast<nanoseconds>(stop - start).count();
+        size_t sortedArrayMemory = sortedVehicles.capacity() * sizeof(Vehicle*);
 
-        // Run a linear search for an object that doesn't exist
-        start = high_resolution_clock::now();
-        linearSearch<Vehicle*, double>(vehicles, 1.0e10, getKeyFromVehicle);
-        stop = high_resolution_clock::now();
-        auto nonExistingLinearSearchBeforeSortDuration = duration_cast<nanoseconds>(stop - start).count();
+        addRow("Binary Search", sortedArrayBuildDuration,
+               timePerLookup(existingKeys, [&](double key) { return binarySearch<Vehicle*, double>(sortedVehicles, key, getKeyFromVehicle); }),
+               timePerLookup(absentKeys, [&](double key) { return binarySearch<Vehicle*, double>(sortedVehicles, key, getKeyFromVehicle); }),
+               sortedArrayMemory);
 
-        // Sort the entire array using insertion sort
+        addRow("Interpolation Search", sortedArrayBuildDuration,
+               timePerLookup(existingKeys, [&](double key) { return interpolationSearch<Vehicle*, double>(sortedVehicles, key, getKeyFromVehicle); }),
+               timePerLookup(absentKeys, [&](double key) { return interpolationSearch<Vehicle*, double>(sortedVehicles, key, getKeyFromVehicle); }),
+               sortedArrayMemory);
+
+        // Learned index, built on top of the sorted array's price column
         start = high_resolution_clock::now();
-        insertionSort<Vehicle*>(sortedVehicles, compareVehicles);
+        std::vector<double> sortedPrices;
+        sortedPrices.reserve(sortedVehicles.size());
+        for (Vehicle* vehicle : sortedVehicles) {
+            sortedPrices.push_back(vehicle->getPrice());
+        }
+        LearnedIndex learnedIndex(sortedPrices);
         stop = high_resolution_clock::now();
-        auto insertionSortDuration = duration_cast<nanoseconds>(stop - start).count();
+        auto learnedIndexBuildDuration = sortedArrayBuildDuration + duration_cast<nanoseconds>(stop - start).count();
 
-        // Sort the entire array using func from STD
+        addRow("Learned Index", learnedIndexBuildDuration,
+               timePerLookup(existingKeys, [&](double key) { return learnedIndex.find(key); }),
+               timePerLookup(absentKeys, [&](double key) { return learnedIndex.find(key); }),
+               sortedArrayMemory + learnedIndex.memoryUsage());
+
+        // Hash maps from exact price to index in the unsorted array
         start = high_resolution_clock::now();
-        std::sort(builtInSortedVehicles.begin(), builtInSortedVehicles.end(), compareVehicles);
+        OpenAddressingPriceMap openAddressingMap(vehicles.size());
+        for (size_t i = 0; i < vehicles.size(); i++) {
+            openAddressingMap.insert(vehicles[i]->getPrice(), (int) i);
+        }
         stop = high_resolution_clock::now();
-        auto builtInSortDuration = duration_cast<nanoseconds>(stop - start).count();
 
-        // Run a linear search on the sorted array for an existing object
+        addRow("Open Addressing Hash Map", duration_cast<nanoseconds>(stop - start).count(),
+               timePerLookup(existingKeys, [&](double key) { return openAddressingMap.find(key); }),
+               timePerLookup(absentKeys, [&](double key) { return openAddressingMap.find(key); }),
+               openAddressingMap.memoryUsage());
+
         start = high_resolution_clock::now();
-        linearSearch<Vehicle*, double>(builtInSortedVehicles, valToLookFor, getKeyFromVehicle);
+        SwissPriceMap swissMap(vehicles.size());
+        for (size_t i = 0; i < vehicles.size(); i++) {
+            swissMap.insert(vehicles[i]->getPrice(), (int) i);
+        }
         stop = high_resolution_clock::now();
-        auto existingLinearSearchAfterSortDuration = duration_cast<nanoseconds>(stop - start).count();
 
-        // Run a linear search for an object that doesn't exist
+        addRow("Swiss Table Hash Map", duration_cast<nanoseconds>(stop - start).count(),
+               timePerLookup(existingKeys, [&](double key) { return swissMap.find(key); }),
+               timePerLookup(absentKeys, [&](double key) { return swissMap.find(key); }),
+               swissMap.memoryUsage());
+
         start = high_resolution_clock::now();
-        linearSearch<Vehicle*, double>(builtInSortedVehicles, 1.0e10, getKeyFromVehicle);
+        std::unordered_map<double, int> unorderedMap;
+        unorderedMap.reserve(vehicles.size());
+        for (size_t i = 0; i < vehicles.size(); i++) {
+            unorderedMap.try_emplace(vehicles[i]->getPrice(), (int) i);
+        }
         stop = high_resolution_clock::now();
-        auto nonExistingLinearSearchAfterSortDuration = duration_cast<nanoseconds>(stop - start).count();
 
-        // Run a binary search on the sorted array for an existing object
+        // Estimate: the bucket array plus one node (next pointer and value) per element
+        size_t unorderedMapMemory = unorderedMap.bucket_count() * sizeof(void*) +
+                                    unorderedMap.size() * (sizeof(void*) + sizeof(std::pair<const double, int>));
+
+        auto findInUnorderedMap = [&](double key) {
+            auto it = unorderedMap.find(key);
+            return it == unorderedMap.end() ? -1 : it->second;
+        };
+        addRow("std::unordered_map", duration_cast<nanoseconds>(stop - start).count(),
+               timePerLookup(existingKeys, findInUnorderedMap), timePerLookup(absentKeys, findInUnorderedMap),
+               unorderedMapMemory);
+
+        return ss.str();
+    };
+
+    auto runSelectionBenchmarkOnArrSize = [&](int arrSize, int testNum) {
+        std::stringstream ss("");
+        std::vector<Vehicle*>& vehicles = randomVehiclesSet[arrSize];
+
+        // Price column for the SIMD engine, like one mapped straight from a dataset
+        std::vector<double> prices;
+        prices.reserve(vehicles.size());
+        for (Vehicle* vehicle : vehicles) {
+            prices.push_back(vehicle->getPrice());
+        }
+
+        for (int k : selectionKs) {
+            std::string kLabel = k == -1 ? "1%" : std::to_string(k);
+            if (k == -1) k = std::max(1, arrSize / 100);
+            if (k > arrSize) continue;
+
+            // Every engine finds the k cheapest vehicles in ascending order of price
+            auto addRow = [&](const std::string& engine, long long duration) {
+                ss << arrSize << ","
+                   << testNum << ","
+                   << engine << ","
+                   << kLabel << ","
+                   << k << ","
+                   << duration << ","
+                   << datasetChecksum << "\n";
+            };
+
+            // Full sort, which is what we'd be doing without selection
+            std::vector<Vehicle*> fullSortedVehicles{vehicles};
+            auto start = high_resolution_clock::now();
+            std::sort(fullSortedVehicles.begin(), fullSortedVehicles.end(), compareVehicles);
+            auto stop = high_resolution_clock::now();
+            addRow("Full Sort", duration_cast<nanoseconds>(stop - start).count());
+
+            std::vector<Vehicle*> partialSortedVehicles{vehicles};
+            start = high_resolution_clock::now();
+            std::partial_sort(partialSortedVehicles.begin(), partialSortedVehicles.begin() + k,
+                              partialSortedVehicles.end(), compareVehicles);
+            stop = high_resolution_clock::now();
+            addRow("std::partial_sort", duration_cast<nanoseconds>(stop - start).count());
+
+            std::vector<Vehicle*> nthElementVehicles{vehicles};
+            start = high_resolution_clock::now();
+            std::nth_element(nthElementVehicles.begin(), nthElementVehicles.begin() + (k - 1),
+                             nthElementVehicles.end(), compareVehicles);
+            std::sort(nthElementVehicles.begin(), nthElementVehicles.begin() + k, compareVehicles);
+            stop = high_resolution_clock::now();
+            addRow("std::nth_element", duration_cast<nanoseconds>(stop - start).count());
+
+            start = high_resolution_clock::now();
+            std::vector<Vehicle*> heapSelectedVehicles = boundedHeapSelect(vehicles, k, compareVehicles);
+            stop = high_resolution_clock::now();
+            addRow("Bounded Heap", duration_cast<nanoseconds>(stop - start).count());
+
+            std::vector<Vehicle*> quickselectedVehicles{vehicles};
+            start = high_resolution_clock::now();
+            quickselect(quickselectedVehicles, k - 1, compareVehicles);
+            std::sort(quickselectedVehicles.begin(), quickselectedVehicles.begin() + k, compareVehicles);
+            stop = high_resolution_clock::now();
+            addRow("Quickselect", duration_cast<nanoseconds>(stop - start).count());
+
+            start = high_resolution_clock::now();
+            std::vector<int> topIndices = simdFilteredTopK(prices, k);
+            std::vector<Vehicle*> simdSelectedVehicles;
+            simdSelectedVehicles.reserve(k);
+            for (int idx : topIndices) {
+                simdSelectedVehicles.push_back(vehicles[idx]);
+            }
+            stop = high_resolution_clock::now();
+            addRow("SIMD Filtered Top-K", duration_cast<nanoseconds>(stop - start).count());
+
+            // Every engine should agree on the k-th cheapest price
+            [[maybe_unused]] double kthPrice = fullSortedVehicles[k - 1]->getPrice();
+            assert(partialSortedVehicles[k - 1]->getPrice() == kthPrice);
+            assert(nthElementVehicles[k - 1]->getPrice() == kthPrice);
+            assert(heapSelectedVehicles[k - 1]->getPrice() == kthPrice);
+            assert(quickselectedVehicles[k - 1]->getPrice() == kthPrice);
+            assert(simdSelectedVehicles[k - 1]->getPrice() == kthPrice);
+        }
+
+        return ss.str();
+    };
+
+    auto runFleetBenchmarkOnArrSize = [&](int arrSize, int testNum) {
+        std::stringstream ss("");
+        Fleet& fleet = fleets[arrSize];
+
+        // Key computed in the comparator, so every comparison makes two virtual calls
+        std::vector<Vehicle*> comparatorSortedVehicles{fleet.all};
+        auto start = high_resolution_clock::now();
+        std::sort(comparatorSortedVehicles.begin(), comparatorSortedVehicles.end(), compareVehicleFuelUsage);
+        auto stop = high_resolution_clock::now();
+        auto comparatorSortDuration = duration_cast<nanoseconds>(stop - start).count();
+
+        // Decorate-sort-undecorate: one virtual call per vehicle, then comparisons only look at the cached keys
+        std::vector<Vehicle*> cachedKeySortedVehicles{fleet.all};
         start = high_resolution_clock::now();
-        binarySearch<Vehicle*, double>(builtInSortedVehicles, valToLookFor, getKeyFromVehicle);
+        std::vector<std::pair<double, Vehicle*>> decorated;
+        decorated.reserve(cachedKeySortedVehicles.size());
+        for (Vehicle* vehicle : cachedKeySortedVehicles) {
+            decorated.emplace_back(getFuelKeyFromVehicle(vehicle), vehicle);
+        }
+        std::sort(decorated.begin(), decorated.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (size_t i = 0; i < decorated.size(); i++) {
+            cachedKeySortedVehicles[i] = decorated[i].second;
+        }
         stop = high_resolution_clock::now();
-        auto existingBinarySearchAfterSortDuration = duration_cast<nanoseconds>(stop - start).count();
+        auto cachedKeySortDuration = duration_cast<nanoseconds>(stop - start).count();
 
-        // Run a binary search for an object that doesn't exist
+        // Same as above, but the keys are computed one type at a time. Every type is final, so the compiler knows
+        // exactly which function is called and can inline it into a tight loop.
+        std::vector<Vehicle*> devirtualizedSortedVehicles(fleet.all.size());
         start = high_resolution_clock::now();
-        binarySearch<Vehicle*, double>(builtInSortedVehicles, 1.0e10, getKeyFromVehicle);
+        std::vector<std::pair<double, Vehicle*>> typedDecorated;
+        typedDecorated.reserve(fleet.all.size());
+        for (Sedan* sedan : fleet.sedans) {
+            typedDecorated.emplace_back(sedan->approximateFuelUsageFromKm(fuelKeyKilometres), sedan);
+        }
+        for (PickupTruck* pickupTruck : fleet.pickupTrucks) {
+            typedDecorated.emplace_back(pickupTruck->approximateFuelUsageFromKm(fuelKeyKilometres), pickupTruck);
+        }
+        for (Motorcycle* motorcycle : fleet.motorcycles) {
+            typedDecorated.emplace_back(motorcycle->approximateFuelUsageFromKm(fuelKeyKilometres), motorcycle);
+        }
+        std::sort(typedDecorated.begin(), typedDecorated.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (size_t i = 0; i < typedDecorated.size(); i++) {
+            devirtualizedSortedVehicles[i] = typedDecorated[i].second;
+        }
         stop = high_resolution_clock::now();
-        auto nonExistingBinarySearchAfterSortDuration = duration_cast<nanoseconds>(stop - start).count();
-        
-        // Push all our CSV data into the stream
+        auto devirtualizedSortDuration = duration_cast<nanoseconds>(stop - start).count();
+
+        // Ties can be in any order, but the keys should line up exactly
+        for (size_t i = 0; i < fleet.all.size(); i++) {
+            assert(getFuelKeyFromVehicle(cachedKeySortedVehicles[i]) == getFuelKeyFromVehicle(comparatorSortedVehicles[i]));
+            assert(getFuelKeyFromVehicle(devirtualizedSortedVehicles[i]) == getFuelKeyFromVehicle(comparatorSortedVehicles[i]));
+        }
+
         ss << arrSize << ","
            << testNum << ","
-           << existingLinearSearchBeforeSortDuration << ","
-           << nonExistingLinearSearchBeforeSortDuration << ","
-           << insertionSortDuration << ","
-           << builtInSortDuration << ","
-           << existingLinearSearchAfterSortDuration << ","
-           << nonExistingLinearSearchAfterSortDuration << ","
-           << existingBinarySearchAfterSortDuration << ","
-           << nonExistingBinarySearchAfterSortDuration << "\n";
-
-        // Turn it into a string from a stream before returning
+           << fleet.sedans.size() << ","
+           << fleet.pickupTrucks.size() << ","
+           << fleet.motorcycles.size() << ","
+           << comparatorSortDuration << ","
+           << cachedKeySortDuration << ","
+           << devirtualizedSortDuration << ","
+           << datasetChecksum << "\n";
+
         return ss.str();
     };
-    
-    // Vector to store all futures
-    std::vector<std::future<std::string>> futures;
-    
+
+    // Record how long every task waits in the queue and runs, only while benchmarking
+    if (useInstrumentation) {
+        if (useLockFree) {
+            lockFreePool->enable_instrumentation();
+        } else {
+            sharedQueuePool->enable_instrumentation();
+        }
+    }
+
     // Start the timer
     auto start = high_resolution_clock::now();
 
-    // Generate all the tasks for the thread pool
-    for (const int arrSize : arrSizes) {
-        for (int testNum = 1; testNum <= sampleSize; testNum++) {
-            futures.push_back(thread_pool.submit(runBenchmarkOnArrSize, arrSize, testNum));
+    // Results are streamed into their CSV files as they come in, so a long run can be looked at before it's done
+    std::array<std::fstream, BenchmarkCount> resultFiles;
+    openResults(resultFiles[SortSearchBenchmark], dataPath,
+                 "Object Count,"
+                 "Test #,"
+                 "Unsorted Existing Linear Search,"
+                 "Unsorted Absent Linear Search,"
+                 "Insertion Sort,"
+                 "Built-in Sort,"
+                 "Sorted Existing Linear Search,"
+                 "Sorted Absent Linear Search,"
+                 "Existing Binary Search,"
+                 "Absent Binary Search,"
+                 "Name Sort (getName copies),"
+                 "Name Sort (string_view),"
+                 "Name Copy Overhead,"
+                 "Name MSD Radix Sort,"
+                 "Name Multikey Quicksort,"
+                 "Name Prefix Sort,"
+                 "Existing Name Binary Search,"
+                 "Absent Name Binary Search,"
+                 "Dataset");
+    openResults(resultFiles[IndexBenchmark], indexDataPath,
+                 "Object Count,"
+                 "Test #,"
+                 "Structure,"
+                 "Build,"
+                 "Existing Lookup (avg),"
+                 "Absent Lookup (avg),"
+                 "Memory (bytes),"
+                 "Dataset");
+    openResults(resultFiles[SelectionBenchmark], selectionDataPath,
+                 "Object Count,"
+                 "Test #,"
+                 "Engine,"
+                 "K,"
+                 "K (elements),"
+                 "Duration,"
+                 "Dataset");
+    openResults(resultFiles[FleetBenchmark], fleetDataPath,
+                 "Object Count,"
+                 "Test #,"
+                 "Sedans,"
+                 "Pickup Trucks,"
+                 "Motorcycles,"
+                 "Virtual Key Comparator Sort,"
+                 "Cached Key Sort,"
+                 "Devirtualized Cached Key Sort,"
+                 "Dataset");
+
+    // Every task reports back through one completion queue as soon as it finishes, tagged with its sample and which
+    // benchmark it is, so results are handled in the order they finish instead of the order they were submitted
+    BS::completion_queue<std::string> completed;
+    const size_t arrSizeCount = sizeof(arrSizes) / sizeof(arrSizes[0]);
+    const size_t sampleCount = arrSizeCount * sampleSize;
+    const size_t tasksPerSize = (size_t) sampleSize * BenchmarkCount;
+    const size_t totalTasks = sampleCount * BenchmarkCount;
+    std::vector<size_t> doneBySize(arrSizeCount, 0);
+    size_t nextSample = 0, done = 0;
+    auto lastProgress = high_resolution_clock::now();
+
+    // Sort and search pipelines that haven't finished yet, so that only a few samples hold sorted copies at once
+    size_t pipelinesInFlight = 0;
+    const size_t maxPipelinesInFlight = std::max(1u, std::thread::hardware_concurrency()) * pipelinesPerThread;
+
+    while (done < totalTasks) {
+        // Keep generating samples for the thread pool until too many pipelines would be in flight
+        for (; nextSample < sampleCount && pipelinesInFlight < maxPipelinesInFlight; nextSample++) {
+            const int arrSize = arrSizes[nextSample / sampleSize];
+            const int testNum = (int) (nextSample % sampleSize) + 1;
+            const size_t tag = nextSample * BenchmarkCount;
+            addSortSearchPipeline(arrSize, testNum).notify(completed, tag + SortSearchBenchmark);
+            submitTo(completed, tag + IndexBenchmark, runIndexBenchmarkOnArrSize, arrSize, testNum);
+            submitTo(completed, tag + SelectionBenchmark, runSelectionBenchmarkOnArrSize, arrSize, testNum);
+            submitTo(completed, tag + FleetBenchmark, runFleetBenchmarkOnArrSize, arrSize, testNum);
+            pipelinesInFlight++;
+        }
+
+        // Handle whichever task finishes next, but wake up regularly to keep the progress line moving
+        std::optional<BS::completion_queue<std::string>::completion> next = completed.pop_for(progressInterval);
+        if (next) {
+            const size_t benchmark = next->tag % BenchmarkCount;
+            std::string row = next->result.get();
+            resultFiles[benchmark] << row;
+            if (benchmark == SortSearchBenchmark) {
+                pipelinesInFlight--;
+                std::cout << "\r\033[K" << row;
+            }
+            doneBySize[next->tag / BenchmarkCount / sampleSize]++;
+            done++;
+        }
+
+        auto now = high_resolution_clock::now();
+        if (now - lastProgress >= progressInterval || done == totalTasks) {
+            for (std::fstream& file : resultFiles) {
+                file.flush();
+            }
+            printProgress(done, totalTasks, duration_cast<duration<double>>(now - start).count(), doneBySize,
+                          tasksPerSize);
+            lastProgress = now;
         }
     }
+    std::cout << "\n";
 
-    // Wait for all of their results
-    std::vector<std::string> results;
-    for (auto& future : futures) {
-        future.wait();
-        std::string tmp(future.get());
-        results.push_back(tmp);
-        // std::cout << tmp; // Removed to improve performance
+    for (std::fstream& file : resultFiles) {
+        file.close();
     }
 
     // Get stop time and calculate total duration
     auto stop = high_resolution_clock::now();
     auto totalDuration = duration_cast<seconds>(stop - start).count();
 
-    // Set up CSV file
-    std::fstream file;
-    file.open(dataPath, std::ios::out | std::ios::trunc);
-
-    // Setup file header
-    file << "Object Count,"
-         << "Test #,"
-         << "Unsorted Existing Linear Search,"
-         << "Unsorted Absent Linear Search,"
-         << "Insertion Sort,"
-         << "Built-in Sort,"
-         << "Sorted Existing Linear Search,"
-         << "Sorted Absent Linear Search,"
-         << "Existing Binary Search,"
-         << "Absent Binary Search"
-         << "\n";
-
-    // Push all futures into file
-    for (const auto& str : results) {
-        std::cout << str;
-        file << str;
-    }
-
-    // Close file
-    file.close();
-
     std::cout << "Complete, took " << totalDuration << "s.\n";
+    if (useInstrumentation) {
+        if (useLockFree) {
+            writeSchedulerReport(*lockFreePool, schedulerDataPath);
+        } else {
+            writeSchedulerReport(*sharedQueuePool, schedulerDataPath);
+        }
+    }
 
     return 0;
 }
@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <utility>
+#include "vehicles/Motorcycle.hpp"
+
+Motorcycle::Motorcycle(std::string name, double price, double mileage, double horsepower, double maxSpeed,
+                       double engineSize, double maxAcceleration, MOTORCYCLE_TYPE motorcycleType)
+        : Vehicle(std::move(name), price, 2, 0, 1, mileage, horsepower, maxSpeed) {
+    this->engineSize = engineSize;
+    this->maxAcceleration = maxAcceleration;
+    this->motorcycleType = motorcycleType;
+}
+
+double Motorcycle::getEngineSize() const {
+    return engineSize;
+}
+
+double Motorcycle::getMaxAcceleration() const {
+    return maxAcceleration;
+}
+
+MOTORCYCLE_TYPE Motorcycle::getMotorcycleType() const {
+    return motorcycleType;
+}
+
+double Motorcycle::approximateFuelUsageFromKm(double kilometres) const {
+    // Average fuel efficiency depends on the type of motorcycle, we can predict that a stronger engine is
+    // less efficient. It will also need more fuel to accelerate faster.
+    // These are just ballpark equations.
+    double fuelEfficiency = 0;
+    switch (motorcycleType) {
+        case SPORT: fuelEfficiency = 38.3; break;
+        case CRUISER: fuelEfficiency = 25.5; break;
+        case SCOOTER: fuelEfficiency = 29.76; break;
+        case TOURING: fuelEfficiency = 22.9;
+    }
+
+    fuelEfficiency -= std::clamp((engineSize - 100) * 0.012, 0.0, 9.0);
+    fuelEfficiency -= std::clamp(maxAcceleration * 0.5, 0.0, 3.5);
+
+    // Find litres from fuel efficient and km driven using km/(km/L) = L
+    double litresUsed = kilometres / fuelEfficiency;
+    return litresUsed;
+}
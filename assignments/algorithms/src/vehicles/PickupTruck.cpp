@@ -0,0 +1,37 @@
+#include <algorithm>
+#include <utility>
+#include "vehicles/PickupTruck.hpp"
+
+PickupTruck::PickupTruck(std::string name, double price, double mileage, double horsepower, double maxSpeed,
+                         double bedCapacity, double towingMaxLoad, int engineCylinderCount)
+        : Vehicle(std::move(name), price, 4, 2, 2, mileage, horsepower, maxSpeed) {
+    this->bedCapacity = bedCapacity;
+    this->towingMaxLoad = towingMaxLoad;
+    this->engineCylinderCount = engineCylinderCount;
+}
+
+double PickupTruck::getBedCapacity() const {
+    return bedCapacity;
+}
+
+double PickupTruck::getTowingMaxLoad() const {
+    return towingMaxLoad;
+}
+
+int PickupTruck::getEngineCylinderCount() const {
+    return engineCylinderCount;
+}
+
+double PickupTruck::approximateFuelUsageFromKm(double kilometres) const {
+    // Average fuel efficiency for most pickup trucks is around 8.76 km/L, we can predict that a stronger engine is
+    // less efficient. It will also need more fuel to push more weight in its trunk.
+    // These are just ballpark equations, fuel efficiency depends on a lot of more factors.
+    double fuelEfficiency = 8.76;
+    fuelEfficiency -= std::clamp((this->engineCylinderCount - 4) * 0.6, -2.0, 3.2);
+    fuelEfficiency -= std::clamp((this->bedCapacity) * 0.01, 0.0, 2.0);
+    fuelEfficiency -= std::clamp((this->towingMaxLoad / 2) * 0.01, 0.0, 2.0);
+
+    // Find litres from fuel efficient and km driven using km/(km/L) = L
+    double litresUsed = kilometres / fuelEfficiency;
+    return litresUsed;
+}
@@ -0,0 +1,31 @@
+#include <algorithm>
+#include <utility>
+#include "vehicles/Sedan.hpp"
+
+Sedan::Sedan(std::string name, double price, double mileage, double horsepower, double maxSpeed,
+             double trunkCapacity, int engineCylinderCount) : Vehicle(std::move(name), price, 4, 4, 5, mileage,
+                                                                      horsepower, maxSpeed) {
+    this->trunkCapacity = trunkCapacity;
+    this->engineCylinderCount = engineCylinderCount;
+}
+
+double Sedan::getTrunkCapacity() const {
+    return trunkCapacity;
+}
+
+int Sedan::getEngineCylinderCount() const {
+    return engineCylinderCount;
+}
+
+double Sedan::approximateFuelUsageFromKm(double kilometres) const {
+    // Average fuel efficiency for most sedans is around 13.6 km/L, we can predict that a stronger engine is
+    // less efficient. It will also need more fuel to push more weight in its trunk.
+    // These are just ballpark equations, fuel efficiency depends on a lot of more factors.
+    double fuelEfficiency = 13.6;
+    fuelEfficiency -= std::clamp((this->engineCylinderCount - 4) * 0.6, -2.0, 3.2);
+    fuelEfficiency -= std::clamp((this->trunkCapacity) * 0.01, 0.0, 2.0);
+
+    // Find litres from fuel efficient and km driven using km/(km/L) = L
+    double litresUsed = kilometres / fuelEfficiency;
+    return litresUsed;
+}
@@ -0,0 +1,120 @@
+/**
+ * Name: Storage Format Benchmarker
+ * Description: Compares the storage formats that entities can be saved in. For each number of vehicles, the same mix of
+ * sedans, pickup trucks and motorcycles is put through every format:
+ *  - Save: encode every vehicle and write them all into a snapshot (JSON is streamed out without a JSON document)
+ *  - Load: read the snapshot back in and stream every vehicle straight into its object
+ *  - Size: size of the snapshot file
+ * Results are printed and written to storage-benchmark.csv, with one row per format and number of vehicles.
+ * The numbers of vehicles default to 10k, 100k and 1M, and can be given as arguments instead.
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "EntityReader.hpp"
+#include "SnapshotStore.hpp"
+#include "StorageFormat.hpp"
+#include "vehicles/Motorcycle.hpp"
+#include "vehicles/PickupTruck.hpp"
+#include "vehicles/Sedan.hpp"
+
+using namespace std::chrono;
+namespace fs = std::filesystem;
+
+const std::string resultsPath = "storage-benchmark.csv";
+const std::string snapshotPath = "storage-benchmark.bin";
+const std::vector<size_t> defaultCounts{10000, 100000, 1000000};
+const StorageFormat formats[]{StorageFormat::JSON, StorageFormat::CBOR, StorageFormat::MessagePack, StorageFormat::BSON};
+
+/**
+ * Make a mix of vehicles, a third of each type
+ * @param count number of vehicles to make
+ * @return the vehicles, which need to be deleted
+ */
+std::vector<Vehicle *> makeVehicles(size_t count) {
+    std::vector<Vehicle *> vehicles;
+    vehicles.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        std::string name = "Vehicle " + std::to_string(i);
+        double price = 10000.0 + (double) (i % 90000);
+        if (i % 3 == 0) {
+            vehicles.push_back(new Sedan(name, price, "Honda", (double) (i % 200000), 180, 210, 400, 4, "red"));
+        } else if (i % 3 == 1) {
+            vehicles.push_back(new PickupTruck(name, price, "Ford", (double) (i % 200000), 400, 180, 1000, 5000, 8,
+                                               "blue"));
+        } else {
+            vehicles.push_back(new Motorcycle(name, price, "Yamaha", (double) (i % 200000), 120, 250, "black", 1.0, 9.8,
+                                              SPORT));
+        }
+    }
+
+    return vehicles;
+}
+
+/**
+ * Get the milliseconds since a point in time
+ * @param start the point in time
+ * @return milliseconds since then
+ */
+double millisecondsSince(steady_clock::time_point start) {
+    return duration<double, std::milli>(steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; i++) {
+        counts.push_back(std::stoull(argv[i]));
+    }
+    if (counts.empty()) {
+        counts = defaultCounts;
+    }
+
+    std::ofstream results(resultsPath);
+    results << "format,vehicles,save_ms,load_ms,bytes\n";
+    std::cout << std::left << std::setw(10) << "Format" << std::setw(10) << "Vehicles" << std::setw(12) << "Save (ms)"
+              << std::setw(12) << "Load (ms)" << "Size (bytes)\n";
+
+    for (size_t count: counts) {
+        std::vector<Vehicle *> vehicles = makeVehicles(count);
+
+        for (StorageFormat format: formats) {
+            storageFormat = format;
+
+            auto start = steady_clock::now();
+            SnapshotWriter writer;
+            std::string encoded;
+            for (Vehicle *vehicle: vehicles) {
+                writer.add(EntityKind::Vehicle, vehicle->getUUID(), encodeEntity(*vehicle, format, encoded), format);
+            }
+            writer.write(snapshotPath);
+            double saveMs = millisecondsSince(start);
+            uintmax_t bytes = fs::file_size(snapshotPath);
+
+            start = steady_clock::now();
+            SnapshotStore store(snapshotPath);
+            std::string buffer;
+            for (const SnapshotEntry &entry: store.getEntries()) {
+                delete EntityReader::readVehicle(store.readBytes(entry, buffer), entry.format);
+            }
+            double loadMs = millisecondsSince(start);
+
+            std::string name = getStorageFormatName(format);
+            results << name << "," << count << "," << saveMs << "," << loadMs << "," << bytes << "\n";
+            std::cout << std::setw(10) << name << std::setw(10) << count << std::setw(12) << std::fixed
+                      << std::setprecision(1) << saveMs << std::setw(12) << loadMs << bytes << "\n";
+        }
+
+        for (Vehicle *vehicle: vehicles) {
+            delete vehicle;
+        }
+    }
+
+    fs::remove(snapshotPath);
+    std::cout << "Results written to " << resultsPath << "\n";
+    return 0;
+}
@@ -2,6 +2,8 @@
 
 #include <string>
 #include <nlohmann/json.hpp>
+#include "JsonWriter.hpp"
+#include "Uuid.hpp"
 
 using json = nlohmann::json;
 
@@ -27,7 +29,7 @@ public:
      * @param depositLimit the maximum amount available to deposit at once
      * @param uuid the UUID of the object, used in saving and identifying instances
      */
-    BankAccount(double startingBalance, double minBalance, double withdrawLimit, double depositLimit, std::string uuid);
+    BankAccount(double startingBalance, double minBalance, double withdrawLimit, double depositLimit, Uuid uuid);
 
     /**
      * Constructor for BankAccount, which assumes a starting and minimum balance of 0 and auto-generates a UUID.
@@ -46,7 +48,18 @@ public:
      * Gets the UUID of the instance
      * @return UUID of instance
      */
-    std::string getUUID() const;
+    Uuid getUUID() const;
+
+    /**
+     * Check whether the account has changed since it was last saved or loaded
+     * @return if the account needs to be saved
+     */
+    bool isDirty() const;
+
+    /**
+     * Mark the account as matching what's saved
+     */
+    void markClean();
 
     /**
      * Attempt to withdraw a certain amount of money from the account
@@ -100,6 +113,12 @@ public:
      */
     json serializeToJSON();
 
+    /**
+     * Write all the data in the class straight into a JSON writer, without building it as JSON first.
+     * @param writer the writer to write into
+     */
+    void writeJSON(JsonWriter &writer) const;
+
     /**
      * Deserialize all the data from a JSON file into an instance of BankAccount.
      * @param data the JSON data to deserialize
@@ -127,5 +146,6 @@ private:
     double minBalance;
     double withdrawLimit;
     double depositLimit;
-    std::string uuid;
+    Uuid uuid;
+    bool dirty;
 };
\ No newline at end of file
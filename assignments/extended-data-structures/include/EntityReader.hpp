@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "StorageFormat.hpp"
+#include "Uuid.hpp"
+
+using json = nlohmann::json;
+
+class Person;
+class Vehicle;
+class VehicleCache;
+class VehicleDealership;
+
+/**
+ * Reads entities straight from their encoded bytes, without building a JSON document for them first. The bytes are
+ * streamed through nlohmann's SAX parser in any storage format, each key is looked up in a perfect hash table of every
+ * field an entity can have, and each value is stored straight into its field. Once the whole entity is read, it's
+ * constructed by the constructor registered for its type.
+ */
+class EntityReader {
+public:
+    /**
+     * Read a vehicle of any type
+     * @param bytes the encoded vehicle
+     * @param format the format it's encoded in
+     * @return pointer to the new Vehicle
+     * @throws runtime_error if the bytes are malformed, a field is missing or the type is unknown
+     */
+    static Vehicle *readVehicle(std::string_view bytes, StorageFormat format);
+
+    /**
+     * Read a person and their bank account. Vehicles that don't exist are skipped with a warning.
+     * @param bytes the encoded person
+     * @param format the format it's encoded in
+     * @param vehicleCache the cache to check their vehicles exist in
+     * @return pointer to the new Person
+     * @throws runtime_error if the bytes are malformed or a field is missing
+     */
+    static Person *readPerson(std::string_view bytes, StorageFormat format, const VehicleCache &vehicleCache);
+
+    /**
+     * Read a dealership and its bank account. Vehicles that don't exist are skipped with a warning.
+     * @param bytes the encoded dealership
+     * @param format the format it's encoded in
+     * @param vehicleCache the cache to check its vehicles exist in
+     * @return pointer to the new VehicleDealership
+     * @throws runtime_error if the bytes are malformed or a field is missing
+     */
+    static VehicleDealership *readDealership(std::string_view bytes, StorageFormat format,
+                                             const VehicleCache &vehicleCache);
+
+    /**
+     * Every field an entity can have. The bank account's UUID gets its own field, since it shares its key with the
+     * UUID of the entity that owns it.
+     */
+    enum class Field : uint8_t {
+        uuid, name, price, wheels, doors, seats, maxPassengers, maxSpeed, manufacturer, mileage, horsepower, started,
+        color, type, trunkCapacity, engineCylinderCount, bedCapacity, towingMaxLoad, engineSize, maxAcceleration,
+        motorcycleType, firstName, middleName, lastName, birthTimestamp, height, bankAccount, vehicles, balance,
+        minBalance, withdrawLimit, depositLimit, bankAccountUUID, unknown
+    };
+
+    // SAX events, called by nlohmann::json::sax_parse
+    bool null();
+    bool boolean(bool value);
+    bool number_integer(json::number_integer_t value);
+    bool number_unsigned(json::number_unsigned_t value);
+    bool number_float(json::number_float_t value, const std::string &text);
+    bool string(std::string &value);
+    bool binary(json::binary_t &value);
+    bool start_object(std::size_t elements);
+    bool key(std::string &key);
+    bool end_object();
+    bool start_array(std::size_t elements);
+    bool end_array();
+    bool parse_error(std::size_t position, const std::string &lastToken, const nlohmann::detail::exception &error);
+
+private:
+    static constexpr size_t fieldCount = (size_t) Field::unknown;
+
+    /**
+     * Constructor for a vehicle type, from the fields that were read
+     */
+    using VehicleConstructor = Vehicle *(*)(EntityReader &reader);
+
+    /**
+     * A type of vehicle that can be read
+     */
+    struct VehicleType {
+        std::string_view name;
+        uint64_t requiredFields;
+        VehicleConstructor construct;
+    };
+
+    /**
+     * Every type of vehicle that can be read, by the name stored in its type field
+     */
+    static const VehicleType vehicleTypes[];
+
+    /**
+     * Stream an entity's bytes through the parser into the fields
+     * @param bytes the encoded entity
+     * @param format the format it's encoded in
+     * @throws runtime_error if the bytes are malformed
+     */
+    void parse(std::string_view bytes, StorageFormat format);
+
+    /**
+     * Check that every required field was read
+     * @param requiredFields bit mask of the fields that are required
+     * @throws runtime_error naming the first field that's missing
+     */
+    void require(uint64_t requiredFields) const;
+
+    /**
+     * Store a number into the current field
+     * @param value the number
+     * @return true, to keep parsing
+     * @throws runtime_error if the current field isn't a number
+     */
+    bool storeNumber(double value);
+
+    /**
+     * Get a number that was read
+     * @param field the field
+     * @return the number
+     */
+    double number(Field field) const;
+
+    /**
+     * Take a string that was read
+     * @param field the field
+     * @return the string, moved out of the reader
+     */
+    std::string &&takeString(Field field);
+
+    /**
+     * Read a UUID out of a string that was read
+     * @param field the field
+     * @return the UUID
+     * @throws runtime_error if the string isn't a UUID
+     */
+    Uuid parseUuid(Field field) const;
+
+    template<class T>
+    static Vehicle *constructVehicle(EntityReader &reader);
+
+    std::array<double, fieldCount> numbers{};
+    std::array<std::string, fieldCount> strings;
+    std::vector<Uuid> vehicles;
+    uint64_t seen = 0;
+
+    Field current = Field::unknown;
+    int depth = 0;
+    int skipDepth = 0;
+    bool inBankAccount = false;
+    bool inVehicles = false;
+};
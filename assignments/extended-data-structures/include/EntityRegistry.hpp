@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "FlatUuidMap.hpp"
+#include "Uuid.hpp"
+
+class Person;
+class VehicleDealership;
+
+/**
+ * Keeps track of every person and dealership in memory, both in the order they're listed in and indexed by UUID, so
+ * that either can be found straight away. Vehicles are indexed the same way by the vehicle cache. Everything that adds
+ * or removes a person or dealership goes through here, which keeps the lists and the indices in sync.
+ */
+class EntityRegistry {
+public:
+    /**
+     * Make room for a number of people and dealerships, so adding that many doesn't have to grow anything
+     * @param personCount # of people
+     * @param dealershipCount # of dealerships
+     */
+    void reserve(size_t personCount, size_t dealershipCount);
+
+    /**
+     * Add a person to the end of the list
+     * @param person pointer to the person
+     */
+    void add(Person *person);
+
+    /**
+     * Add a dealership to the end of the list
+     * @param dealership pointer to the dealership
+     */
+    void add(VehicleDealership *dealership);
+
+    /**
+     * Add many people to the end of the list at once, growing the list and index only once
+     * @param newPeople pointers to the people
+     */
+    void addAll(const std::vector<Person *> &newPeople);
+
+    /**
+     * Add many dealerships to the end of the list at once, growing the list and index only once
+     * @param newDealerships pointers to the dealerships
+     */
+    void addAll(const std::vector<VehicleDealership *> &newDealerships);
+
+    /**
+     * Remove a person, keeping the order of everyone else
+     * @param person pointer to the person
+     * @return if the person was in the registry
+     */
+    bool remove(Person *person);
+
+    /**
+     * Remove a dealership, keeping the order of the others
+     * @param dealership pointer to the dealership
+     * @return if the dealership was in the registry
+     */
+    bool remove(VehicleDealership *dealership);
+
+    /**
+     * Find a person by their UUID
+     * @param uuid the UUID of the person
+     * @return pointer to the person, nullptr if they don't exist
+     */
+    Person *findPerson(const Uuid &uuid) const;
+
+    /**
+     * Find a dealership by its UUID
+     * @param uuid the UUID of the dealership
+     * @return pointer to the dealership, nullptr if it doesn't exist
+     */
+    VehicleDealership *findDealership(const Uuid &uuid) const;
+
+    /**
+     * Get every person, in the order they were added
+     * @return pointers to the people
+     */
+    const std::vector<Person *> &getPeople() const;
+
+    /**
+     * Get every dealership, in the order they were added
+     * @return pointers to the dealerships
+     */
+    const std::vector<VehicleDealership *> &getDealerships() const;
+
+private:
+    std::vector<Person *> people;
+    std::vector<VehicleDealership *> dealerships;
+    FlatUuidMap<Person *> peopleIndex;
+    FlatUuidMap<VehicleDealership *> dealershipIndex;
+};
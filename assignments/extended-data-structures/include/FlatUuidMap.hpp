@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "Uuid.hpp"
+
+/**
+ * A hash map from UUIDs to values, stored in one flat array with open addressing. A key is found by probing the slots
+ * after its hash one at a time, so a lookup is usually a single cache miss instead of the chain of nodes a
+ * std::unordered_map follows. The nil UUID marks an empty slot, so it can't be used as a key.
+ * Lookups are safe to do from multiple threads at once, as long as nothing is inserting or erasing.
+ * @tparam T type of the values, which needs to be default constructible
+ */
+template<class T>
+class FlatUuidMap {
+public:
+    /**
+     * Make room for a number of keys, so inserting that many doesn't have to grow the map
+     * @param count # of keys
+     */
+    void reserve(size_t count) {
+        // Kept at most 3/4 full, so that probes stay short
+        size_t needed = std::bit_ceil(std::max<size_t>(count + count / 3 + 1, 8));
+        if (needed > slots.size()) {
+            rehash(needed);
+        }
+    }
+
+    /**
+     * Insert a key, or replace its value if it's already in the map
+     * @param key the key
+     * @param value the value
+     * @return if the key is new
+     * @throws runtime_error if the key is the nil UUID
+     */
+    bool insert(const Uuid &key, T value) {
+        if (key.isNil()) {
+            throw std::runtime_error("The nil UUID can't be used as a key");
+        }
+        if ((count + 1) * 4 > slots.size() * 3) {
+            reserve(count + 1);
+        }
+
+        size_t idx = findSlot(key);
+        bool isNew = slots[idx].key.isNil();
+        slots[idx].key = key;
+        slots[idx].value = std::move(value);
+        count += isNew;
+        return isNew;
+    }
+
+    /**
+     * Find the value of a key
+     * @param key the key
+     * @return pointer to the value, nullptr if the key isn't in the map. Only valid until the map is changed.
+     */
+    T *find(const Uuid &key) {
+        return const_cast<T *>(std::as_const(*this).find(key));
+    }
+
+    /**
+     * Find the value of a key
+     * @param key the key
+     * @return pointer to the value, nullptr if the key isn't in the map. Only valid until the map is changed.
+     */
+    const T *find(const Uuid &key) const {
+        if (slots.empty()) {
+            return nullptr;
+        }
+
+        const Slot &slot = slots[findSlot(key)];
+        return slot.key.isNil() ? nullptr : &slot.value;
+    }
+
+    /**
+     * Check whether a key is in the map
+     * @param key the key
+     * @return if the key is in the map
+     */
+    bool contains(const Uuid &key) const {
+        return find(key) != nullptr;
+    }
+
+    /**
+     * Remove a key from the map
+     * @param key the key
+     * @return if the key was in the map
+     */
+    bool erase(const Uuid &key) {
+        if (slots.empty()) {
+            return false;
+        }
+
+        size_t idx = findSlot(key);
+        if (slots[idx].key.isNil()) {
+            return false;
+        }
+
+        // Shift later keys in the same run back into the gap, so no probe ever stops early at it
+        size_t mask = slots.size() - 1;
+        size_t next = (idx + 1) & mask;
+        while (!slots[next].key.isNil()) {
+            size_t home = slots[next].key.hash() & mask;
+            if (((next - home) & mask) >= ((next - idx) & mask)) {
+                slots[idx] = std::move(slots[next]);
+                idx = next;
+            }
+            next = (next + 1) & mask;
+        }
+        slots[idx] = Slot();
+        count--;
+        return true;
+    }
+
+    /**
+     * Remove every key from the map, keeping its capacity
+     */
+    void clear() {
+        std::fill(slots.begin(), slots.end(), Slot());
+        count = 0;
+    }
+
+    /**
+     * Get the number of keys in the map
+     * @return # of keys
+     */
+    size_t size() const {
+        return count;
+    }
+
+    /**
+     * Call a function with every key and value in the map, in no particular order
+     * @tparam F type of the function
+     * @param function the function, which takes the key and the value
+     */
+    template<class F>
+    void forEach(F &&function) const {
+        for (const Slot &slot: slots) {
+            if (!slot.key.isNil()) {
+                function(slot.key, slot.value);
+            }
+        }
+    }
+
+private:
+    /**
+     * A key and its value, or the nil UUID if the slot is empty
+     */
+    struct Slot {
+        Uuid key;
+        T value{};
+    };
+
+    /**
+     * Find the slot a key is in, or the empty slot it would go in. There's always an empty slot, since the map is
+     * never full.
+     * @param key the key
+     * @return index of the slot
+     */
+    size_t findSlot(const Uuid &key) const {
+        size_t mask = slots.size() - 1;
+        size_t idx = key.hash() & mask;
+        while (!slots[idx].key.isNil() && slots[idx].key != key) {
+            idx = (idx + 1) & mask;
+        }
+
+        return idx;
+    }
+
+    /**
+     * Move every key into a new array of slots
+     * @param capacity # of slots, a power of 2
+     */
+    void rehash(size_t capacity) {
+        std::vector<Slot> oldSlots(capacity);
+        oldSlots.swap(slots);
+        for (Slot &slot: oldSlots) {
+            if (!slot.key.isNil()) {
+                slots[findSlot(slot.key)] = std::move(slot);
+            }
+        }
+    }
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Uuid.hpp"
+
+/**
+ * Writes JSON straight into a buffer as it's given each key and value, without building a JSON document first. The
+ * output is either compact, or indented by 4 spaces the same way as json::dump(4). Numbers are written with
+ * std::to_chars, in their shortest form that reads back as the same value.
+ */
+class JsonWriter {
+public:
+    /**
+     * Constructor for JsonWriter, which appends to a buffer. Clear the buffer first to reuse it.
+     * @param buffer the buffer to append to
+     * @param pretty whether to indent the output
+     */
+    explicit JsonWriter(std::string &buffer, bool pretty = false);
+
+    /**
+     * Start an object, as a value or at the top level
+     * @return this writer
+     */
+    JsonWriter &beginObject();
+
+    /**
+     * End the current object
+     * @return this writer
+     */
+    JsonWriter &endObject();
+
+    /**
+     * Start an array, as a value or at the top level
+     * @return this writer
+     */
+    JsonWriter &beginArray();
+
+    /**
+     * End the current array
+     * @return this writer
+     */
+    JsonWriter &endArray();
+
+    /**
+     * Write the key of the next value in the current object
+     * @param key the key
+     * @return this writer
+     */
+    JsonWriter &key(std::string_view key);
+
+    /**
+     * Write a string value
+     * @param value the string, escaped as needed
+     * @return this writer
+     */
+    JsonWriter &value(std::string_view value);
+
+    /**
+     * Write a string value
+     * @param value the string, escaped as needed
+     * @return this writer
+     */
+    JsonWriter &value(const char *value);
+
+    /**
+     * Write a UUID as a string value, in its text form
+     * @param value the UUID
+     * @return this writer
+     */
+    JsonWriter &value(const Uuid &value);
+
+    /**
+     * Write a floating point value. Whole numbers keep a trailing ".0" so they read back as floating point, and
+     * infinities and NaN are written as null like json::dump() does.
+     * @param value the number
+     * @return this writer
+     */
+    JsonWriter &value(double value);
+
+    /**
+     * Write an integer value
+     * @param value the number
+     * @return this writer
+     */
+    JsonWriter &value(int64_t value);
+
+    /**
+     * Write an integer value
+     * @param value the number
+     * @return this writer
+     */
+    JsonWriter &value(int value);
+
+    /**
+     * Write a boolean value
+     * @param value the boolean
+     * @return this writer
+     */
+    JsonWriter &value(bool value);
+
+    /**
+     * Write a key and its value in the current object
+     * @tparam T type of the value
+     * @param name the key
+     * @param value the value
+     * @return this writer
+     */
+    template<class T>
+    JsonWriter &field(std::string_view name, const T &value) {
+        key(name);
+        return this->value(value);
+    }
+
+private:
+    /**
+     * Write whatever has to come before a value or key: a comma after the previous element, and a new line when
+     * indenting. Nothing is needed right after a key.
+     */
+    void beforeElement();
+
+    /**
+     * Start a new line, indented to the current depth
+     */
+    void newLine();
+
+    std::string &buffer;
+    bool pretty;
+    bool afterKey = false;
+    std::vector<bool> hasElements;
+};
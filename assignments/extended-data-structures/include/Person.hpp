@@ -5,10 +5,12 @@
 #include <nlohmann/json.hpp>
 #include "BankAccount.hpp"
 #include "include/vehicles/Vehicle.hpp"
+#include "VehicleRef.hpp"
 
 using json = nlohmann::json;
 
 class Vehicle;
+class VehicleCache;
 
 /**
  * A class that represents a person.
@@ -38,7 +40,7 @@ public:
      * @param uuid UUID of the instance
      */
     Person(std::string firstName, std::string middleName, std::string lastName, int64_t birthTimestamp, double height,
-           BankAccount *bankAccount, std::string uuid);
+           BankAccount *bankAccount, Uuid uuid);
 
     /**
      * Get the Person's first name
@@ -85,6 +87,28 @@ public:
      */
     int64_t getBirthTimestamp() const;
 
+    /**
+     * Get the UUID of the Person
+     * @return UUID of the Person
+     */
+    Uuid getUUID() const;
+
+    /**
+     * Check whether the person or its bank account has changed since it was last saved or loaded
+     * @return if the person needs to be saved
+     */
+    bool isDirty() const;
+
+    /**
+     * Mark the person as changed, needed after editing its vehicle list directly
+     */
+    void markDirty();
+
+    /**
+     * Mark the person and its bank account as matching what's saved
+     */
+    void markClean();
+
 
     bool changeHeight(double delta);
 
@@ -104,14 +128,20 @@ public:
      */
     json serializeToJSON();
 
+    /**
+     * Write all the data in the class straight into a JSON writer, without building it as JSON first.
+     * @param writer the writer to write into
+     */
+    void writeJSON(JsonWriter &writer) const;
+
     /**
      * Deserialize all the data from a JSON file into an instance of Person.
      * @param data the JSON data to deserialize
-     * @param vehicleUUIDsToPointers a map of UUIDs to Vehicle pointers loaded in from their folders
+     * @param vehicleCache the cache of vehicles, used to check that owned vehicles exist
      * @return a new Person instance made using the JSON data.
      * @throws runtime_error if required key does not exist
      */
-    static Person deserializeFromJSON(const json &data, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers);
+    static Person deserializeFromJSON(const json &data, const VehicleCache &vehicleCache);
 
     /**
      * Save the data in the instance as a JSON file in its expected location.
@@ -122,22 +152,22 @@ public:
     /**
      * Loads in a Person instance from a file given its UUID
      * @param uuid the UUID of the object
-     * @param vehicleUUIDsToPointers a map of UUIDs to Vehicle pointers loaded in from their folders
+     * @param vehicleCache the cache of vehicles, used to check that owned vehicles exist
      * @return An instance of the deserialized Person from the JSON file
      * @throws runtime_error if a file with the UUID does not exist
      */
-    static Person loadFromUUID(std::string uuid, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers);
+    static Person loadFromUUID(const Uuid &uuid, const VehicleCache &vehicleCache);
 
     /**
      * Loads in a Person instance from a file given its path
      * @param path the path of the serialized instance
-     * @param vehicleUUIDsToPointers a map of UUIDs to Vehicle pointers loaded in from their folders
+     * @param vehicleCache the cache of vehicles, used to check that owned vehicles exist
      * @return An instance of the deserialized Person from the JSON file
      * @throws runtime_error if a file does not exist at given path
      */
-    static Person loadFromPath(std::string path, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers);
+    static Person loadFromPath(std::string path, const VehicleCache &vehicleCache);
 
-    std::vector<Vehicle *> vehicles;
+    std::vector<VehicleRef> vehicles;
     BankAccount *bankAccount;
 
     /**
@@ -161,6 +191,7 @@ private:
     std::string lastName;
     int64_t birthTimestamp;
     double height;
-    std::string uuid;
+    Uuid uuid;
+    bool dirty;
 };
 
@@ -0,0 +1,70 @@
+#pragma once
+
+class Vehicle;
+class VehicleCache;
+
+/**
+ * A vehicle that's kept in memory for as long as this exists. The pointers handed out by the vehicle cache are only
+ * safe to use until the next vehicle is loaded, since that can evict them. Hold one of these instead whenever a vehicle
+ * is used across other lookups in the cache. An empty one refers to no vehicle.
+ */
+class PinnedVehicle {
+public:
+    /**
+     * Constructor for PinnedVehicle, which refers to no vehicle.
+     */
+    PinnedVehicle() = default;
+
+    PinnedVehicle(const PinnedVehicle &) = delete;
+    PinnedVehicle &operator=(const PinnedVehicle &) = delete;
+
+    PinnedVehicle(PinnedVehicle &&other) noexcept;
+    PinnedVehicle &operator=(PinnedVehicle &&other) noexcept;
+
+    /**
+     * Destructor for PinnedVehicle, which lets the cache evict the vehicle again.
+     */
+    ~PinnedVehicle();
+
+    /**
+     * Get the vehicle
+     * @return pointer to the vehicle, nullptr if this is empty
+     */
+    Vehicle *get() const;
+
+    /**
+     * Access the vehicle
+     * @return pointer to the vehicle
+     */
+    Vehicle *operator->() const;
+
+    /**
+     * Access the vehicle
+     * @return reference to the vehicle
+     */
+    Vehicle &operator*() const;
+
+    /**
+     * Check whether this refers to a vehicle
+     * @return if it isn't empty
+     */
+    explicit operator bool() const;
+
+private:
+    friend class VehicleCache;
+
+    /**
+     * Constructor for PinnedVehicle, only used by the cache once it has pinned the vehicle.
+     * @param cache the cache the vehicle is pinned in
+     * @param vehicle pointer to the vehicle
+     */
+    PinnedVehicle(VehicleCache *cache, Vehicle *vehicle);
+
+    /**
+     * Unpin the vehicle, if there is one, leaving this empty
+     */
+    void release();
+
+    VehicleCache *cache = nullptr;
+    Vehicle *vehicle = nullptr;
+};
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "FlatUuidMap.hpp"
+#include "StorageFormat.hpp"
+#include "Uuid.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * The kinds of entities that can be stored in a snapshot.
+ */
+enum class EntityKind : uint8_t {
+    Vehicle,
+    Person,
+    Dealership
+};
+
+/**
+ * Get the folder under the data folder that entities of a kind are saved in with the one-file-per-entity layout.
+ * @param kind the kind of entity
+ * @return name of the folder (ex. "vehicles")
+ */
+std::string getEntityFolder(EntityKind kind);
+
+/**
+ * Header at the start of every snapshot file. All values are stored in the host's byte order.
+ */
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint64_t indexOffset;
+    uint64_t indexSize;
+    uint64_t indexChecksum;
+    uint64_t logSequence;
+};
+
+/**
+ * Where one entity is stored in a snapshot file.
+ */
+struct SnapshotEntry {
+    EntityKind kind;
+    StorageFormat format;
+    Uuid uuid;
+    uint64_t offset;
+    uint32_t size;
+    uint64_t checksum;
+};
+
+/**
+ * Builds or updates a snapshot file. A new snapshot is built in memory and written out in one go. An existing snapshot
+ * is updated in place: only the entities that were added or replaced are appended to the end of the file, followed by
+ * a new index, and the header is rewritten last to point at it. The space taken by replaced and removed entities is
+ * reclaimed by rewriting the whole file once it makes up more than half of it.
+ */
+class SnapshotWriter {
+public:
+    /**
+     * Constructor for SnapshotWriter, which starts an empty snapshot.
+     */
+    SnapshotWriter();
+
+    /**
+     * Constructor for SnapshotWriter, which continues an existing snapshot. Only its header and index are read.
+     * @param path path of the snapshot file
+     * @throws runtime_error if the file does not exist or is malformed
+     */
+    explicit SnapshotWriter(const std::string &path);
+
+    /**
+     * Add an entity to the snapshot in the storage format, replacing it if it's already in there.
+     * @param kind the kind of entity
+     * @param uuid the UUID of the entity
+     * @param data the serialized entity
+     */
+    void add(EntityKind kind, const Uuid &uuid, const json &data);
+
+    /**
+     * Add an already encoded entity to the snapshot, replacing its old copy if it was already added
+     * @param kind the kind of entity
+     * @param uuid the UUID of the entity
+     * @param bytes the encoded entity, copied into the snapshot
+     * @param format the format it's encoded in
+     */
+    void add(EntityKind kind, const Uuid &uuid, std::string_view bytes, StorageFormat format);
+
+    /**
+     * Remove an entity from the snapshot.
+     * @param uuid the UUID of the entity
+     * @return if the entity was in the snapshot
+     */
+    bool remove(const Uuid &uuid);
+
+    /**
+     * Set the sequence number of the last write-ahead log record whose changes are in the snapshot
+     * @param sequence the sequence number
+     */
+    void setLogSequence(uint64_t sequence);
+
+    /**
+     * Get the number of entities in the snapshot
+     * @return # of entities
+     */
+    size_t size() const;
+
+    /**
+     * Write the snapshot to a file. When updating the snapshot that was opened, the changes are appended to it.
+     * Otherwise, it is written to a temporary file first and then renamed over the old one. Either way, a crash part
+     * way through leaves the previous snapshot readable. Everything is synced to disk by the time this returns.
+     * @param path path of the snapshot file
+     * @throws runtime_error if the file could not be written
+     */
+    void write(const std::string &path);
+
+private:
+    /**
+     * Serialize the index, with the entities grouped by kind in load order (vehicles, people, then dealerships)
+     * @return the serialized index
+     */
+    std::string buildIndex() const;
+
+    /**
+     * Build the header for an index
+     * @param indexOffset where the index starts in the file
+     * @param index the serialized index
+     * @return the header
+     */
+    SnapshotHeader buildHeader(uint64_t indexOffset, const std::string &index) const;
+
+    /**
+     * Append the new entities and index to the end of the opened snapshot, then point the header at them.
+     * @throws runtime_error if the file could not be written
+     */
+    void append();
+
+    /**
+     * Write only the live entities into a new file and rename it over the old one.
+     * @param path path of the snapshot file
+     * @throws runtime_error if a file could not be read or written
+     */
+    void rewrite(const std::string &path);
+
+    std::string path;
+    std::string buffer;
+    uint64_t bufferOffset = 0;
+    uint64_t liveBytes = 0;
+    uint64_t logSequence = 0;
+    std::vector<SnapshotEntry> entries;
+    FlatUuidMap<size_t> uuidsToEntries;
+};
+
+/**
+ * A snapshot of every entity, packed into one versioned file with an index at the end. Opening a snapshot reads the
+ * whole file with one sequential read, and each entity can then be deserialized straight from memory. It can also be
+ * opened lazily, reading only the index, with each entity read from the file when it's needed.
+ */
+class SnapshotStore {
+public:
+    /**
+     * Magic bytes that every snapshot file starts with
+     */
+    static constexpr char magic[8] = {'C', 'A', 'R', 'S', 'N', 'A', 'P', '\0'};
+
+    /**
+     * Version of the file format written by SnapshotWriter
+     */
+    static constexpr uint32_t version = 3;
+
+    /**
+     * Oldest version of the file format that can still be read. Snapshots are upgraded the next time they're rewritten.
+     */
+    static constexpr uint32_t oldestVersion = 2;
+
+    /**
+     * Read a snapshot file and validate its index.
+     * @param path path of the snapshot file
+     * @param lazy whether to only read the index, and leave the entities in the file until they're read
+     * @throws runtime_error if the file does not exist or is malformed
+     */
+    explicit SnapshotStore(const std::string &path, bool lazy = false);
+
+    /**
+     * Get the index of the snapshot, grouped by kind in load order (vehicles, people, then dealerships)
+     * @return every entry in the snapshot
+     */
+    const std::vector<SnapshotEntry> &getEntries() const;
+
+    /**
+     * Get the sequence number of the last write-ahead log record whose changes are in the snapshot
+     * @return the sequence number, 0 if none are
+     */
+    uint64_t getLogSequence() const;
+
+    /**
+     * Get the serialized bytes of an entity, straight from the file in memory
+     * @param entry the entry of the entity
+     * @return view of the serialized entity, valid while the SnapshotStore is alive
+     * @throws runtime_error if the snapshot was opened lazily
+     */
+    std::string_view getPayload(const SnapshotEntry &entry) const;
+
+    /**
+     * Get the encoded bytes of an entity and check them against their checksum, reading them from the file first if
+     * the snapshot was opened lazily
+     * @param entry the entry of the entity
+     * @param buffer buffer to read the entity into if the snapshot was opened lazily
+     * @return view of the encoded entity, valid while the SnapshotStore and buffer are alive
+     * @throws runtime_error if the entity could not be read or failed its checksum
+     */
+    std::string_view readBytes(const SnapshotEntry &entry, std::string &buffer) const;
+
+    /**
+     * Deserialize an entity into JSON, reading it from the file first if the snapshot was opened lazily
+     * @param entry the entry of the entity
+     * @return the serialized entity
+     * @throws runtime_error if the entity could not be read or failed its checksum
+     */
+    json read(const SnapshotEntry &entry) const;
+
+    /**
+     * Pack every entity saved in the one-file-per-entity layout into a snapshot.
+     * @param dataPath path of the data folder (containing vehicles/, people/ and vehicle-dealership/)
+     * @param snapshotPath path of the snapshot file to write
+     * @return the number of entities imported
+     * @throws runtime_error if a file is missing its UUID or the snapshot could not be written
+     */
+    static size_t importFolder(const std::string &dataPath, const std::string &snapshotPath);
+
+    /**
+     * Re-encode every entity in a snapshot in a storage format, rewriting the whole file.
+     * @param snapshotPath path of the snapshot file
+     * @param format the format to convert to
+     * @return the number of entities converted
+     * @throws runtime_error if the snapshot does not exist, is malformed or could not be written
+     */
+    static size_t convert(const std::string &snapshotPath, StorageFormat format);
+
+    /**
+     * Unpack every entity in the snapshot into the one-file-per-entity layout, one file each in the storage format.
+     * @param dataPath path of the data folder to write into
+     * @return the number of entities exported
+     */
+    size_t exportFolder(const std::string &dataPath) const;
+
+private:
+    std::string path;
+    std::string data;
+    bool lazy;
+    mutable std::ifstream file;
+    mutable std::mutex fileMutex;
+    uint64_t logSequence;
+    std::vector<SnapshotEntry> entries;
+};
+
+/**
+ * Append the raw bytes of a value to a buffer
+ * @tparam T type of the value
+ * @param buffer buffer to append to
+ * @param value value to append
+ */
+template<class T>
+void appendRaw(std::string &buffer, const T &value) {
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+/**
+ * Read the raw bytes of a value out of a buffer and move past it
+ * @tparam T type of the value
+ * @param data buffer to read from
+ * @param pos position to read at, moved past the value
+ * @param end position the value must fit before
+ * @return the value
+ * @throws runtime_error if the value doesn't fit
+ */
+template<class T>
+T readRaw(const char *data, uint64_t &pos, uint64_t end) {
+    if (pos + sizeof(T) > end) {
+        throw std::runtime_error("Ran out of bytes to read");
+    }
+
+    T value;
+    std::memcpy(&value, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+}
+
+/**
+ * Compute the 64-bit FNV-1a hash of a block of bytes
+ * @param bytes pointer to the first byte
+ * @param size number of bytes to hash
+ * @return the hash
+ */
+uint64_t fnv1a64(const char *bytes, size_t size);
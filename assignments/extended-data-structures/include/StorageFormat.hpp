@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+#include "JsonWriter.hpp"
+#include "Uuid.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * The formats that entities can be stored in. JSON is plain text, the rest are binary encodings of the same data.
+ */
+enum class StorageFormat : uint8_t {
+    JSON,
+    CBOR,
+    MessagePack,
+    BSON
+};
+
+/**
+ * The format that entities are saved in. Entities are always loaded in whatever format they were saved in.
+ */
+extern StorageFormat storageFormat;
+
+/**
+ * Get a storage format from its name
+ * @param name name of the format (json, cbor, msgpack or bson)
+ * @return the format
+ * @throws runtime_error if no format has that name
+ */
+StorageFormat parseStorageFormat(const std::string &name);
+
+/**
+ * Get the name of a storage format
+ * @param format the format
+ * @return name of the format (ex. "cbor")
+ */
+std::string getStorageFormatName(StorageFormat format);
+
+/**
+ * Get the file extension used for entities saved in a storage format
+ * @param format the format
+ * @return the extension, including the dot (ex. ".cbor")
+ */
+std::string getFileExtension(StorageFormat format);
+
+/**
+ * Get the storage format of an entity file from its extension
+ * @param path path of the file
+ * @return the format
+ * @throws runtime_error if the extension isn't one of the formats'
+ */
+StorageFormat getFormatFromPath(const std::string &path);
+
+/**
+ * Get the storage format of an entity file from its extension, without throwing. Used when scanning a data folder,
+ * so that stray files in it (ex. .DS_Store) can be skipped.
+ * @param path path of the file
+ * @param format where to put the format, left alone if the extension isn't one of the formats'
+ * @return if the extension is one of the formats'
+ */
+bool tryGetFormatFromPath(const std::string &path, StorageFormat &format);
+
+/**
+ * Encode JSON data in a storage format
+ * @param data the data to encode
+ * @param format the format to encode it in
+ * @param pretty whether to indent JSON, ignored by the binary formats
+ * @return the encoded bytes
+ */
+std::string encodeData(const json &data, StorageFormat format, bool pretty = false);
+
+/**
+ * Decode JSON data from a storage format
+ * @param bytes the encoded bytes
+ * @param format the format they're encoded in
+ * @return the decoded data
+ * @throws parse_error if the bytes aren't valid in that format
+ */
+json decodeData(std::string_view bytes, StorageFormat format);
+
+/**
+ * Encode an entity in a storage format into a reusable buffer. JSON is streamed straight out of the entity with a
+ * JsonWriter, the binary formats still go through serializeToJSON().
+ * @tparam T type of the entity, with writeJSON() and serializeToJSON()
+ * @param entity the entity to encode
+ * @param format the format to encode it in
+ * @param buffer the buffer to encode into, cleared first
+ * @param pretty whether to indent JSON, ignored by the binary formats
+ * @return the encoded bytes, valid until the buffer is changed
+ */
+template<class T>
+std::string_view encodeEntity(T &entity, StorageFormat format, std::string &buffer, bool pretty = false) {
+    buffer.clear();
+    if (format == StorageFormat::JSON) {
+        JsonWriter writer(buffer, pretty);
+        entity.writeJSON(writer);
+    } else {
+        buffer = encodeData(entity.serializeToJSON(), format);
+    }
+
+    return buffer;
+}
+
+/**
+ * Save an entity as its own file in the storage format, removing any copy of it saved in another format.
+ * @param folder the folder to save it in (ex. "data/vehicles")
+ * @param uuid the UUID of the entity, used as the filename
+ * @param data the serialized entity
+ * @throws runtime_error if the file could not be written
+ */
+void writeEntityFile(const std::string &folder, const Uuid &uuid, const json &data);
+
+/**
+ * Save an already encoded entity as its own file, removing any copy of it saved in another format.
+ * @param folder the folder to save it in (ex. "data/vehicles")
+ * @param uuid the UUID of the entity, used as the filename
+ * @param bytes the entity, encoded in the storage format
+ * @throws runtime_error if the file could not be written
+ */
+void writeEntityBytes(const std::string &folder, const Uuid &uuid, std::string_view bytes);
+
+/**
+ * Read the encoded bytes of an entity from its own file, without decoding them
+ * @param path path of the file
+ * @return the encoded entity, in the format getFormatFromPath() gives
+ * @throws runtime_error if the file does not exist
+ */
+std::string readEntityBytes(const std::string &path);
+
+/**
+ * Load an entity from its own file, in whichever format its extension says
+ * @param path path of the file
+ * @return the serialized entity
+ * @throws runtime_error if the file does not exist or has an unknown extension
+ */
+json readEntityFile(const std::string &path);
+
+/**
+ * Find the file an entity is saved in, in any format
+ * @param folder the folder it's saved in (ex. "data/vehicles")
+ * @param uuid the UUID of the entity
+ * @return path of the file
+ * @throws runtime_error if the entity isn't saved in any format
+ */
+std::string findEntityFile(const std::string &folder, const Uuid &uuid);
+
+/**
+ * Convert every entity file in the one-file-per-entity layout into a storage format.
+ * @param dataPath path of the data folder (containing vehicles/, people/ and vehicle-dealership/)
+ * @param format the format to convert to
+ * @return the number of files converted
+ */
+size_t convertFolder(const std::string &dataPath, StorageFormat format);
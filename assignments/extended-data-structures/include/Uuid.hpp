@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/**
+ * A 128-bit UUID, stored as its 16 bytes. It's only turned into its usual text form (ex.
+ * "8abced70-4bc1-4ab6-a015-75d175390a9a") when it's saved, printed or read back in, so copying and comparing one is as
+ * cheap as two integers. The default UUID is the nil UUID, which is used for "no entity".
+ */
+class Uuid {
+public:
+    /**
+     * Length of the text form of a UUID
+     */
+    static constexpr size_t stringLength = 36;
+
+    /**
+     * Constructor for Uuid, which makes the nil UUID.
+     */
+    constexpr Uuid() = default;
+
+    /**
+     * Generate a random UUIDv4, using a random number generator that belongs to the calling thread.
+     * @return the new UUID
+     */
+    static Uuid generate();
+
+    /**
+     * Read a UUID from its text form. Hex digits can be either case.
+     * @param text the UUID as text (ex. "8abced70-4bc1-4ab6-a015-75d175390a9a")
+     * @return the UUID
+     * @throws runtime_error if the text isn't a UUID
+     */
+    static Uuid parse(std::string_view text);
+
+    /**
+     * Read a UUID from its text form, without throwing
+     * @param text the UUID as text
+     * @param uuid where to put the UUID, left alone if the text isn't one
+     * @return if the text is a UUID
+     */
+    static bool tryParse(std::string_view text, Uuid &uuid);
+
+    /**
+     * Write the text form of the UUID, in lowercase
+     * @param out where to write it, which needs room for stringLength characters
+     */
+    void format(char *out) const;
+
+    /**
+     * Get the text form of the UUID, in lowercase
+     * @return the UUID as text
+     */
+    std::string toString() const;
+
+    /**
+     * Check whether this is the nil UUID
+     * @return if every byte is zero
+     */
+    bool isNil() const;
+
+    /**
+     * Get a hash of the UUID. Generated UUIDs are random already, so this just folds the two halves together.
+     * @return the hash
+     */
+    size_t hash() const;
+
+    bool operator==(const Uuid &other) const = default;
+
+    std::strong_ordering operator<=>(const Uuid &other) const = default;
+
+    friend std::ostream &operator<<(std::ostream &out, const Uuid &obj);
+
+private:
+    std::array<uint8_t, 16> bytes{};
+};
+
+template<>
+struct std::hash<Uuid> {
+    size_t operator()(const Uuid &uuid) const noexcept {
+        return uuid.hash();
+    }
+};
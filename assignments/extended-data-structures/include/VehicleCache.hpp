@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "FlatUuidMap.hpp"
+#include "PinnedVehicle.hpp"
+#include "SnapshotStore.hpp"
+#include "include/vehicles/Vehicle.hpp"
+
+using json = nlohmann::json;
+
+/**
+ * Owns every vehicle in memory, by UUID. By default every vehicle is loaded up front and stays in memory. Once a
+ * snapshot is opened lazily, only its index is kept in memory, vehicles are loaded from it the first time they're
+ * used, and the least recently used ones are evicted to stay under a set number of vehicles. Vehicles with unsaved
+ * changes or that are pinned are never evicted.
+ */
+class VehicleCache {
+public:
+    /**
+     * Destructor for VehicleCache, which deletes every vehicle in memory.
+     */
+    ~VehicleCache();
+
+    /**
+     * Add a vehicle that's in memory, which the cache takes ownership of.
+     * @param vehicle pointer to the vehicle
+     */
+    void add(Vehicle *vehicle);
+
+    /**
+     * Make room for a number of vehicles in memory, so adding that many doesn't have to grow the index
+     * @param count # of vehicles
+     */
+    void reserve(size_t count);
+
+    /**
+     * Check whether a vehicle exists, whether or not it's in memory. Safe to call from multiple threads at once, as
+     * long as nothing is being added or loaded.
+     * @param uuid the UUID of the vehicle
+     * @return if the vehicle exists
+     */
+    bool contains(const Uuid &uuid) const;
+
+    /**
+     * Get a vehicle, loading it from the snapshot if it isn't in memory. Loading another vehicle can evict this one,
+     * so the pointer must not be kept across any other call to get() or pin(). Use pin() to keep it for longer.
+     * @param uuid the UUID of the vehicle
+     * @return pointer to the vehicle, nullptr if it does not exist
+     */
+    Vehicle *get(const Uuid &uuid);
+
+    /**
+     * Get a vehicle and keep it in memory until the returned handle is destroyed, loading it from the snapshot if it
+     * isn't in memory
+     * @param uuid the UUID of the vehicle
+     * @return the pinned vehicle, empty if it does not exist
+     */
+    PinnedVehicle pin(const Uuid &uuid);
+
+    /**
+     * Get every vehicle that's in memory. Vehicles that aren't have no unsaved changes.
+     * @return pointers to the vehicles
+     */
+    std::vector<Vehicle *> getResident() const;
+
+    /**
+     * Get the number of vehicles in memory
+     * @return # of vehicles
+     */
+    size_t getResidentCount() const;
+
+    /**
+     * Get the number of vehicles loaded from the snapshot on first use so far
+     * @return # of vehicles
+     */
+    size_t getLoadCount() const;
+
+    /**
+     * Get the number of vehicles evicted so far
+     * @return # of vehicles
+     */
+    size_t getEvictionCount() const;
+
+    /**
+     * Load vehicles from a snapshot on first use from now on, reading only its index. Call this again after the
+     * snapshot is saved, so that vehicles are loaded from where they are now.
+     * @param path path of the snapshot file
+     * @param capacity the most vehicles to keep in memory
+     * @throws runtime_error if the snapshot does not exist or is malformed
+     */
+    void openSnapshot(const std::string &path, size_t capacity);
+
+private:
+    friend class PinnedVehicle;
+
+    /**
+     * A vehicle in memory, where it is in the recently used list, and how many PinnedVehicles are keeping it in memory
+     */
+    struct Slot {
+        Vehicle *vehicle;
+        std::list<Uuid>::iterator position;
+        unsigned pinCount = 0;
+    };
+
+    /**
+     * Release one pin on a vehicle, evicting vehicles again if the cache went over its capacity while it was pinned
+     * @param uuid the UUID of the vehicle
+     */
+    void unpin(const Uuid &uuid);
+
+    /**
+     * Evict the least recently used vehicles without unsaved changes or pins, until the cache is within its capacity.
+     */
+    void evict();
+
+    FlatUuidMap<Slot> resident;
+    std::list<Uuid> recentlyUsed;
+    size_t capacity = SIZE_MAX;
+    size_t loadCount = 0;
+    size_t evictionCount = 0;
+
+    std::unique_ptr<SnapshotStore> store;
+    std::string readBuffer;
+    FlatUuidMap<const SnapshotEntry *> index;
+};
+
+/**
+ * The cache that owns every vehicle, which VehicleRef looks vehicles up in
+ */
+extern VehicleCache vehicleCache;
@@ -4,12 +4,15 @@
 #include <vector>
 #include "BankAccount.hpp"
 #include "include/vehicles/Vehicle.hpp"
+#include "VehicleRef.hpp"
 #include "util.hpp"
 
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
+class VehicleCache;
+
 /**
  * A class for a vehicle dealership, which is a company that can own, buy, and sell cars
  */
@@ -28,7 +31,7 @@ public:
      * @param account
      * @param uuid
      */
-    VehicleDealership(std::string name, BankAccount *account, std::string uuid);
+    VehicleDealership(std::string name, BankAccount *account, Uuid uuid);
 
     /**
      * Get the name of the dealership.
@@ -36,13 +39,36 @@ public:
      */
     std::string getName() const;
 
+    /**
+     * Get the UUID of the dealership.
+     * @return The UUID of the dealership.
+     */
+    Uuid getUUID() const;
+
+    /**
+     * Check whether the dealership or its bank account has changed since it was last saved or loaded
+     * @return if the dealership needs to be saved
+     */
+    bool isDirty() const;
+
+    /**
+     * Mark the dealership as changed, needed after editing its vehicle list directly
+     */
+    void markDirty();
+
+    /**
+     * Mark the dealership and its bank account as matching what's saved
+     */
+    void markClean();
+
     /**
      * Attempt to buy a vehicle from the dealership.
      * @param idx the index in the vehicle list of which vehicle to buy
      * @param buyerBankAccount the bank account of the buyer of the vehicle
-     * @return A pointer to the Vehicle desired, will be null if vehicles[idx] does not exist
+     * @return The vehicle bought, kept in memory while the buyer uses it. Empty if vehicles[idx] does not exist or
+     * the transaction didn't go through.
      */
-    Vehicle *buyVehicleFrom(int idx, BankAccount *buyerBankAccount);
+    PinnedVehicle buyVehicleFrom(int idx, BankAccount *buyerBankAccount);
 
     /**
      * Attempt to sell a vehicle to the dealership.
@@ -65,14 +91,20 @@ public:
      */
     json serializeToJSON();
 
+    /**
+     * Write all the data in the class straight into a JSON writer, without building it as JSON first.
+     * @param writer the writer to write into
+     */
+    void writeJSON(JsonWriter &writer) const;
+
     /**
      * Deserialize all the data from a JSON file into an instance of VehicleDealership.
      * @param data the JSON data to deserialize
-     * @param vehicleUUIDsToPointers a map of UUIDs to Vehicle pointers loaded in from their folders
+     * @param vehicleCache the cache of vehicles, used to check that owned vehicles exist
      * @return a new VehicleDealership instance made using the JSON data.
      * @throws runtime_error if required key does not exist
      */
-    static VehicleDealership deserializeFromJSON(const json &data, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers);
+    static VehicleDealership deserializeFromJSON(const json &data, const VehicleCache &vehicleCache);
 
     /**
      * Save the data in the instance as a JSON file in its expected location.
@@ -83,20 +115,20 @@ public:
     /**
      * Loads in a VehicleDealership instance from a file given its UUID
      * @param uuid the UUID of the object
-     * @param vehicleUUIDsToPointers a map of UUIDs to Vehicle pointers loaded in from their folders
+     * @param vehicleCache the cache of vehicles, used to check that owned vehicles exist
      * @return An instance of the deserialized VehicleDealership from the JSON file
      * @throws runtime_error if a file with the UUID does not exist
      */
-    static VehicleDealership loadFromUUID(const std::string& uuid, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers);
+    static VehicleDealership loadFromUUID(const Uuid &uuid, const VehicleCache &vehicleCache);
 
     /**
      * Loads in a VehicleDealership instance from a file given its path
      * @param path the path of the serialized instance
-     * @param vehicleUUIDsToPointers a map of UUIDs to Vehicle pointers loaded in from their folders
+     * @param vehicleCache the cache of vehicles, used to check that owned vehicles exist
      * @return An instance of the deserialized VehicleDealership from the JSON file
      * @throws runtime_error if a file does not exist at given path
      */
-    static VehicleDealership loadFromPath(const std::string& path, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers);
+    static VehicleDealership loadFromPath(const std::string& path, const VehicleCache &vehicleCache);
 
     /**
      * Convert the data in the instance into a string
@@ -106,10 +138,11 @@ public:
      */
     friend std::ostream &operator<<(std::ostream &out, const VehicleDealership &obj);
 
-    std::vector<Vehicle *> vehicles;
+    std::vector<VehicleRef> vehicles;
 private:
     std::string name;
 
     BankAccount *bankAccount;
-    std::string uuid;
+    Uuid uuid;
+    bool dirty;
 };
\ No newline at end of file
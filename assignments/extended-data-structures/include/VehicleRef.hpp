@@ -0,0 +1,69 @@
+#pragma once
+
+#include "PinnedVehicle.hpp"
+#include "Uuid.hpp"
+
+class Vehicle;
+
+/**
+ * A reference to a vehicle by its UUID, used by the people and dealerships that own vehicles. The vehicle is looked
+ * up in the vehicle cache each time it's used, so it can be loaded on first access and evicted again while nobody is
+ * using it.
+ */
+class VehicleRef {
+public:
+    /**
+     * Constructor for VehicleRef, which refers to a vehicle that's already in memory.
+     * @param vehicle pointer to the vehicle
+     */
+    VehicleRef(Vehicle *vehicle);
+
+    /**
+     * Constructor for VehicleRef, which refers to a vehicle by its UUID, without loading it.
+     * @param uuid the UUID of the vehicle
+     */
+    explicit VehicleRef(const Uuid &uuid);
+
+    /**
+     * Get the UUID of the vehicle, without loading it
+     * @return the UUID of the vehicle
+     */
+    const Uuid &getUUID() const;
+
+    /**
+     * Get the vehicle, loading it if it isn't in memory. The pointer is only safe to use until the next vehicle is
+     * loaded, since that can evict this one, so use pin() instead to keep it across other lookups.
+     * @return pointer to the vehicle
+     * @throws runtime_error if the vehicle does not exist
+     */
+    Vehicle *get() const;
+
+    /**
+     * Get the vehicle and keep it in memory until the returned handle is destroyed, loading it if it isn't in memory
+     * @return the pinned vehicle
+     * @throws runtime_error if the vehicle does not exist
+     */
+    PinnedVehicle pin() const;
+
+    /**
+     * Access the vehicle, loading it if it isn't in memory
+     * @return pointer to the vehicle
+     */
+    Vehicle *operator->() const;
+
+    /**
+     * Access the vehicle, loading it if it isn't in memory
+     * @return reference to the vehicle
+     */
+    Vehicle &operator*() const;
+
+    /**
+     * Check whether two references refer to the same vehicle
+     * @param other the other reference
+     * @return if they have the same UUID
+     */
+    bool operator==(const VehicleRef &other) const;
+
+private:
+    Uuid uuid;
+};
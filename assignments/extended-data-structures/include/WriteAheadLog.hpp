@@ -0,0 +1,130 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SnapshotStore.hpp"
+
+/**
+ * The kinds of operations that can be recorded in the write-ahead log.
+ */
+enum class LogRecordType : uint8_t {
+    Create,
+    Delete,
+    TransferVehicle
+};
+
+/**
+ * One committed operation in the write-ahead log. Which fields are used depends on the type:
+ *  - Create: kind, uuid and payload (the serialized entity). For a vehicle, to is the dealership it was given to.
+ *  - Delete: kind and uuid.
+ *  - TransferVehicle: the vehicle uuid moved from the owner from to the owner to, who paid amount for it.
+ */
+struct LogRecord {
+    LogRecordType type = LogRecordType::Create;
+    EntityKind kind = EntityKind::Vehicle;
+    Uuid uuid{};
+    Uuid from{};
+    Uuid to{};
+    double amount = 0;
+    std::string payload{};
+    uint64_t sequence = 0;
+};
+
+/**
+ * An append-only log of every operation committed since the last snapshot, so that they survive a crash without
+ * having to save everything after each one. Records are flushed to disk by a background thread with group commit:
+ * every record appended while one fsync is running is made durable together by the next one, so many operations a
+ * second only cost a few fsyncs.
+ */
+class WriteAheadLog {
+public:
+    /**
+     * Open the log, creating it if it doesn't exist. Records that were only partially written by a crash are dropped.
+     * @param path path of the log file
+     * @param snapshotSequence sequence number of the last record already included in the snapshot
+     * @throws runtime_error if the file could not be opened
+     */
+    WriteAheadLog(const std::string &path, uint64_t snapshotSequence);
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    /**
+     * Destructor for WriteAheadLog, which makes every appended record durable before closing the file.
+     */
+    ~WriteAheadLog();
+
+    /**
+     * Queue a record to be written, without waiting for it to be durable.
+     * @param record the record, its sequence number is assigned here
+     * @return the sequence number of the record
+     * @throws runtime_error if writing the log already failed, after which nothing more is written
+     */
+    uint64_t append(LogRecord record);
+
+    /**
+     * Wait until a record and everything appended before it is durable.
+     * @param sequence the sequence number of the record
+     * @throws runtime_error if the log could not be written
+     */
+    void commit(uint64_t sequence);
+
+    /**
+     * Append a record and wait until it is durable.
+     * @param record the record
+     * @return the sequence number of the record
+     * @throws runtime_error if the log could not be written
+     */
+    uint64_t write(LogRecord record);
+
+    /**
+     * Get the records that were in the log when it was opened and are not in the snapshot yet, in order
+     * @return the records to replay
+     */
+    const std::vector<LogRecord> &getRecords() const;
+
+    /**
+     * Get the sequence number of the last record appended
+     * @return the sequence number
+     */
+    uint64_t getLastSequence() const;
+
+    /**
+     * Get the number of fsyncs done so far, which is lower than the number of records when commits were grouped
+     * @return # of fsyncs
+     */
+    uint64_t getSyncCount() const;
+
+    /**
+     * Empty the log once everything in it has been saved into a snapshot. Sequence numbers keep counting up.
+     * @throws runtime_error if the log could not be truncated
+     */
+    void truncate();
+
+private:
+    /**
+     * Write and fsync whatever has been appended, until the log is closed or a write fails. Runs on the flusher
+     * thread.
+     */
+    void flushLoop();
+
+    std::string path;
+    int fd;
+    std::vector<LogRecord> records;
+
+    mutable std::mutex mutex;
+    std::condition_variable pendingCondition;
+    std::condition_variable durableCondition;
+    std::string pending;
+    uint64_t lastSequence;
+    uint64_t durableSequence;
+    uint64_t durableSize;
+    uint64_t syncCount = 0;
+    std::string error;
+    bool stopping = false;
+    std::thread flusher;
+};
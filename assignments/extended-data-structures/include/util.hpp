@@ -1,17 +1,17 @@
-// SOURCE: https://stackoverflow.com/a/60198074/7363404
 #pragma once
 
 #include <random>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "BankAccount.hpp"
 
-/**
- * Generates a UUIDv4.
- * @return a UUIDv4
- */
-extern std::string generate_uuid_v4();
 /*
 extern void save_bank_account(BankAccount* bankAccount);
 extern BankAccount load_bank_account(const std::string& uuid);
@@ -98,3 +98,52 @@ T promptWithValidation(const std::string &prompt, std::function<bool(T)> checker
 
     return inp;
 }
+
+/**
+ * Run a function once for every index from 0 to count - 1, spread across all the hardware threads. Each thread keeps
+ * claiming the next chunk of indices from a shared counter, so uneven work still balances out.
+ * @tparam F the type of the function, called with a size_t index
+ * @param count the number of indices
+ * @param function the function to run, must be safe to call from multiple threads at once
+ * @throws the first exception thrown by the function, once every thread has stopped
+ */
+template<class F>
+void parallelFor(size_t count, const F &function) {
+    const size_t chunkSize = 64;
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), chunkCount);
+
+    std::atomic<size_t> nextChunk = 0;
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto work = [&]() {
+        try {
+            for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+                for (size_t i = chunk * chunkSize; i < std::min(count, (chunk + 1) * chunkSize); i++) {
+                    function(i);
+                }
+            }
+        } catch (...) {
+            // Keep the first error, and stop everyone else from claiming more work
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            nextChunk = chunkCount;
+        }
+    };
+
+    // The calling thread does its share too
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
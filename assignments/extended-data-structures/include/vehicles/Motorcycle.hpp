@@ -28,6 +28,22 @@ public:
      */
     Motorcycle(std::string name, double price, std::string manufacturer, double mileage, double horsepower, double maxSpeed, std::string color, double engineSize, double maxAcceleration, MOTORCYCLE_TYPE motorcycleType);
 
+    /**
+     * Constructor for Motorcycle, which takes in a UUID. Helpful for loading in serialized data.
+     * @param name name of motorcycle
+     * @param price price of motorcycle in dollars
+     * @param manufacturer manufacturer of motorcycle
+     * @param mileage mileage of motorcycle in kilometres
+     * @param horsepower horsepower of motorcycle
+     * @param maxSpeed max speed of motorcycle in km/h
+     * @param color color of motorcycle
+     * @param engineSize size of engine in CC
+     * @param maxAcceleration max accel of engine
+     * @param motorcycleType type of the motorcycle
+     * @param uuid UUID of the instance
+     */
+    Motorcycle(std::string name, double price, std::string manufacturer, double mileage, double horsepower, double maxSpeed, std::string color, double engineSize, double maxAcceleration, MOTORCYCLE_TYPE motorcycleType, Uuid uuid);
+
     /**
      * Get the engine size of the motorcycle
      * @return The engine size of the motorcycle in CC
@@ -67,7 +83,7 @@ public:
      * @return An instance of the deserialized Motorcycle from the JSON file
      * @throws runtime_error if a file with the UUID does not exist
      */
-    static Motorcycle loadFromUUID(const std::string& uuid);
+    static Motorcycle loadFromUUID(const Uuid &uuid);
 
     /**
      * Loads in a Motorcycle instance from a file given its path
@@ -82,6 +98,14 @@ public:
      * @return formatted string of all of the info in Motorcycle
      */
     std::string toFormattedString() override;
+
+protected:
+    /**
+     * Write the fields of the class into the current object of a JSON writer, after the ones from Vehicle.
+     * @param writer the writer to write into
+     */
+    void writeFields(JsonWriter &writer) const override;
+
 private:
     double engineSize; // in CC
     double maxAcceleration; // in m/s^2
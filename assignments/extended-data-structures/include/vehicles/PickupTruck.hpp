@@ -22,6 +22,22 @@ public:
      */
     PickupTruck(std::string name, double price, std::string manufacturer, double mileage, double horsepower, double maxSpeed, double bedCapacity, double towingMaxLoad, int engineCylinderCount, std::string color);
 
+    /**
+     * Constructor for PickupTruck, which takes in a UUID. Helpful for loading in serialized data.
+     * @param name name of pickup
+     * @param price price of pickup, in dollars
+     * @param manufacturer manufacturer of pickup
+     * @param mileage mileage of pickup, in kilometres
+     * @param horsepower horsepower of pickup
+     * @param maxSpeed max speed of pickup, in km/h
+     * @param bedCapacity trunk bed capacity available in pickup, in kg
+     * @param towingMaxLoad max weight that can be towed, in kg
+     * @param engineCylinderCount the number of cylinders in the pickup's engine
+     * @param color color of pickup
+     * @param uuid UUID of the instance
+     */
+    PickupTruck(std::string name, double price, std::string manufacturer, double mileage, double horsepower, double maxSpeed, double bedCapacity, double towingMaxLoad, int engineCylinderCount, std::string color, Uuid uuid);
+
     /**
      * Get the max weight that can be in the trunk.
      * @return the trunk capacity in kg
@@ -67,7 +83,7 @@ public:
      * @return An instance of the deserialized PickupTruck from the JSON file
      * @throws runtime_error if a file with the UUID does not exist
      */
-    static PickupTruck loadFromUUID(const std::string& uuid);
+    static PickupTruck loadFromUUID(const Uuid &uuid);
 
     /**
      * Loads in a PickupTruck instance from a file given its path
@@ -82,6 +98,14 @@ public:
      * @return formatted string of all of the info in PickupTruck
      */
     std::string toFormattedString() override;
+
+protected:
+    /**
+     * Write the fields of the class into the current object of a JSON writer, after the ones from Vehicle.
+     * @param writer the writer to write into
+     */
+    void writeFields(JsonWriter &writer) const override;
+
 private:
     double bedCapacity;
     double towingMaxLoad;
@@ -23,6 +23,22 @@ public:
     Sedan(std::string name, double price, std::string manufacturer, double mileage, double horsepower, double maxSpeed,
           double trunkCapacity, int engineCylinderCount, std::string color);
 
+    /**
+     * Constructor for Sedan, which takes in a UUID. Helpful for loading in serialized data.
+     * @param name name of sedan
+     * @param price price of sedan, in dollars
+     * @param manufacturer manufacturer of sedan
+     * @param mileage mileage of sedan, in kilometres
+     * @param horsepower horsepower of sedan
+     * @param maxSpeed max speed of sedan, in km/h
+     * @param trunkCapacity trunk capacity available in sedan, in kilograms
+     * @param engineCylinderCount number of cylinders in the engine
+     * @param color color of sedan
+     * @param uuid UUID of the instance
+     */
+    Sedan(std::string name, double price, std::string manufacturer, double mileage, double horsepower, double maxSpeed,
+          double trunkCapacity, int engineCylinderCount, std::string color, Uuid uuid);
+
     /**
      * Get the max weight that can be in the trunk.
      * @return the trunk capacity in kg
@@ -62,7 +78,7 @@ public:
      * @return An instance of the deserialized Sedan from the JSON file
      * @throws runtime_error if a file with the UUID does not exist
      */
-    static Sedan loadFromUUID(const std::string& uuid);
+    static Sedan loadFromUUID(const Uuid &uuid);
 
     /**
      * Loads in a Sedan instance from a file given its path
@@ -78,6 +94,13 @@ public:
      */
     std::string toFormattedString() override;
 
+protected:
+    /**
+     * Write the fields of the class into the current object of a JSON writer, after the ones from Vehicle.
+     * @param writer the writer to write into
+     */
+    void writeFields(JsonWriter &writer) const override;
+
 private:
     double trunkCapacity;
     int engineCylinderCount;
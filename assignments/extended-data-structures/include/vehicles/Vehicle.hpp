@@ -1,7 +1,9 @@
 #pragma once
 
 #include <vector>
+#include "JsonWriter.hpp"
 #include "Person.hpp"
+#include "Uuid.hpp"
 
 class Person;
 
@@ -28,6 +30,31 @@ public:
     Vehicle(std::string name, double price, int wheels, int doors, int seats, int maxPassengers,
             std::string manufacturer, double mileage, double horsepower, double maxSpeed, std::string color, std::string type);
 
+    /**
+     * Constructor for Vehicle, which takes in a UUID. Helpful for loading in serialized data.
+     * @param name name of Vehicle
+     * @param price price of Vehicle in dollars
+     * @param wheels wheels on Vehicle
+     * @param doors doors on Vehicle
+     * @param seats seats in Vehicle
+     * @param maxPassengers max passengers fittable in Vehicle
+     * @param manufacturer manufacturer of Vehicle
+     * @param mileage mileage of Vehicle in kilometres
+     * @param horsepower horsepower of Vehicle
+     * @param maxSpeed max speed of Vehicle in km/h
+     * @param color color of Vehicle
+     * @param type type of vehicle (any derived class)
+     * @param uuid UUID of the instance
+     */
+    Vehicle(std::string name, double price, int wheels, int doors, int seats, int maxPassengers,
+            std::string manufacturer, double mileage, double horsepower, double maxSpeed, std::string color, std::string type,
+            Uuid uuid);
+
+    /**
+     * Destructor for Vehicle, virtual so that derived vehicles can be deleted through a Vehicle pointer.
+     */
+    virtual ~Vehicle() = default;
+
     /**
      * Start the car if possible
      * @return if the car was started
@@ -120,7 +147,18 @@ public:
      * Get the UUID of the vehicle
      * @return
      */
-    std::string getUUID() const;
+    Uuid getUUID() const;
+
+    /**
+     * Check whether the vehicle has changed since it was last saved or loaded
+     * @return if the vehicle needs to be saved
+     */
+    bool isDirty() const;
+
+    /**
+     * Mark the vehicle as matching what's saved
+     */
+    void markClean();
 
     /**
      * Roughly approximate the fuel usage for the vehicle to travel a certain amount of kilometres.
@@ -135,6 +173,12 @@ public:
      */
     virtual json serializeToJSON();
 
+    /**
+     * Write all the data in the class straight into a JSON writer, without building it as JSON first.
+     * @param writer the writer to write into
+     */
+    void writeJSON(JsonWriter &writer) const;
+
     /**
      * Sanitize the JSON data that should be deserialized into a derived class of Vehicle.
      * @param data the JSON data to sanitize
@@ -164,6 +208,12 @@ public:
     friend std::ostream &operator<<(std::ostream &out, Vehicle &obj);
 
 protected:
+    /**
+     * Write the fields of the class into the current object of a JSON writer. Derived classes add their own after.
+     * @param writer the writer to write into
+     */
+    virtual void writeFields(JsonWriter &writer) const;
+
     std::string name;
     double price;
     int wheels;
@@ -177,6 +227,7 @@ protected:
     Person *driver;
     bool started;
     std::string color;
-    std::string uuid;
+    Uuid uuid;
     std::string type;
+    bool dirty;
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <cassert>
 #include "BankAccount.hpp"
+#include "StorageFormat.hpp"
 #include <util.hpp>
 #include <filesystem>
 #include <fstream>
@@ -15,20 +16,22 @@ BankAccount::BankAccount(double startingBalance, double minBalance, double withd
     this->minBalance = minBalance;
     this->withdrawLimit = withdrawLimit;
     this->depositLimit = depositLimit;
+    this->dirty = true;
 
-    this->uuid = generate_uuid_v4();
+    this->uuid = Uuid::generate();
 }
 
 BankAccount::BankAccount(double startingBalance, double minBalance, double withdrawLimit, double depositLimit,
-                         std::string uuid) {
+                         Uuid uuid) {
     assert(startingBalance >= minBalance && "Starting balance is higher than minimum balance");
 
     this->balance = startingBalance;
     this->minBalance = minBalance;
     this->withdrawLimit = withdrawLimit;
     this->depositLimit = depositLimit;
+    this->dirty = true;
 
-    this->uuid = std::move(uuid);
+    this->uuid = uuid;
 }
 
 BankAccount::BankAccount(double withdrawLimit, double depositLimit) {
@@ -36,11 +39,12 @@ BankAccount::BankAccount(double withdrawLimit, double depositLimit) {
     this->minBalance = 0.0;
     this->withdrawLimit = withdrawLimit;
     this->depositLimit = depositLimit;
+    this->dirty = true;
 
-    this->uuid = generate_uuid_v4();
+    this->uuid = Uuid::generate();
 }
 
-std::string BankAccount::getUUID() const {
+Uuid BankAccount::getUUID() const {
     return uuid;
 }
 
@@ -48,6 +52,14 @@ double BankAccount::getBalance() const {
     return balance;
 }
 
+bool BankAccount::isDirty() const {
+    return dirty;
+}
+
+void BankAccount::markClean() {
+    dirty = false;
+}
+
 bool BankAccount::withdraw(double amount) {
     if (!checkWithdraw(amount)) {
         // Don't allow an impossible withdraw
@@ -55,6 +67,7 @@ bool BankAccount::withdraw(double amount) {
     }
 
     balance -= amount;
+    dirty = true;
     return true;
 }
 
@@ -65,6 +78,7 @@ bool BankAccount::deposit(double amount) {
     }
 
     balance += amount;
+    dirty = true;
     return true;
 }
 
@@ -98,7 +112,7 @@ json BankAccount::serializeToJSON() {
     json serialized = {};
 
     // Store all important info into JSON object
-    serialized["uuid"] = uuid;
+    serialized["uuid"] = uuid.toString();
     serialized["balance"] = balance;
     serialized["minBalance"] = minBalance;
     serialized["withdrawLimit"] = withdrawLimit;
@@ -107,6 +121,16 @@ json BankAccount::serializeToJSON() {
     return serialized;
 }
 
+void BankAccount::writeJSON(JsonWriter &writer) const {
+    writer.beginObject();
+    writer.field("uuid", uuid);
+    writer.field("balance", balance);
+    writer.field("minBalance", minBalance);
+    writer.field("withdrawLimit", withdrawLimit);
+    writer.field("depositLimit", depositLimit);
+    writer.endObject();
+}
+
 BankAccount BankAccount::deserializeFromJSON(const json &data) {
     // Ensure that all keys are there
     std::vector<std::string> requiredKeys = {"uuid", "balance", "minBalance", "withdrawLimit", "depositLimit"};
@@ -118,11 +142,13 @@ BankAccount BankAccount::deserializeFromJSON(const json &data) {
 
     // Initialize BankAccount using all the info
     return {data["balance"].get<double>(), data["minBalance"].get<double>(), data["withdrawLimit"].get<double>(),
-            data["depositLimit"].get<double>(), data["uuid"].get<std::string>()};
+            data["depositLimit"].get<double>(), Uuid::parse(data["uuid"].get<std::string>())};
 }
 
 void BankAccount::saveAsFile() {
-    json serializedJSON = serializeToJSON();
+    // JSON files are indented so they can still be read by people
+    std::string encoded;
+    encodeEntity(*this, storageFormat, encoded, true);
 
     // Make data directory if needed
     if (!fs::is_directory("data") || !fs::exists("data")) { // Check if folder exists
@@ -134,10 +160,8 @@ void BankAccount::saveAsFile() {
         fs::create_directory("data/bank_accounts");
     }
 
-    // Write data to file
-    std::ofstream file("data/bank_accounts/" + getUUID() + ".json");
-    file << std::setw(4) << serializedJSON << std::endl;
-    file.close();
+    // Write data to file in the storage format
+    writeEntityBytes("data/bank_accounts", getUUID(), encoded);
 }
 
 std::ostream &operator<<(std::ostream &out, const BankAccount &obj) {
@@ -0,0 +1,430 @@
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include "EntityReader.hpp"
+#include "BankAccount.hpp"
+#include "Person.hpp"
+#include "VehicleCache.hpp"
+#include "VehicleDealership.hpp"
+#include "vehicles/Motorcycle.hpp"
+#include "vehicles/PickupTruck.hpp"
+#include "vehicles/Sedan.hpp"
+
+using Field = EntityReader::Field;
+
+/**
+ * Key of every field, in the order of the enum. The bank account's UUID has the same key as the entity's.
+ */
+static constexpr std::string_view fieldNames[] = {
+        "uuid", "name", "price", "wheels", "doors", "seats", "maxPassengers", "maxSpeed", "manufacturer", "mileage",
+        "horsepower", "started", "color", "type", "trunkCapacity", "engineCylinderCount", "bedCapacity",
+        "towingMaxLoad", "engineSize", "maxAcceleration", "motorcycleType", "firstName", "middleName", "lastName",
+        "birthTimestamp", "height", "bankAccount", "vehicles", "balance", "minBalance", "withdrawLimit", "depositLimit",
+        "uuid"
+};
+static_assert(std::size(fieldNames) == (size_t) Field::unknown, "Every field needs a key");
+
+/**
+ * Number of slots in the key table
+ */
+static constexpr size_t keyTableSize = 64;
+
+/**
+ * Hash a key into the key table. The multipliers were searched for so that no two keys land in the same slot.
+ * @param key the key
+ * @return slot of the key
+ */
+static constexpr size_t hashKey(std::string_view key) {
+    return (key.size() * 4 + (unsigned char) key.front() * 42 + (unsigned char) key.back() * 20 +
+            (unsigned char) key[key.size() / 2]) % keyTableSize;
+}
+
+/**
+ * Build the perfect hash table from each key's slot to its field
+ * @return the table, with empty slots set to Field::unknown
+ */
+static constexpr std::array<Field, keyTableSize> buildKeyTable() {
+    std::array<Field, keyTableSize> table{};
+    table.fill(Field::unknown);
+    for (size_t i = 0; i < (size_t) Field::bankAccountUUID; i++) {
+        table[hashKey(fieldNames[i])] = (Field) i;
+    }
+
+    return table;
+}
+
+static constexpr std::array<Field, keyTableSize> keyTable = buildKeyTable();
+
+/**
+ * Check that every key landed in its own slot of the key table
+ * @return if no two keys share a slot
+ */
+static constexpr bool isPerfect() {
+    for (size_t i = 0; i < (size_t) Field::bankAccountUUID; i++) {
+        if (keyTable[hashKey(fieldNames[i])] != (Field) i) {
+            return false;
+        }
+    }
+
+    return true;
+}
+static_assert(isPerfect(), "Two keys hash to the same slot, search for new multipliers in hashKey()");
+
+/**
+ * Look up the field of a key with one hash and one comparison
+ * @param key the key
+ * @return the field, Field::unknown if no field has that key
+ */
+static Field lookupKey(std::string_view key) {
+    if (key.empty()) {
+        return Field::unknown;
+    }
+
+    Field field = keyTable[hashKey(key)];
+    return field != Field::unknown && fieldNames[(size_t) field] == key ? field : Field::unknown;
+}
+
+/**
+ * Get the bit of a field in a bit mask of fields
+ * @param field the field
+ * @return the bit
+ */
+static constexpr uint64_t fieldBit(Field field) {
+    return 1ULL << (size_t) field;
+}
+
+/**
+ * Build a bit mask of fields
+ * @param fields the fields
+ * @return the bit mask
+ */
+static constexpr uint64_t fieldMask(std::initializer_list<Field> fields) {
+    uint64_t mask = 0;
+    for (Field field: fields) {
+        mask |= fieldBit(field);
+    }
+
+    return mask;
+}
+
+/**
+ * Fields that hold strings, every other field holds a number unless it's listed below
+ */
+static constexpr uint64_t stringFields = fieldMask(
+        {Field::uuid, Field::name, Field::manufacturer, Field::color, Field::type, Field::motorcycleType,
+         Field::firstName, Field::middleName, Field::lastName, Field::bankAccountUUID});
+
+/**
+ * Fields that don't hold a string or a number
+ */
+static constexpr uint64_t otherFields = fieldMask({Field::started, Field::bankAccount, Field::vehicles});
+
+static constexpr uint64_t vehicleFields = fieldMask(
+        {Field::uuid, Field::name, Field::price, Field::wheels, Field::doors, Field::seats, Field::maxPassengers,
+         Field::maxSpeed, Field::manufacturer, Field::mileage, Field::horsepower, Field::started, Field::color,
+         Field::type});
+static constexpr uint64_t bankAccountFields = fieldMask(
+        {Field::bankAccountUUID, Field::balance, Field::minBalance, Field::withdrawLimit, Field::depositLimit});
+static constexpr uint64_t personFields = fieldMask(
+        {Field::uuid, Field::firstName, Field::middleName, Field::lastName, Field::birthTimestamp, Field::height,
+         Field::bankAccount, Field::vehicles}) | bankAccountFields;
+static constexpr uint64_t dealershipFields = fieldMask(
+        {Field::uuid, Field::name, Field::bankAccount, Field::vehicles}) | bankAccountFields;
+
+/**
+ * Throw an error for a value that doesn't match its field's type
+ * @param field the field
+ * @throws runtime_error always
+ */
+[[noreturn]] static void throwWrongType(Field field) {
+    throw std::runtime_error(std::string(fieldNames[(size_t) field]) + " has the wrong type in JSON");
+}
+
+template<>
+Vehicle *EntityReader::constructVehicle<Sedan>(EntityReader &reader) {
+    return new Sedan(reader.takeString(Field::name), reader.number(Field::price),
+                     reader.takeString(Field::manufacturer), reader.number(Field::mileage),
+                     reader.number(Field::horsepower), reader.number(Field::maxSpeed),
+                     reader.number(Field::trunkCapacity), (int) reader.number(Field::engineCylinderCount),
+                     reader.takeString(Field::color), reader.parseUuid(Field::uuid));
+}
+
+template<>
+Vehicle *EntityReader::constructVehicle<PickupTruck>(EntityReader &reader) {
+    return new PickupTruck(reader.takeString(Field::name), reader.number(Field::price),
+                           reader.takeString(Field::manufacturer), reader.number(Field::mileage),
+                           reader.number(Field::horsepower), reader.number(Field::maxSpeed),
+                           reader.number(Field::bedCapacity), reader.number(Field::towingMaxLoad),
+                           (int) reader.number(Field::engineCylinderCount), reader.takeString(Field::color),
+                           reader.parseUuid(Field::uuid));
+}
+
+template<>
+Vehicle *EntityReader::constructVehicle<Motorcycle>(EntityReader &reader) {
+    return new Motorcycle(reader.takeString(Field::name), reader.number(Field::price),
+                          reader.takeString(Field::manufacturer), reader.number(Field::mileage),
+                          reader.number(Field::horsepower), reader.number(Field::maxSpeed),
+                          reader.takeString(Field::color), reader.number(Field::engineSize),
+                          reader.number(Field::maxAcceleration),
+                          convertMotorcycleTypeStrToEnum(reader.takeString(Field::motorcycleType)),
+                          reader.parseUuid(Field::uuid));
+}
+
+const EntityReader::VehicleType EntityReader::vehicleTypes[] = {
+        {"sedan",        vehicleFields | fieldMask({Field::trunkCapacity, Field::engineCylinderCount}),
+                &EntityReader::constructVehicle<Sedan>},
+        {"pickup-truck", vehicleFields | fieldMask({Field::bedCapacity, Field::towingMaxLoad,
+                                                    Field::engineCylinderCount}),
+                &EntityReader::constructVehicle<PickupTruck>},
+        {"motorcycle",   vehicleFields | fieldMask({Field::engineSize, Field::maxAcceleration,
+                                                    Field::motorcycleType}),
+                &EntityReader::constructVehicle<Motorcycle>}
+};
+
+Vehicle *EntityReader::readVehicle(std::string_view bytes, StorageFormat format) {
+    EntityReader reader;
+    reader.parse(bytes, format);
+    reader.require(fieldBit(Field::type));
+
+    // Dispatch to the constructor registered for the type
+    const std::string &type = reader.strings[(size_t) Field::type];
+    for (const VehicleType &vehicleType: vehicleTypes) {
+        if (vehicleType.name == type) {
+            reader.require(vehicleType.requiredFields);
+            return vehicleType.construct(reader);
+        }
+    }
+
+    throw std::runtime_error("Unknown vehicle type " + type);
+}
+
+Person *EntityReader::readPerson(std::string_view bytes, StorageFormat format, const VehicleCache &vehicleCache) {
+    EntityReader reader;
+    reader.parse(bytes, format);
+    reader.require(personFields);
+
+    auto *account = new BankAccount(reader.number(Field::balance), reader.number(Field::minBalance),
+                                    reader.number(Field::withdrawLimit), reader.number(Field::depositLimit),
+                                    reader.parseUuid(Field::bankAccountUUID));
+    auto *person = new Person(reader.takeString(Field::firstName), reader.takeString(Field::middleName),
+                              reader.takeString(Field::lastName), (int64_t) reader.number(Field::birthTimestamp),
+                              reader.number(Field::height), account, reader.parseUuid(Field::uuid));
+
+    person->vehicles.reserve(reader.vehicles.size());
+    for (const Uuid &uuid: reader.vehicles) {
+        if (!vehicleCache.contains(uuid)) {
+            std::cout << "WARN: Vehicle of UUID " << uuid << " does not exist! Skipping.\n";
+            continue;
+        }
+        person->vehicles.emplace_back(uuid);
+    }
+
+    return person;
+}
+
+VehicleDealership *EntityReader::readDealership(std::string_view bytes, StorageFormat format,
+                                                const VehicleCache &vehicleCache) {
+    EntityReader reader;
+    reader.parse(bytes, format);
+    reader.require(dealershipFields);
+
+    auto *account = new BankAccount(reader.number(Field::balance), reader.number(Field::minBalance),
+                                    reader.number(Field::withdrawLimit), reader.number(Field::depositLimit),
+                                    reader.parseUuid(Field::bankAccountUUID));
+    auto *dealership = new VehicleDealership(reader.takeString(Field::name), account, reader.parseUuid(Field::uuid));
+
+    dealership->vehicles.reserve(reader.vehicles.size());
+    for (const Uuid &uuid: reader.vehicles) {
+        if (!vehicleCache.contains(uuid)) {
+            std::cout << "WARN: Vehicle of UUID " << uuid << " does not exist! Skipping.\n";
+            continue;
+        }
+        dealership->vehicles.emplace_back(uuid);
+    }
+
+    return dealership;
+}
+
+void EntityReader::parse(std::string_view bytes, StorageFormat format) {
+    using nlohmann::detail::input_format_t;
+
+    switch (format) {
+        case StorageFormat::JSON: json::sax_parse(bytes, this, input_format_t::json); break;
+        case StorageFormat::CBOR: json::sax_parse(bytes, this, input_format_t::cbor); break;
+        case StorageFormat::MessagePack: json::sax_parse(bytes, this, input_format_t::msgpack); break;
+        case StorageFormat::BSON: json::sax_parse(bytes, this, input_format_t::bson); break;
+        default: throw std::runtime_error("Unknown storage format");
+    }
+}
+
+void EntityReader::require(uint64_t requiredFields) const {
+    uint64_t missing = requiredFields & ~seen;
+    if (missing == 0) {
+        return;
+    }
+
+    // Name the first one that's missing
+    size_t idx = 0;
+    while (!(missing & (1ULL << idx))) {
+        idx++;
+    }
+    throw std::runtime_error(std::string(fieldNames[idx]) + " does not exist in JSON");
+}
+
+bool EntityReader::storeNumber(double value) {
+    if (skipDepth > 0 || current == Field::unknown) {
+        return true;
+    }
+    if (inVehicles || (fieldBit(current) & (stringFields | otherFields))) {
+        throwWrongType(inVehicles ? Field::vehicles : current);
+    }
+
+    numbers[(size_t) current] = value;
+    seen |= fieldBit(current);
+    return true;
+}
+
+double EntityReader::number(Field field) const {
+    return numbers[(size_t) field];
+}
+
+std::string &&EntityReader::takeString(Field field) {
+    return std::move(strings[(size_t) field]);
+}
+
+Uuid EntityReader::parseUuid(Field field) const {
+    return Uuid::parse(strings[(size_t) field]);
+}
+
+bool EntityReader::null() {
+    if (skipDepth == 0 && (current != Field::unknown || inVehicles)) {
+        throwWrongType(inVehicles ? Field::vehicles : current);
+    }
+
+    return true;
+}
+
+bool EntityReader::boolean(bool) {
+    if (skipDepth > 0 || (current == Field::unknown && !inVehicles)) {
+        return true;
+    }
+    if (inVehicles || current != Field::started) {
+        throwWrongType(inVehicles ? Field::vehicles : current);
+    }
+
+    // Vehicles always start out stopped, so there's nothing to store
+    seen |= fieldBit(current);
+    return true;
+}
+
+bool EntityReader::number_integer(json::number_integer_t value) {
+    return storeNumber((double) value);
+}
+
+bool EntityReader::number_unsigned(json::number_unsigned_t value) {
+    return storeNumber((double) value);
+}
+
+bool EntityReader::number_float(json::number_float_t value, const std::string &) {
+    return storeNumber(value);
+}
+
+bool EntityReader::string(std::string &value) {
+    if (skipDepth > 0) {
+        return true;
+    }
+    if (inVehicles) {
+        vehicles.push_back(Uuid::parse(value));
+        return true;
+    }
+    if (current == Field::unknown) {
+        return true;
+    }
+    if (!(fieldBit(current) & stringFields)) {
+        throwWrongType(current);
+    }
+
+    strings[(size_t) current] = std::move(value);
+    seen |= fieldBit(current);
+    return true;
+}
+
+bool EntityReader::binary(json::binary_t &) {
+    if (skipDepth == 0 && (current != Field::unknown || inVehicles)) {
+        throwWrongType(inVehicles ? Field::vehicles : current);
+    }
+
+    return true;
+}
+
+bool EntityReader::start_object(std::size_t) {
+    // Only the entity itself and its bank account are read, anything else nested is skipped over
+    if (skipDepth > 0 || inVehicles || depth >= 2 || (depth == 1 && current != Field::bankAccount)) {
+        if (skipDepth == 0 && (current != Field::unknown || inVehicles)) {
+            throwWrongType(inVehicles ? Field::vehicles : current);
+        }
+        skipDepth++;
+        return true;
+    }
+
+    depth++;
+    inBankAccount = depth == 2;
+    current = Field::unknown;
+    return true;
+}
+
+bool EntityReader::key(std::string &key) {
+    if (skipDepth > 0) {
+        return true;
+    }
+
+    current = lookupKey(key);
+    if (inBankAccount && current == Field::uuid) {
+        current = Field::bankAccountUUID;
+    }
+    return true;
+}
+
+bool EntityReader::end_object() {
+    if (skipDepth > 0) {
+        skipDepth--;
+        return true;
+    }
+
+    if (inBankAccount) {
+        inBankAccount = false;
+        seen |= fieldBit(Field::bankAccount);
+    }
+    depth--;
+    current = Field::unknown;
+    return true;
+}
+
+bool EntityReader::start_array(std::size_t) {
+    if (skipDepth > 0 || inVehicles || depth != 1 || current != Field::vehicles) {
+        if (skipDepth == 0 && (current != Field::unknown || inVehicles)) {
+            throwWrongType(inVehicles ? Field::vehicles : current);
+        }
+        skipDepth++;
+        return true;
+    }
+
+    inVehicles = true;
+    seen |= fieldBit(Field::vehicles);
+    return true;
+}
+
+bool EntityReader::end_array() {
+    if (skipDepth > 0) {
+        skipDepth--;
+        return true;
+    }
+
+    inVehicles = false;
+    current = Field::unknown;
+    return true;
+}
+
+bool EntityReader::parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &error) {
+    throw std::runtime_error(std::string("Could not parse entity: ") + error.what());
+}
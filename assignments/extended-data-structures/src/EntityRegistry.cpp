@@ -0,0 +1,71 @@
+#include <algorithm>
+#include "EntityRegistry.hpp"
+#include "Person.hpp"
+#include "VehicleDealership.hpp"
+
+void EntityRegistry::reserve(size_t personCount, size_t dealershipCount) {
+    people.reserve(personCount);
+    peopleIndex.reserve(personCount);
+    dealerships.reserve(dealershipCount);
+    dealershipIndex.reserve(dealershipCount);
+}
+
+void EntityRegistry::add(Person *person) {
+    people.push_back(person);
+    peopleIndex.insert(person->getUUID(), person);
+}
+
+void EntityRegistry::add(VehicleDealership *dealership) {
+    dealerships.push_back(dealership);
+    dealershipIndex.insert(dealership->getUUID(), dealership);
+}
+
+void EntityRegistry::addAll(const std::vector<Person *> &newPeople) {
+    reserve(people.size() + newPeople.size(), dealerships.size());
+    for (Person *person: newPeople) {
+        add(person);
+    }
+}
+
+void EntityRegistry::addAll(const std::vector<VehicleDealership *> &newDealerships) {
+    reserve(people.size(), dealerships.size() + newDealerships.size());
+    for (VehicleDealership *dealership: newDealerships) {
+        add(dealership);
+    }
+}
+
+bool EntityRegistry::remove(Person *person) {
+    if (person == nullptr || !peopleIndex.erase(person->getUUID())) {
+        return false;
+    }
+
+    std::erase(people, person);
+    return true;
+}
+
+bool EntityRegistry::remove(VehicleDealership *dealership) {
+    if (dealership == nullptr || !dealershipIndex.erase(dealership->getUUID())) {
+        return false;
+    }
+
+    std::erase(dealerships, dealership);
+    return true;
+}
+
+Person *EntityRegistry::findPerson(const Uuid &uuid) const {
+    Person *const *person = peopleIndex.find(uuid);
+    return person == nullptr ? nullptr : *person;
+}
+
+VehicleDealership *EntityRegistry::findDealership(const Uuid &uuid) const {
+    VehicleDealership *const *dealership = dealershipIndex.find(uuid);
+    return dealership == nullptr ? nullptr : *dealership;
+}
+
+const std::vector<Person *> &EntityRegistry::getPeople() const {
+    return people;
+}
+
+const std::vector<VehicleDealership *> &EntityRegistry::getDealerships() const {
+    return dealerships;
+}
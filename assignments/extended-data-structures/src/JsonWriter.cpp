@@ -0,0 +1,158 @@
+#include <charconv>
+#include <cmath>
+#include "JsonWriter.hpp"
+
+JsonWriter::JsonWriter(std::string &buffer, bool pretty) : buffer(buffer), pretty(pretty) {}
+
+JsonWriter &JsonWriter::beginObject() {
+    beforeElement();
+    buffer += '{';
+    hasElements.push_back(false);
+    return *this;
+}
+
+JsonWriter &JsonWriter::endObject() {
+    bool hadElements = hasElements.back();
+    hasElements.pop_back();
+    if (hadElements) {
+        newLine();
+    }
+    buffer += '}';
+    return *this;
+}
+
+JsonWriter &JsonWriter::beginArray() {
+    beforeElement();
+    buffer += '[';
+    hasElements.push_back(false);
+    return *this;
+}
+
+JsonWriter &JsonWriter::endArray() {
+    bool hadElements = hasElements.back();
+    hasElements.pop_back();
+    if (hadElements) {
+        newLine();
+    }
+    buffer += ']';
+    return *this;
+}
+
+JsonWriter &JsonWriter::key(std::string_view key) {
+    // Keys are written the same way as string values, just followed by a colon
+    value(key);
+    buffer += pretty ? ": " : ":";
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(std::string_view value) {
+    beforeElement();
+    buffer += '"';
+
+    // Copy over runs of characters that don't need escaping in one go
+    size_t runStart = 0;
+    for (size_t i = 0; i < value.size(); i++) {
+        auto c = (unsigned char) value[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        buffer.append(value.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"': buffer += "\\\""; break;
+            case '\\': buffer += "\\\\"; break;
+            case '\b': buffer += "\\b"; break;
+            case '\f': buffer += "\\f"; break;
+            case '\n': buffer += "\\n"; break;
+            case '\r': buffer += "\\r"; break;
+            case '\t': buffer += "\\t"; break;
+            default: {
+                const char hex[] = "0123456789abcdef";
+                buffer += "\\u00";
+                buffer += hex[c >> 4];
+                buffer += hex[c & 0xf];
+            }
+        }
+    }
+    buffer.append(value.data() + runStart, value.size() - runStart);
+
+    buffer += '"';
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(const char *value) {
+    return this->value(std::string_view(value));
+}
+
+JsonWriter &JsonWriter::value(const Uuid &value) {
+    // UUIDs never need escaping, so they're formatted straight into the buffer
+    beforeElement();
+    buffer += '"';
+    size_t start = buffer.size();
+    buffer.resize(start + Uuid::stringLength);
+    value.format(buffer.data() + start);
+    buffer += '"';
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(double value) {
+    beforeElement();
+    if (!std::isfinite(value)) {
+        buffer += "null";
+        return *this;
+    }
+
+    char digits[32];
+    char *end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    buffer.append(digits, end);
+
+    // Keep it a floating point number when it's read back in
+    if (std::string_view(digits, end - digits).find_first_of(".e") == std::string_view::npos) {
+        buffer += ".0";
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(int64_t value) {
+    beforeElement();
+    char digits[24];
+    char *end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    buffer.append(digits, end);
+    return *this;
+}
+
+JsonWriter &JsonWriter::value(int value) {
+    return this->value((int64_t) value);
+}
+
+JsonWriter &JsonWriter::value(bool value) {
+    beforeElement();
+    buffer += value ? "true" : "false";
+    return *this;
+}
+
+void JsonWriter::beforeElement() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (hasElements.empty()) {
+        // Top level value
+        return;
+    }
+
+    if (hasElements.back()) {
+        buffer += ',';
+    }
+    hasElements.back() = true;
+    newLine();
+}
+
+void JsonWriter::newLine() {
+    if (pretty) {
+        buffer += '\n';
+        buffer.append(hasElements.size() * 4, ' ');
+    }
+}
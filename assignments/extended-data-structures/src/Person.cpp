@@ -1,4 +1,6 @@
 #include "Person.hpp"
+#include "VehicleCache.hpp"
+#include "StorageFormat.hpp"
 #include <string>
 #include <chrono>
 // #include "include/uuid_v4/uuid_v4.h.old"
@@ -20,19 +22,21 @@ Person::Person(std::string firstName, std::string middleName, std::string lastNa
     this->birthTimestamp = birthTimestamp;
     this->height = height;
     this->bankAccount = bankAccount;
+    this->dirty = true;
 
-    this->uuid = generate_uuid_v4();
+    this->uuid = Uuid::generate();
 }
 
 Person::Person(std::string firstName, std::string middleName, std::string lastName, int64_t birthTimestamp,
                double height,
-               BankAccount *bankAccount, std::string uuid) {
+               BankAccount *bankAccount, Uuid uuid) {
     this->firstName = firstName;
     this->middleName = middleName;
     this->lastName = lastName;
     this->birthTimestamp = birthTimestamp;
     this->height = height;
     this->bankAccount = bankAccount;
+    this->dirty = true;
 
     this->uuid = uuid;
 }
@@ -48,6 +52,7 @@ bool Person::setFirstName(std::string newName) {
     }
 
     this->firstName = newName;
+    dirty = true;
     return true;
 }
 
@@ -57,6 +62,7 @@ std::string Person::getMiddleName() {
 
 bool Person::setMiddleName(std::string newName) {
     this->middleName = newName;
+    dirty = true;
     return true;
 }
 
@@ -71,6 +77,7 @@ bool Person::setLastName(std::string newName) {
     }
 
     this->lastName = newName;
+    dirty = true;
     return true;
 }
 
@@ -78,6 +85,23 @@ int64_t Person::getBirthTimestamp() const {
     return birthTimestamp;
 }
 
+Uuid Person::getUUID() const {
+    return uuid;
+}
+
+bool Person::isDirty() const {
+    return dirty || bankAccount->isDirty();
+}
+
+void Person::markDirty() {
+    dirty = true;
+}
+
+void Person::markClean() {
+    dirty = false;
+    bankAccount->markClean();
+}
+
 bool Person::changeHeight(double delta) {
     if (height + delta <= 0) {
         // Ensure that the new name is valid
@@ -85,6 +109,7 @@ bool Person::changeHeight(double delta) {
     }
 
     height += delta;
+    dirty = true;
     return true;
 }
 
@@ -100,7 +125,7 @@ json Person::serializeToJSON() {
     json serialized = {};
 
     // Store all important info into JSON object
-    serialized["uuid"] = uuid;
+    serialized["uuid"] = uuid.toString();
     serialized["firstName"] = firstName;
     serialized["middleName"] = middleName;
     serialized["lastName"] = lastName;
@@ -108,14 +133,35 @@ json Person::serializeToJSON() {
     serialized["height"] = height;
     serialized["bankAccount"] = bankAccount->serializeToJSON();
     serialized["vehicles"] = json::array();
-    for (Vehicle *vehicle: vehicles) {
-        serialized["vehicles"].push_back(vehicle->getUUID());
+    for (const VehicleRef &vehicle: vehicles) {
+        serialized["vehicles"].push_back(vehicle.getUUID().toString());
     }
 
     return serialized;
 }
 
-Person Person::deserializeFromJSON(const json &data, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers) {
+void Person::writeJSON(JsonWriter &writer) const {
+    writer.beginObject();
+    writer.field("uuid", uuid);
+    writer.field("firstName", firstName);
+    writer.field("middleName", middleName);
+    writer.field("lastName", lastName);
+    writer.field("birthTimestamp", birthTimestamp);
+    writer.field("height", height);
+
+    // The bank account goes straight into the same buffer
+    writer.key("bankAccount");
+    bankAccount->writeJSON(writer);
+
+    writer.key("vehicles").beginArray();
+    for (const VehicleRef &vehicle: vehicles) {
+        writer.value(vehicle.getUUID());
+    }
+    writer.endArray();
+    writer.endObject();
+}
+
+Person Person::deserializeFromJSON(const json &data, const VehicleCache &vehicleCache) {
     // Ensure that all keys are there
     std::vector<std::string> requiredKeys = {"uuid", "firstName", "middleName", "lastName", "birthTimestamp", "height",
                                              "bankAccount", "vehicles"};
@@ -131,15 +177,16 @@ Person Person::deserializeFromJSON(const json &data, std::map<std::string, Vehic
     Person tmpPerson{data["firstName"].get<std::string>(), data["middleName"].get<std::string>(),
                      data["lastName"].get<std::string>(), data["birthTimestamp"].get<int>(),
                      data["height"].get<double>(),
-                     tmpAccount, data["uuid"].get<std::string>()};
+                     tmpAccount, Uuid::parse(data["uuid"].get<std::string>())};
 
-    for (std::string uuid: data["vehicles"].get<json>()) {
+    for (const json &uuidData: data["vehicles"]) {
         // tmpPerson.vehicles.push_back(new Vehicle(Vehicle::deserializeFromJSON(vehicleData)));
-        if (!vehicleUUIDsToPointers.contains(uuid)) {
+        Uuid uuid = Uuid::parse(uuidData.get<std::string>());
+        if (!vehicleCache.contains(uuid)) {
             std::cout << "WARN: Vehicle of UUID " << uuid << " does not exist! Skipping.\n";
             continue;
         }
-        tmpPerson.vehicles.push_back(vehicleUUIDsToPointers.at(uuid));
+        tmpPerson.vehicles.emplace_back(uuid);
     }
 
     // Initialize Person using all the info
@@ -147,7 +194,9 @@ Person Person::deserializeFromJSON(const json &data, std::map<std::string, Vehic
 }
 
 void Person::saveAsFile() {
-    json serializedJSON = serializeToJSON();
+    // JSON files are indented so they can still be read by people
+    std::string encoded;
+    encodeEntity(*this, storageFormat, encoded, true);
 
     // Make data directory if needed
     if (!fs::is_directory("data") || !fs::exists("data")) { // Check if folder exists
@@ -159,27 +208,23 @@ void Person::saveAsFile() {
         fs::create_directory("data/people");
     }
 
-    // Write data to file
-    std::ofstream file("data/people/" + uuid + ".json");
-    file << std::setw(4) << serializedJSON << std::endl;
-    file.close();
+    // Write data to file in the storage format
+    writeEntityBytes("data/people", uuid, encoded);
 }
 
-Person Person::loadFromPath(std::string path, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers) {
+Person Person::loadFromPath(std::string path, const VehicleCache &vehicleCache) {
     if (!fs::exists(path)) {
         // File needs to exist to read anything
         throw std::runtime_error(path + " does not exist");
     }
 
-    std::ifstream file(path);
-    json importedJSON;
-    file >> importedJSON;
+    json importedJSON = readEntityFile(path);
 
-    return Person::deserializeFromJSON(importedJSON, vehicleUUIDsToPointers);
+    return Person::deserializeFromJSON(importedJSON, vehicleCache);
 }
 
-Person Person::loadFromUUID(std::string uuid, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers) {
-    return Person::loadFromPath("data/people/" + uuid + ".json", vehicleUUIDsToPointers);
+Person Person::loadFromUUID(const Uuid &uuid, const VehicleCache &vehicleCache) {
+    return Person::loadFromPath(findEntityFile("data/people", uuid), vehicleCache);
 }
 
 Person::~Person() {
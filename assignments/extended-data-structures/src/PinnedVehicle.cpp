@@ -0,0 +1,52 @@
+#include <utility>
+#include "PinnedVehicle.hpp"
+#include "VehicleCache.hpp"
+
+PinnedVehicle::PinnedVehicle(VehicleCache *cache, Vehicle *vehicle) {
+    this->cache = cache;
+    this->vehicle = vehicle;
+}
+
+PinnedVehicle::PinnedVehicle(PinnedVehicle &&other) noexcept {
+    cache = std::exchange(other.cache, nullptr);
+    vehicle = std::exchange(other.vehicle, nullptr);
+}
+
+PinnedVehicle &PinnedVehicle::operator=(PinnedVehicle &&other) noexcept {
+    if (this != &other) {
+        release();
+        cache = std::exchange(other.cache, nullptr);
+        vehicle = std::exchange(other.vehicle, nullptr);
+    }
+
+    return *this;
+}
+
+PinnedVehicle::~PinnedVehicle() {
+    release();
+}
+
+Vehicle *PinnedVehicle::get() const {
+    return vehicle;
+}
+
+Vehicle *PinnedVehicle::operator->() const {
+    return vehicle;
+}
+
+Vehicle &PinnedVehicle::operator*() const {
+    return *vehicle;
+}
+
+PinnedVehicle::operator bool() const {
+    return vehicle != nullptr;
+}
+
+void PinnedVehicle::release() {
+    if (vehicle != nullptr) {
+        cache->unpin(vehicle->getUUID());
+    }
+
+    cache = nullptr;
+    vehicle = nullptr;
+}
@@ -0,0 +1,502 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include "SnapshotStore.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * Write all of a buffer into a file at an offset
+ * @param fd the file
+ * @param data the bytes to write
+ * @param size # of bytes
+ * @param offset where in the file to write them
+ * @param path path of the file, for errors
+ * @throws runtime_error if the bytes could not be written
+ */
+static void writeAt(int fd, const char *data, size_t size, uint64_t offset, const std::string &path) {
+    size_t written = 0;
+    while (written < size) {
+        ssize_t result = ::pwrite(fd, data + written, size - written, (off_t) (offset + written));
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Could not write " + path + ": " + std::strerror(errno));
+        }
+        written += result;
+    }
+}
+
+/**
+ * Wait until everything written to a file is on disk
+ * @param fd the file
+ * @param path path of the file, for errors
+ * @throws runtime_error if it could not be synced
+ */
+static void syncFile(int fd, const std::string &path) {
+    if (::fsync(fd) != 0) {
+        throw std::runtime_error("Could not sync " + path + ": " + std::strerror(errno));
+    }
+}
+
+/**
+ * Wait until the entries of a folder are on disk, so a file renamed into it stays renamed after a crash
+ * @param path path of a file in the folder
+ * @throws runtime_error if the folder could not be synced
+ */
+static void syncParentFolder(const std::string &path) {
+    fs::path folder = fs::path(path).parent_path();
+    if (folder.empty()) {
+        folder = fs::path(".");
+    }
+
+    int fd = ::open(folder.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open " + folder.string() + ": " + std::strerror(errno));
+    }
+    int result = ::fsync(fd);
+    ::close(fd);
+    if (result != 0) {
+        throw std::runtime_error("Could not sync " + folder.string() + ": " + std::strerror(errno));
+    }
+}
+
+/**
+ * Validate a snapshot header
+ * @param header the header to validate
+ * @param fileSize size of the whole snapshot file
+ * @param path path of the snapshot file, for errors
+ * @throws runtime_error if the header is not from a snapshot this version can read, or points past the file
+ */
+static void validateHeader(const SnapshotHeader &header, uint64_t fileSize, const std::string &path) {
+    if (std::memcmp(header.magic, SnapshotStore::magic, sizeof(SnapshotStore::magic)) != 0 ||
+        header.version < SnapshotStore::oldestVersion || header.version > SnapshotStore::version) {
+        throw std::runtime_error(path + " is not a snapshot that can be read (versions " +
+                                 std::to_string(SnapshotStore::oldestVersion) + " to " +
+                                 std::to_string(SnapshotStore::version) + ")");
+    }
+    if (header.indexOffset + header.indexSize > fileSize) {
+        throw std::runtime_error(path + " is truncated or corrupt");
+    }
+}
+
+/**
+ * Validate and read a snapshot index
+ * @param index pointer to the first byte of the index
+ * @param header the header of the snapshot
+ * @param path path of the snapshot file, for errors
+ * @return every entry in the index
+ * @throws runtime_error if the index failed its checksum or is malformed
+ */
+static std::vector<SnapshotEntry> readIndex(const char *index, const SnapshotHeader &header, const std::string &path) {
+    if (fnv1a64(index, header.indexSize) != header.indexChecksum) {
+        throw std::runtime_error(path + " failed its index checksum");
+    }
+
+    uint64_t pos = 0;
+    uint64_t end = header.indexSize;
+    std::vector<SnapshotEntry> entries;
+    entries.reserve(header.entryCount);
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        SnapshotEntry entry;
+        entry.kind = readRaw<EntityKind>(index, pos, end);
+        // Version 2 snapshots only ever stored JSON
+        entry.format = header.version >= 3 ? readRaw<StorageFormat>(index, pos, end) : StorageFormat::JSON;
+        auto uuidSize = readRaw<uint8_t>(index, pos, end);
+        entry.size = readRaw<uint32_t>(index, pos, end);
+        entry.offset = readRaw<uint64_t>(index, pos, end);
+        entry.checksum = readRaw<uint64_t>(index, pos, end);
+        if (pos + uuidSize > end || entry.offset + entry.size > header.indexOffset ||
+            !Uuid::tryParse(std::string_view(index + pos, uuidSize), entry.uuid)) {
+            throw std::runtime_error(path + " is truncated or corrupt");
+        }
+        pos += uuidSize;
+
+        entries.push_back(std::move(entry));
+    }
+
+    return entries;
+}
+
+uint64_t fnv1a64(const char *bytes, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char) bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+std::string getEntityFolder(EntityKind kind) {
+    switch (kind) {
+        case EntityKind::Vehicle: return "vehicles";
+        case EntityKind::Person: return "people";
+        case EntityKind::Dealership: return "vehicle-dealership";
+        default: throw std::runtime_error("Unknown entity kind");
+    }
+}
+
+SnapshotWriter::SnapshotWriter() {
+    // Leave room for the header, it's filled in once the index is written
+    buffer.resize(sizeof(SnapshotHeader));
+}
+
+SnapshotWriter::SnapshotWriter(const std::string &path) : path(path) {
+    if (!fs::exists(path)) {
+        // File needs to exist to read anything
+        throw std::runtime_error(path + " does not exist");
+    }
+
+    // Only the header and index are needed, the entities themselves stay on disk
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    SnapshotHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file) {
+        throw std::runtime_error("Could not read " + path);
+    }
+    validateHeader(header, fs::file_size(path), path);
+
+    std::string index(header.indexSize, '\0');
+    file.seekg((std::streamoff) header.indexOffset);
+    file.read(index.data(), (std::streamsize) index.size());
+    if (!file) {
+        throw std::runtime_error("Could not read " + path);
+    }
+    entries = readIndex(index.data(), header, path);
+    logSequence = header.logSequence;
+
+    uuidsToEntries.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        uuidsToEntries.insert(entries[i].uuid, i);
+        liveBytes += entries[i].size;
+    }
+
+    // New entities go after the current index, which is left in place until the header stops pointing at it
+    bufferOffset = header.indexOffset + header.indexSize;
+}
+
+void SnapshotWriter::add(EntityKind kind, const Uuid &uuid, const json &data) {
+    add(kind, uuid, encodeData(data, storageFormat), storageFormat);
+}
+
+void SnapshotWriter::add(EntityKind kind, const Uuid &uuid, std::string_view bytes, StorageFormat format) {
+    SnapshotEntry entry{kind, format, uuid, bufferOffset + buffer.size(), (uint32_t) bytes.size(),
+                        fnv1a64(bytes.data(), bytes.size())};
+    buffer += bytes;
+    liveBytes += entry.size;
+
+    // Replace the old copy if there is one, it becomes garbage in the file
+    size_t *existing = uuidsToEntries.find(uuid);
+    if (existing != nullptr) {
+        liveBytes -= entries[*existing].size;
+        entries[*existing] = std::move(entry);
+        return;
+    }
+
+    uuidsToEntries.insert(uuid, entries.size());
+    entries.push_back(std::move(entry));
+}
+
+bool SnapshotWriter::remove(const Uuid &uuid) {
+    size_t *existing = uuidsToEntries.find(uuid);
+    if (existing == nullptr) {
+        return false;
+    }
+
+    // Swap the last entry into its place, the index is regrouped by kind when it's written anyways
+    size_t idx = *existing;
+    liveBytes -= entries[idx].size;
+    uuidsToEntries.erase(uuid);
+    if (idx != entries.size() - 1) {
+        entries[idx] = std::move(entries.back());
+        uuidsToEntries.insert(entries[idx].uuid, idx);
+    }
+    entries.pop_back();
+
+    return true;
+}
+
+void SnapshotWriter::setLogSequence(uint64_t sequence) {
+    logSequence = sequence;
+}
+
+size_t SnapshotWriter::size() const {
+    return entries.size();
+}
+
+void SnapshotWriter::write(const std::string &path) {
+    // Rewrite instead of appending if it's a new file, or once more than half of the file is garbage
+    uint64_t garbageBytes = bufferOffset + buffer.size() - sizeof(SnapshotHeader) - liveBytes;
+    if (bufferOffset == 0 || path != this->path || garbageBytes > liveBytes) {
+        rewrite(path);
+    } else {
+        append();
+    }
+}
+
+std::string SnapshotWriter::buildIndex() const {
+    // Each entry is the kind, format, UUID length, size, offset, checksum, then the UUID itself as text
+    std::string index;
+    for (EntityKind kind: {EntityKind::Vehicle, EntityKind::Person, EntityKind::Dealership}) {
+        for (const SnapshotEntry &entry: entries) {
+            if (entry.kind != kind) {
+                continue;
+            }
+
+            appendRaw(index, entry.kind);
+            appendRaw(index, entry.format);
+            appendRaw(index, (uint8_t) Uuid::stringLength);
+            appendRaw(index, entry.size);
+            appendRaw(index, entry.offset);
+            appendRaw(index, entry.checksum);
+            index.resize(index.size() + Uuid::stringLength);
+            entry.uuid.format(index.data() + index.size() - Uuid::stringLength);
+        }
+    }
+
+    return index;
+}
+
+SnapshotHeader SnapshotWriter::buildHeader(uint64_t indexOffset, const std::string &index) const {
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SnapshotStore::magic, sizeof(SnapshotStore::magic));
+    header.version = SnapshotStore::version;
+    header.entryCount = (uint32_t) entries.size();
+    header.indexOffset = indexOffset;
+    header.indexSize = index.size();
+    header.indexChecksum = fnv1a64(index.data(), index.size());
+    header.logSequence = logSequence;
+
+    return header;
+}
+
+void SnapshotWriter::append() {
+    std::string index = buildIndex();
+    uint64_t indexOffset = bufferOffset + buffer.size();
+    SnapshotHeader header = buildHeader(indexOffset, index);
+
+    int fd = ::open(path.c_str(), O_WRONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open " + path + " for writing: " + std::strerror(errno));
+    }
+
+    try {
+        // Write the new entities and index past the old index first, and make sure they're on disk before the header
+        // points at them, so the old header stays valid until the very end
+        writeAt(fd, buffer.data(), buffer.size(), bufferOffset, path);
+        writeAt(fd, index.data(), index.size(), indexOffset, path);
+        syncFile(fd, path);
+
+        writeAt(fd, reinterpret_cast<const char *>(&header), sizeof(header), 0, path);
+        syncFile(fd, path);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+
+    buffer.clear();
+    bufferOffset = indexOffset + index.size();
+}
+
+void SnapshotWriter::rewrite(const std::string &path) {
+    if (bufferOffset != 0) {
+        // Some entities are still only in the old file, so gather every live entity into a fresh buffer
+        std::string old(bufferOffset, '\0');
+        std::ifstream oldFile(this->path, std::ios::in | std::ios::binary);
+        oldFile.read(old.data(), (std::streamsize) old.size());
+        if (!oldFile) {
+            throw std::runtime_error("Could not read " + this->path);
+        }
+
+        std::string fresh(sizeof(SnapshotHeader), '\0');
+        for (SnapshotEntry &entry: entries) {
+            const char *payload = entry.offset < bufferOffset ? old.data() + entry.offset
+                                                              : buffer.data() + (entry.offset - bufferOffset);
+            entry.offset = fresh.size();
+            fresh.append(payload, entry.size);
+        }
+        buffer = std::move(fresh);
+        bufferOffset = 0;
+    }
+
+    std::string index = buildIndex();
+    uint64_t indexOffset = buffer.size();
+    SnapshotHeader header = buildHeader(indexOffset, index);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    // Write everything next to the old snapshot, then swap it in
+    std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open " + tmpPath + " for writing: " + std::strerror(errno));
+    }
+
+    try {
+        // The new snapshot has to be on disk before it replaces the old one, and the rename has to be on disk before
+        // the write-ahead log can be emptied
+        writeAt(fd, buffer.data(), buffer.size(), 0, tmpPath);
+        writeAt(fd, index.data(), index.size(), indexOffset, tmpPath);
+        syncFile(fd, tmpPath);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    fs::rename(tmpPath, path);
+    syncParentFolder(path);
+
+    // Any later writes get appended to this file
+    this->path = path;
+    buffer.clear();
+    bufferOffset = indexOffset + index.size();
+}
+
+SnapshotStore::SnapshotStore(const std::string &path, bool lazy) : path(path), lazy(lazy) {
+    if (!fs::exists(path)) {
+        // File needs to exist to read anything
+        throw std::runtime_error(path + " does not exist");
+    }
+
+    file.open(path, std::ios::in | std::ios::binary);
+    uint64_t fileSize = fs::file_size(path);
+    SnapshotHeader header{};
+    if (lazy) {
+        // Only read the header and index, the file stays open to read entities from later
+        std::string index;
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (file) {
+            validateHeader(header, fileSize, path);
+            index.resize(header.indexSize);
+            file.seekg((std::streamoff) header.indexOffset);
+            file.read(index.data(), (std::streamsize) index.size());
+        }
+        if (!file) {
+            throw std::runtime_error("Could not read " + path);
+        }
+        entries = readIndex(index.data(), header, path);
+    } else {
+        // One sequential read of the whole file, everything after this works from memory
+        data.resize(fileSize);
+        file.read(data.data(), (std::streamsize) data.size());
+        if (!file || data.size() < sizeof(SnapshotHeader)) {
+            throw std::runtime_error("Could not read " + path);
+        }
+        file.close();
+
+        // Validate the header before trusting any of the offsets
+        std::memcpy(&header, data.data(), sizeof(header));
+        validateHeader(header, data.size(), path);
+        entries = readIndex(data.data() + header.indexOffset, header, path);
+    }
+    logSequence = header.logSequence;
+}
+
+const std::vector<SnapshotEntry> &SnapshotStore::getEntries() const {
+    return entries;
+}
+
+uint64_t SnapshotStore::getLogSequence() const {
+    return logSequence;
+}
+
+std::string_view SnapshotStore::getPayload(const SnapshotEntry &entry) const {
+    if (lazy) {
+        throw std::runtime_error(path + " was opened lazily, entities are still in the file");
+    }
+
+    return {data.data() + entry.offset, entry.size};
+}
+
+std::string_view SnapshotStore::readBytes(const SnapshotEntry &entry, std::string &buffer) const {
+    std::string_view payload;
+    if (lazy) {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        buffer.resize(entry.size);
+        file.seekg((std::streamoff) entry.offset);
+        file.read(buffer.data(), (std::streamsize) buffer.size());
+        if (!file) {
+            file.clear();
+            throw std::runtime_error("Could not read entity " + entry.uuid.toString() + " from " + path);
+        }
+        payload = buffer;
+    } else {
+        payload = getPayload(entry);
+    }
+
+    if (fnv1a64(payload.data(), payload.size()) != entry.checksum) {
+        throw std::runtime_error("Entity " + entry.uuid.toString() + " in " + path + " failed its checksum");
+    }
+
+    return payload;
+}
+
+json SnapshotStore::read(const SnapshotEntry &entry) const {
+    std::string buffer;
+    return decodeData(readBytes(entry, buffer), entry.format);
+}
+
+size_t SnapshotStore::importFolder(const std::string &dataPath, const std::string &snapshotPath) {
+    SnapshotWriter writer;
+
+    // Vehicles first, since people and dealerships refer to them
+    for (EntityKind kind: {EntityKind::Vehicle, EntityKind::Person, EntityKind::Dealership}) {
+        fs::path folder = fs::path(dataPath) / getEntityFolder(kind);
+        if (!fs::is_directory(folder)) {
+            continue;
+        }
+
+        for (const auto &entry: fs::directory_iterator(folder)) {
+            StorageFormat format;
+            if (!tryGetFormatFromPath(entry.path().string(), format)) {
+                std::cout << "WARN: " << entry.path().string() << " is not in a known storage format! Skipping.\n";
+                continue;
+            }
+            json importedJSON = readEntityFile(entry.path().string());
+
+            if (!importedJSON.contains("uuid")) {
+                throw std::runtime_error(entry.path().string() + " does not have a UUID");
+            }
+            writer.add(kind, Uuid::parse(importedJSON["uuid"].get<std::string>()), importedJSON);
+        }
+    }
+
+    writer.write(snapshotPath);
+    return writer.size();
+}
+
+size_t SnapshotStore::convert(const std::string &snapshotPath, StorageFormat format) {
+    SnapshotStore store(snapshotPath);
+    SnapshotWriter writer;
+
+    StorageFormat previousFormat = storageFormat;
+    storageFormat = format;
+    for (const SnapshotEntry &entry: store.getEntries()) {
+        writer.add(entry.kind, entry.uuid, store.read(entry));
+    }
+    storageFormat = previousFormat;
+
+    // The log still applies on top of the converted snapshot, since none of the data changed
+    writer.setLogSequence(store.getLogSequence());
+    writer.write(snapshotPath);
+    return writer.size();
+}
+
+size_t SnapshotStore::exportFolder(const std::string &dataPath) const {
+    for (EntityKind kind: {EntityKind::Vehicle, EntityKind::Person, EntityKind::Dealership}) {
+        fs::create_directories(fs::path(dataPath) / getEntityFolder(kind));
+    }
+
+    for (const SnapshotEntry &entry: entries) {
+        writeEntityFile((fs::path(dataPath) / getEntityFolder(entry.kind)).string(), entry.uuid, read(entry));
+    }
+
+    return entries.size();
+}
@@ -0,0 +1,186 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+#include "StorageFormat.hpp"
+#include "SnapshotStore.hpp"
+
+namespace fs = std::filesystem;
+
+StorageFormat storageFormat = StorageFormat::JSON;
+
+/**
+ * Every storage format, in the order of the enum
+ */
+static const StorageFormat allFormats[] = {StorageFormat::JSON, StorageFormat::CBOR, StorageFormat::MessagePack,
+                                           StorageFormat::BSON};
+
+StorageFormat parseStorageFormat(const std::string &name) {
+    for (StorageFormat format: allFormats) {
+        if (getStorageFormatName(format) == name) {
+            return format;
+        }
+    }
+
+    throw std::runtime_error("Unknown storage format " + name + " (expected json, cbor, msgpack or bson)");
+}
+
+std::string getStorageFormatName(StorageFormat format) {
+    switch (format) {
+        case StorageFormat::JSON: return "json";
+        case StorageFormat::CBOR: return "cbor";
+        case StorageFormat::MessagePack: return "msgpack";
+        case StorageFormat::BSON: return "bson";
+        default: throw std::runtime_error("Unknown storage format");
+    }
+}
+
+std::string getFileExtension(StorageFormat format) {
+    // Appended rather than using operator+ on the temporary, which GCC 12 wrongly flags with -Wrestrict
+    std::string extension = ".";
+    extension += getStorageFormatName(format);
+    return extension;
+}
+
+StorageFormat getFormatFromPath(const std::string &path) {
+    StorageFormat format;
+    if (!tryGetFormatFromPath(path, format)) {
+        throw std::runtime_error(path + " is not in a known storage format");
+    }
+
+    return format;
+}
+
+bool tryGetFormatFromPath(const std::string &path, StorageFormat &format) {
+    std::string extension = fs::path(path).extension().string();
+    for (StorageFormat candidate: allFormats) {
+        if (getFileExtension(candidate) == extension) {
+            format = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string encodeData(const json &data, StorageFormat format, bool pretty) {
+    std::string bytes;
+    switch (format) {
+        case StorageFormat::JSON:
+            return pretty ? data.dump(4) : data.dump();
+        case StorageFormat::CBOR:
+            json::to_cbor(data, bytes);
+            return bytes;
+        case StorageFormat::MessagePack:
+            json::to_msgpack(data, bytes);
+            return bytes;
+        case StorageFormat::BSON:
+            json::to_bson(data, bytes);
+            return bytes;
+        default:
+            throw std::runtime_error("Unknown storage format");
+    }
+}
+
+json decodeData(std::string_view bytes, StorageFormat format) {
+    switch (format) {
+        case StorageFormat::JSON: return json::parse(bytes);
+        case StorageFormat::CBOR: return json::from_cbor(bytes);
+        case StorageFormat::MessagePack: return json::from_msgpack(bytes);
+        case StorageFormat::BSON: return json::from_bson(bytes);
+        default: throw std::runtime_error("Unknown storage format");
+    }
+}
+
+void writeEntityFile(const std::string &folder, const Uuid &uuid, const json &data) {
+    // JSON files are indented so they can still be read by people
+    writeEntityBytes(folder, uuid, encodeData(data, storageFormat, true));
+}
+
+void writeEntityBytes(const std::string &folder, const Uuid &uuid, std::string_view bytes) {
+    fs::path path = fs::path(folder) / (uuid.toString() + getFileExtension(storageFormat));
+    std::ofstream file(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open " + path.string() + " for writing");
+    }
+
+    file.write(bytes.data(), (std::streamsize) bytes.size());
+    if (storageFormat == StorageFormat::JSON) {
+        file << "\n";
+    }
+    file.close();
+
+    // Don't leave an older copy in another format behind to be loaded instead
+    for (StorageFormat format: allFormats) {
+        if (format != storageFormat) {
+            fs::remove(fs::path(folder) / (uuid.toString() + getFileExtension(format)));
+        }
+    }
+}
+
+std::string readEntityBytes(const std::string &path) {
+    if (!fs::exists(path)) {
+        // File needs to exist to read anything
+        throw std::runtime_error(path + " does not exist");
+    }
+
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+json readEntityFile(const std::string &path) {
+    return decodeData(readEntityBytes(path), getFormatFromPath(path));
+}
+
+std::string findEntityFile(const std::string &folder, const Uuid &uuid) {
+    // Check the current format first, since that's where it was most likely saved
+    std::string path = (fs::path(folder) / (uuid.toString() + getFileExtension(storageFormat))).string();
+    if (fs::exists(path)) {
+        return path;
+    }
+
+    for (StorageFormat format: allFormats) {
+        path = (fs::path(folder) / (uuid.toString() + getFileExtension(format))).string();
+        if (fs::exists(path)) {
+            return path;
+        }
+    }
+
+    throw std::runtime_error("No file for " + uuid.toString() + " exists in " + folder);
+}
+
+size_t convertFolder(const std::string &dataPath, StorageFormat format) {
+    StorageFormat previousFormat = storageFormat;
+    storageFormat = format;
+
+    size_t count = 0;
+    for (EntityKind kind: {EntityKind::Vehicle, EntityKind::Person, EntityKind::Dealership}) {
+        fs::path folder = fs::path(dataPath) / getEntityFolder(kind);
+        if (!fs::is_directory(folder)) {
+            continue;
+        }
+
+        // List the files first, since converting them changes the folder
+        std::vector<fs::path> paths;
+        for (const auto &entry: fs::directory_iterator(folder)) {
+            paths.push_back(entry.path());
+        }
+
+        for (const fs::path &path: paths) {
+            StorageFormat fileFormat;
+            if (!tryGetFormatFromPath(path.string(), fileFormat)) {
+                std::cout << "WARN: " << path.string() << " is not in a known storage format! Skipping.\n";
+                continue;
+            }
+            if (fileFormat != format) {
+                writeEntityFile(folder.string(), Uuid::parse(path.stem().string()), readEntityFile(path.string()));
+                count++;
+            }
+        }
+    }
+
+    storageFormat = previousFormat;
+    return count;
+}
@@ -0,0 +1,150 @@
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include "Uuid.hpp"
+
+/**
+ * Positions of the dashes in the text form of a UUID
+ */
+static constexpr size_t dashPositions[] = {8, 13, 18, 23};
+
+/**
+ * A xoshiro256** random number generator. It's much faster than std::mt19937 and only needs 32 bytes of state, so
+ * every thread can have its own without any locking.
+ */
+class UuidGenerator {
+public:
+    UuidGenerator() {
+        // Seed from the OS once per thread, spreading it out with splitmix64 so the state is never all zero
+        std::random_device rd;
+        uint64_t seed = ((uint64_t) rd() << 32) ^ rd();
+        for (uint64_t &word: state) {
+            seed += 0x9e3779b97f4a7c15;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotateLeft(state[3], 45);
+        return result;
+    }
+
+private:
+    static uint64_t rotateLeft(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t state[4];
+};
+
+Uuid Uuid::generate() {
+    thread_local UuidGenerator generator;
+
+    uint64_t halves[2] = {generator.next(), generator.next()};
+    Uuid uuid;
+    std::memcpy(uuid.bytes.data(), halves, sizeof(halves));
+
+    // Mark it as version 4 (random), variant 1
+    uuid.bytes[6] = (uuid.bytes[6] & 0x0f) | 0x40;
+    uuid.bytes[8] = (uuid.bytes[8] & 0x3f) | 0x80;
+    return uuid;
+}
+
+Uuid Uuid::parse(std::string_view text) {
+    Uuid uuid;
+    if (!tryParse(text, uuid)) {
+        throw std::runtime_error("\"" + std::string(text) + "\" is not a valid UUID");
+    }
+
+    return uuid;
+}
+
+bool Uuid::tryParse(std::string_view text, Uuid &uuid) {
+    if (text.size() != stringLength) {
+        return false;
+    }
+    for (size_t position: dashPositions) {
+        if (text[position] != '-') {
+            return false;
+        }
+    }
+
+    // Gather the 32 hex digits without the dashes, then convert them all at once. The conversion has no branches, so
+    // the compiler can turn it into vector instructions.
+    char digits[32];
+    std::memcpy(digits, text.data(), 8);
+    std::memcpy(digits + 8, text.data() + 9, 4);
+    std::memcpy(digits + 12, text.data() + 14, 4);
+    std::memcpy(digits + 16, text.data() + 19, 4);
+    std::memcpy(digits + 20, text.data() + 24, 12);
+
+    uint8_t nibbles[32];
+    uint8_t invalid = 0;
+    for (size_t i = 0; i < 32; i++) {
+        auto c = (uint8_t) digits[i];
+        auto digit = (uint8_t) (c - '0');
+        auto letter = (uint8_t) ((c | 0x20) - 'a');
+        uint8_t isDigit = digit < 10;
+        uint8_t isLetter = letter < 6;
+        nibbles[i] = isDigit ? digit : (uint8_t) (letter + 10);
+        invalid |= !(isDigit | isLetter);
+    }
+    if (invalid) {
+        return false;
+    }
+
+    for (size_t i = 0; i < 16; i++) {
+        uuid.bytes[i] = (uint8_t) ((nibbles[i * 2] << 4) | nibbles[i * 2 + 1]);
+    }
+    return true;
+}
+
+void Uuid::format(char *out) const {
+    // Convert every nibble to a hex digit with no branches, so the compiler can turn it into vector instructions
+    char digits[32];
+    for (size_t i = 0; i < 32; i++) {
+        auto nibble = (uint8_t) ((i % 2 == 0 ? bytes[i / 2] >> 4 : bytes[i / 2]) & 0x0f);
+        digits[i] = (char) (nibble + (nibble < 10 ? '0' : 'a' - 10));
+    }
+
+    std::memcpy(out, digits, 8);
+    std::memcpy(out + 9, digits + 8, 4);
+    std::memcpy(out + 14, digits + 12, 4);
+    std::memcpy(out + 19, digits + 16, 4);
+    std::memcpy(out + 24, digits + 20, 12);
+    for (size_t position: dashPositions) {
+        out[position] = '-';
+    }
+}
+
+std::string Uuid::toString() const {
+    std::string text(stringLength, '\0');
+    format(text.data());
+    return text;
+}
+
+bool Uuid::isNil() const {
+    return *this == Uuid();
+}
+
+size_t Uuid::hash() const {
+    uint64_t halves[2];
+    std::memcpy(halves, bytes.data(), sizeof(halves));
+    return (size_t) (halves[0] ^ (halves[1] * 0x9e3779b97f4a7c15));
+}
+
+std::ostream &operator<<(std::ostream &out, const Uuid &obj) {
+    char text[Uuid::stringLength];
+    obj.format(text);
+    return out.write(text, Uuid::stringLength);
+}
@@ -0,0 +1,141 @@
+#include <stdexcept>
+#include "VehicleCache.hpp"
+#include "EntityReader.hpp"
+
+VehicleCache vehicleCache;
+
+VehicleCache::~VehicleCache() {
+    resident.forEach([](const Uuid &, const Slot &slot) {
+        delete slot.vehicle;
+    });
+}
+
+void VehicleCache::add(Vehicle *vehicle) {
+    Uuid uuid = vehicle->getUUID();
+    Slot *slot = resident.find(uuid);
+    if (slot != nullptr) {
+        // Replacing a vehicle with itself would delete it
+        if (slot->vehicle != vehicle) {
+            delete slot->vehicle;
+            slot->vehicle = vehicle;
+        }
+        recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, slot->position);
+        return;
+    }
+
+    recentlyUsed.push_front(uuid);
+    resident.insert(uuid, Slot{vehicle, recentlyUsed.begin()});
+    evict();
+}
+
+void VehicleCache::reserve(size_t count) {
+    resident.reserve(count);
+}
+
+bool VehicleCache::contains(const Uuid &uuid) const {
+    return resident.contains(uuid) || index.contains(uuid);
+}
+
+Vehicle *VehicleCache::get(const Uuid &uuid) {
+    // Already in memory, just mark it as the most recently used
+    Slot *slot = resident.find(uuid);
+    if (slot != nullptr) {
+        recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, slot->position);
+        return slot->vehicle;
+    }
+
+    // Otherwise load it from the snapshot if it's in there
+    const SnapshotEntry *const *indexEntry = index.find(uuid);
+    if (indexEntry == nullptr) {
+        return nullptr;
+    }
+
+    const SnapshotEntry &entry = **indexEntry;
+    Vehicle *vehicle = EntityReader::readVehicle(store->readBytes(entry, readBuffer), entry.format);
+    vehicle->markClean();
+    loadCount++;
+    add(vehicle);
+    return vehicle;
+}
+
+PinnedVehicle VehicleCache::pin(const Uuid &uuid) {
+    Vehicle *vehicle = get(uuid);
+    if (vehicle == nullptr) {
+        return {};
+    }
+
+    resident.find(uuid)->pinCount++;
+    return {this, vehicle};
+}
+
+void VehicleCache::unpin(const Uuid &uuid) {
+    Slot *slot = resident.find(uuid);
+    if (slot != nullptr && slot->pinCount > 0 && --slot->pinCount == 0) {
+        evict();
+    }
+}
+
+std::vector<Vehicle *> VehicleCache::getResident() const {
+    std::vector<Vehicle *> vehicles;
+    vehicles.reserve(resident.size());
+    resident.forEach([&vehicles](const Uuid &, const Slot &slot) {
+        vehicles.push_back(slot.vehicle);
+    });
+
+    return vehicles;
+}
+
+size_t VehicleCache::getResidentCount() const {
+    return resident.size();
+}
+
+size_t VehicleCache::getLoadCount() const {
+    return loadCount;
+}
+
+size_t VehicleCache::getEvictionCount() const {
+    return evictionCount;
+}
+
+void VehicleCache::openSnapshot(const std::string &path, size_t capacity) {
+    // Build the new index before dropping the old one, in case this throws
+    auto newStore = std::make_unique<SnapshotStore>(path, true);
+    FlatUuidMap<const SnapshotEntry *> newIndex;
+    newIndex.reserve(newStore->getEntries().size());
+    for (const SnapshotEntry &entry: newStore->getEntries()) {
+        if (entry.kind == EntityKind::Vehicle) {
+            newIndex.insert(entry.uuid, &entry);
+        }
+    }
+
+    store = std::move(newStore);
+    index = std::move(newIndex);
+    this->capacity = capacity;
+    evict();
+}
+
+void VehicleCache::evict() {
+    // Walk from the least recently used end, skipping anything with unsaved changes or pins and the vehicle just used
+    auto it = recentlyUsed.end();
+    while (resident.size() > capacity && it != recentlyUsed.begin()) {
+        --it;
+        if (it == recentlyUsed.begin()) {
+            break;
+        }
+
+        Slot *slot = resident.find(*it);
+        if (slot->pinCount > 0) {
+            // Still being used
+            continue;
+        }
+        if (slot->vehicle->isDirty() || !index.contains(*it)) {
+            // Can't be loaded back in unless it's in the snapshot as it is now
+            continue;
+        }
+
+        delete slot->vehicle;
+        resident.erase(*it);
+        it = recentlyUsed.erase(it);
+        evictionCount++;
+    }
+}
@@ -1,4 +1,6 @@
 #include "VehicleDealership.hpp"
+#include "VehicleCache.hpp"
+#include "StorageFormat.hpp"
 // #include "include/uuid_v4/uuid_v4.h.old"
 #include <util.hpp>
 #include <filesystem>
@@ -9,13 +11,15 @@ namespace fs = std::filesystem;
 VehicleDealership::VehicleDealership(std::string name, BankAccount *account) {
     this->name = name;
     this->bankAccount = account;
+    this->dirty = true;
 
-    this->uuid = generate_uuid_v4();
+    this->uuid = Uuid::generate();
 }
 
-VehicleDealership::VehicleDealership(std::string name, BankAccount *account, std::string uuid) {
+VehicleDealership::VehicleDealership(std::string name, BankAccount *account, Uuid uuid) {
     this->name = name;
     this->bankAccount = account;
+    this->dirty = true;
 
     this->uuid = uuid;
 }
@@ -24,21 +28,39 @@ std::string VehicleDealership::getName() const {
     return name;
 }
 
-Vehicle *VehicleDealership::buyVehicleFrom(int idx, BankAccount *buyerBankAccount) {
+Uuid VehicleDealership::getUUID() const {
+    return uuid;
+}
+
+bool VehicleDealership::isDirty() const {
+    return dirty || bankAccount->isDirty();
+}
+
+void VehicleDealership::markDirty() {
+    dirty = true;
+}
+
+void VehicleDealership::markClean() {
+    dirty = false;
+    bankAccount->markClean();
+}
+
+PinnedVehicle VehicleDealership::buyVehicleFrom(int idx, BankAccount *buyerBankAccount) {
     if (idx > vehicles.size() - 1) {
         // Can't sell a vehicle that we don't have
-        return nullptr;
+        return {};
     }
 
-    Vehicle *desiredVehicle = vehicles[idx];
+    PinnedVehicle desiredVehicle = vehicles[idx].pin();
     // Try making the transaction
     if (!BankAccount::makeTransaction(buyerBankAccount, bankAccount, desiredVehicle->getPrice())) {
         // Transaction didn't go through (not enough money / withdraw limit)
-        return nullptr;
+        return {};
     }
 
     // We no longer own this vehicle
     vehicles.erase(vehicles.begin() + idx);
+    dirty = true;
     return desiredVehicle;
 }
 
@@ -61,6 +83,7 @@ int VehicleDealership::sellVehicleTo(Vehicle *vehicle, BankAccount *sellerBankAc
     }
 
     vehicles.push_back(vehicle);
+    dirty = true;
     return (int) vehicles.size() - 1;
 }
 
@@ -71,6 +94,7 @@ int VehicleDealership::giveVehicle(Vehicle *vehicle) {
     }
 
     vehicles.push_back(vehicle);
+    dirty = true;
     return (int) vehicles.size() - 1;
 }
 
@@ -78,18 +102,35 @@ json VehicleDealership::serializeToJSON() {
     json serialized = {};
 
     // Store all important info into JSON object
-    serialized["uuid"] = uuid;
+    serialized["uuid"] = uuid.toString();
     serialized["name"] = name;
     serialized["bankAccount"] = bankAccount->serializeToJSON();
     serialized["vehicles"] = json::array();
-    for (Vehicle *vehicle: vehicles) {
-        serialized["vehicles"].push_back(vehicle->getUUID());
+    for (const VehicleRef &vehicle: vehicles) {
+        serialized["vehicles"].push_back(vehicle.getUUID().toString());
     }
 
     return serialized;
 }
 
-VehicleDealership VehicleDealership::deserializeFromJSON(const json &data, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers) {
+void VehicleDealership::writeJSON(JsonWriter &writer) const {
+    writer.beginObject();
+    writer.field("uuid", uuid);
+    writer.field("name", name);
+
+    // The bank account goes straight into the same buffer
+    writer.key("bankAccount");
+    bankAccount->writeJSON(writer);
+
+    writer.key("vehicles").beginArray();
+    for (const VehicleRef &vehicle: vehicles) {
+        writer.value(vehicle.getUUID());
+    }
+    writer.endArray();
+    writer.endObject();
+}
+
+VehicleDealership VehicleDealership::deserializeFromJSON(const json &data, const VehicleCache &vehicleCache) {
     // Ensure that all keys are there
     std::vector<std::string> requiredKeys = {"uuid", "name",
                                              "bankAccount", "vehicles"};
@@ -103,14 +144,15 @@ VehicleDealership VehicleDealership::deserializeFromJSON(const json &data, std::
     auto *tmpAccount = new BankAccount(BankAccount::deserializeFromJSON(data["bankAccount"]));
 
     VehicleDealership tmpVehicleDealership{data["name"].get<std::string>(), tmpAccount,
-                                           data["uuid"].get<std::string>()};
+                                           Uuid::parse(data["uuid"].get<std::string>())};
 
-    for (const std::string& uuid: data["vehicles"].get<json>()) {
-        if (!vehicleUUIDsToPointers.contains(uuid)) {
+    for (const json &uuidData: data["vehicles"]) {
+        Uuid uuid = Uuid::parse(uuidData.get<std::string>());
+        if (!vehicleCache.contains(uuid)) {
             std::cout << "WARN: Vehicle of UUID " << uuid << " does not exist! Skipping.\n";
             continue;
         }
-        tmpVehicleDealership.vehicles.push_back(vehicleUUIDsToPointers.at(uuid));
+        tmpVehicleDealership.vehicles.emplace_back(uuid);
     }
 
     // Initialize VehicleDealership using all the info
@@ -118,7 +160,9 @@ VehicleDealership VehicleDealership::deserializeFromJSON(const json &data, std::
 }
 
 void VehicleDealership::saveAsFile() {
-    json serializedJSON = serializeToJSON();
+    // JSON files are indented so they can still be read by people
+    std::string encoded;
+    encodeEntity(*this, storageFormat, encoded, true);
 
     // Make data directory if needed
     if (!fs::is_directory("data") || !fs::exists("data")) { // Check if folder exists
@@ -130,27 +174,23 @@ void VehicleDealership::saveAsFile() {
         fs::create_directory("data/vehicle-dealership");
     }
 
-    // Write data to file
-    std::ofstream file("data/vehicle-dealership/" + uuid + ".json");
-    file << std::setw(4) << serializedJSON << std::endl;
-    file.close();
+    // Write data to file in the storage format
+    writeEntityBytes("data/vehicle-dealership", uuid, encoded);
 }
 
-VehicleDealership VehicleDealership::loadFromPath(const std::string &path, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers) {
+VehicleDealership VehicleDealership::loadFromPath(const std::string &path, const VehicleCache &vehicleCache) {
     if (!fs::exists(path)) {
         // File needs to exist to read anything
         throw std::runtime_error(path + " does not exist");
     }
 
-    std::ifstream file(path);
-    json importedJSON;
-    file >> importedJSON;
+    json importedJSON = readEntityFile(path);
 
-    return VehicleDealership::deserializeFromJSON(importedJSON, vehicleUUIDsToPointers);
+    return VehicleDealership::deserializeFromJSON(importedJSON, vehicleCache);
 }
 
-VehicleDealership VehicleDealership::loadFromUUID(const std::string &uuid, std::map<std::string, Vehicle*>& vehicleUUIDsToPointers) {
-    return VehicleDealership::loadFromPath("data/dealership/" + uuid + ".json", vehicleUUIDsToPointers);
+VehicleDealership VehicleDealership::loadFromUUID(const Uuid &uuid, const VehicleCache &vehicleCache) {
+    return VehicleDealership::loadFromPath(findEntityFile("data/vehicle-dealership", uuid), vehicleCache);
 }
 
 std::ostream &operator<<(std::ostream &out, const VehicleDealership &obj) {
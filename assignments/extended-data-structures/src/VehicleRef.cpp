@@ -0,0 +1,45 @@
+#include <stdexcept>
+#include "VehicleRef.hpp"
+#include "VehicleCache.hpp"
+
+VehicleRef::VehicleRef(Vehicle *vehicle) {
+    this->uuid = vehicle->getUUID();
+}
+
+VehicleRef::VehicleRef(const Uuid &uuid) {
+    this->uuid = uuid;
+}
+
+const Uuid &VehicleRef::getUUID() const {
+    return uuid;
+}
+
+Vehicle *VehicleRef::get() const {
+    Vehicle *vehicle = vehicleCache.get(uuid);
+    if (vehicle == nullptr) {
+        throw std::runtime_error("Vehicle of UUID " + uuid.toString() + " does not exist");
+    }
+
+    return vehicle;
+}
+
+PinnedVehicle VehicleRef::pin() const {
+    PinnedVehicle vehicle = vehicleCache.pin(uuid);
+    if (!vehicle) {
+        throw std::runtime_error("Vehicle of UUID " + uuid.toString() + " does not exist");
+    }
+
+    return vehicle;
+}
+
+Vehicle *VehicleRef::operator->() const {
+    return get();
+}
+
+Vehicle &VehicleRef::operator*() const {
+    return *get();
+}
+
+bool VehicleRef::operator==(const VehicleRef &other) const {
+    return uuid == other.uuid;
+}
@@ -0,0 +1,255 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include "WriteAheadLog.hpp"
+
+/**
+ * Append a UUID to a buffer as text, prefixed by its length. The nil UUID is stored with no text at all.
+ * @param buffer buffer to append to
+ * @param uuid the UUID
+ */
+static void appendUUID(std::string &buffer, const Uuid &uuid) {
+    if (uuid.isNil()) {
+        appendRaw(buffer, (uint8_t) 0);
+        return;
+    }
+
+    appendRaw(buffer, (uint8_t) Uuid::stringLength);
+    buffer.resize(buffer.size() + Uuid::stringLength);
+    uuid.format(buffer.data() + buffer.size() - Uuid::stringLength);
+}
+
+/**
+ * Read a UUID prefixed by its length out of a buffer and move past it
+ * @param data buffer to read from
+ * @param pos position to read at, moved past the UUID
+ * @param end position the UUID must fit before
+ * @return the UUID, nil if there's no text
+ * @throws runtime_error if the UUID doesn't fit or isn't valid
+ */
+static Uuid readUUID(const char *data, uint64_t &pos, uint64_t end) {
+    auto size = readRaw<uint8_t>(data, pos, end);
+    if (pos + size > end) {
+        throw std::runtime_error("Ran out of bytes to read");
+    }
+
+    Uuid uuid;
+    if (size > 0) {
+        uuid = Uuid::parse(std::string_view(data + pos, size));
+    }
+    pos += size;
+    return uuid;
+}
+
+/**
+ * Serialize a record: its size, checksum, then the sequence number, type, kind, amount, UUIDs and payload
+ * @param record the record to serialize
+ * @return the serialized record
+ */
+static std::string encodeRecord(const LogRecord &record) {
+    std::string body;
+    appendRaw(body, record.sequence);
+    appendRaw(body, record.type);
+    appendRaw(body, record.kind);
+    appendRaw(body, record.amount);
+    appendUUID(body, record.uuid);
+    appendUUID(body, record.from);
+    appendUUID(body, record.to);
+    appendRaw(body, (uint32_t) record.payload.size());
+    body += record.payload;
+
+    std::string encoded;
+    appendRaw(encoded, (uint32_t) body.size());
+    appendRaw(encoded, fnv1a64(body.data(), body.size()));
+    encoded += body;
+    return encoded;
+}
+
+/**
+ * Write a whole buffer to a file descriptor, retrying short writes
+ * @param fd the file descriptor
+ * @param data the buffer to write
+ * @return if everything was written
+ */
+static bool writeAll(int fd, const std::string &data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t result = ::write(fd, data.data() + written, data.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += result;
+    }
+
+    return true;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string &path, uint64_t snapshotSequence) : path(path) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open " + path + ": " + std::strerror(errno));
+    }
+
+    // Read in everything that's there
+    std::string data;
+    char chunk[1 << 16];
+    ssize_t result;
+    while ((result = ::read(fd, chunk, sizeof(chunk))) > 0) {
+        data.append(chunk, result);
+    }
+
+    // Keep every complete record, stopping at the first one that was cut off or mangled by a crash
+    lastSequence = snapshotSequence;
+    uint64_t pos = 0;
+    while (pos < data.size()) {
+        try {
+            uint64_t recordPos = pos;
+            auto size = readRaw<uint32_t>(data.data(), recordPos, data.size());
+            auto checksum = readRaw<uint64_t>(data.data(), recordPos, data.size());
+            uint64_t end = recordPos + size;
+            if (end > data.size() || fnv1a64(data.data() + recordPos, size) != checksum) {
+                break;
+            }
+
+            LogRecord record;
+            record.sequence = readRaw<uint64_t>(data.data(), recordPos, end);
+            record.type = readRaw<LogRecordType>(data.data(), recordPos, end);
+            record.kind = readRaw<EntityKind>(data.data(), recordPos, end);
+            record.amount = readRaw<double>(data.data(), recordPos, end);
+            record.uuid = readUUID(data.data(), recordPos, end);
+            record.from = readUUID(data.data(), recordPos, end);
+            record.to = readUUID(data.data(), recordPos, end);
+            auto payloadSize = readRaw<uint32_t>(data.data(), recordPos, end);
+            if (recordPos + payloadSize != end) {
+                break;
+            }
+            record.payload.assign(data.data() + recordPos, payloadSize);
+            pos = end;
+
+            // Records up to the snapshot's sequence number were saved but not truncated before a crash
+            if (record.sequence > snapshotSequence) {
+                lastSequence = record.sequence;
+                records.push_back(std::move(record));
+            }
+        } catch (const std::runtime_error &) {
+            break;
+        }
+    }
+
+    // Cut off the damaged tail so new records follow the last good one
+    if (pos < data.size() && ::ftruncate(fd, (off_t) pos) != 0) {
+        throw std::runtime_error("Could not truncate " + path + ": " + std::strerror(errno));
+    }
+
+    durableSequence = lastSequence;
+    durableSize = pos;
+    flusher = std::thread(&WriteAheadLog::flushLoop, this);
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    pendingCondition.notify_one();
+    flusher.join();
+    ::close(fd);
+}
+
+uint64_t WriteAheadLog::append(LogRecord record) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+
+    record.sequence = ++lastSequence;
+    pending += encodeRecord(record);
+    pendingCondition.notify_one();
+    return record.sequence;
+}
+
+void WriteAheadLog::commit(uint64_t sequence) {
+    std::unique_lock<std::mutex> lock(mutex);
+    durableCondition.wait(lock, [this, sequence] { return durableSequence >= sequence || !error.empty(); });
+    // Once writing has failed nothing after durableSequence is ever made durable, so this can't pass by accident
+    if (durableSequence < sequence) {
+        throw std::runtime_error(error);
+    }
+}
+
+uint64_t WriteAheadLog::write(LogRecord record) {
+    uint64_t sequence = append(std::move(record));
+    commit(sequence);
+    return sequence;
+}
+
+const std::vector<LogRecord> &WriteAheadLog::getRecords() const {
+    return records;
+}
+
+uint64_t WriteAheadLog::getLastSequence() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastSequence;
+}
+
+uint64_t WriteAheadLog::getSyncCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return syncCount;
+}
+
+void WriteAheadLog::truncate() {
+    // Wait for the flusher to write out everything, so nothing new can land in the file while it's being emptied
+    std::unique_lock<std::mutex> lock(mutex);
+    durableCondition.wait(lock, [this] { return durableSequence == lastSequence || !error.empty(); });
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+
+    if (::ftruncate(fd, 0) != 0 || ::fsync(fd) != 0) {
+        throw std::runtime_error("Could not truncate " + path + ": " + std::strerror(errno));
+    }
+    durableSize = 0;
+    records.clear();
+}
+
+void WriteAheadLog::flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        pendingCondition.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty() || !error.empty()) {
+            // Either stopping with nothing left to write, or writing already failed and nothing more will be written
+            return;
+        }
+
+        // Take everything appended so far as one batch, more can be appended while it's being written
+        std::string batch;
+        batch.swap(pending);
+        uint64_t batchSequence = lastSequence;
+        lock.unlock();
+
+        bool ok = writeAll(fd, batch) && ::fsync(fd) == 0;
+        std::string reason = ok ? "" : std::strerror(errno);
+
+        lock.lock();
+        if (ok) {
+            durableSequence = batchSequence;
+            durableSize += batch.size();
+            syncCount++;
+        } else {
+            // Stop for good, leaving durableSequence at the last batch that made it. Cut off whatever part of this
+            // batch was written, so the records before it are still read back on the next start instead of being
+            // dropped along with a torn record.
+            error = "Could not write " + path + ": " + reason;
+            pending.clear();
+            if (::ftruncate(fd, (off_t) durableSize) == 0) {
+                ::fsync(fd);
+            }
+        }
+        durableCondition.notify_all();
+    }
+}
@@ -25,9 +25,20 @@
 #include <cctype>
 #include <string>
 #include <fstream>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <sstream>
 #include "BankAccount.hpp"
+#include "EntityReader.hpp"
+#include "EntityRegistry.hpp"
 #include "Person.hpp"
+#include "SnapshotStore.hpp"
+#include "StorageFormat.hpp"
+#include "VehicleCache.hpp"
 #include "VehicleDealership.hpp"
+#include "WriteAheadLog.hpp"
 #include "util.hpp"
 #include "colorize.h"
 #include "vehicles/Vehicle.hpp"
@@ -39,17 +50,28 @@ namespace fs = std::filesystem;
 using namespace std::chrono;
 
 Person *playerData;
-std::vector<Person *> people;
-std::vector<VehicleDealership *> dealerships;
-std::map<std::string, Vehicle*> vehicleUUIDsToPointers;
+EntityRegistry entityRegistry;
+// Every person and dealership in the order they're listed in, which only change through entityRegistry
+const std::vector<Person *> &people = entityRegistry.getPeople();
+const std::vector<VehicleDealership *> &dealerships = entityRegistry.getDealerships();
+std::vector<Uuid> deletedUUIDs;
+WriteAheadLog *writeAheadLog;
+
+const std::string dataPath = "data";
+const std::string snapshotPath = "data/snapshot.bin";
+const std::string logPath = "data/wal.log";
+
+// Whether vehicles are loaded on first use instead of up front, and how many to keep in memory when they are
+bool lazyLoading = false;
+const size_t lazyVehicleCapacity = 1024;
 
 /**
  * Print a list of values of pointers in order with nice formatting
- * @tparam T the type used in the vector
+ * @tparam T the type used in the vector (a pointer or a VehicleRef)
  * @param vec vector to get pointers from
  */
 template<class T>
-void printPointerValuesWithIdx(std::vector<T *> &vec) {
+void printPointerValuesWithIdx(const std::vector<T> &vec) {
     for (int i = 0; i < vec.size(); i++) {
         std::cout << i + 1 << ". " << *vec[i] << "\n";
     }
@@ -199,10 +221,14 @@ Vehicle *generateVehicleFromUserInputAndAttach() {
     auto idx = promptWithValidation<int>("Enter the index of the dealership to add the vehicle to: ",
                                          [](int x) { return x > 0 && x <= dealerships.size(); }) - 1;
     dealerships[idx]->giveVehicle(vehicle);
-    std::cout << "Successfully generated vehicle for " << dealerships[idx]->getName() << "!\n";
 
-    // Add it to the UUID to vehicle mapping
-    vehicleUUIDsToPointers[vehicle->getUUID()] = vehicle;
+    // Hand it over to the vehicle cache
+    vehicleCache.add(vehicle);
+    std::string payload;
+    encodeEntity(*vehicle, StorageFormat::JSON, payload);
+    writeAheadLog->write({LogRecordType::Create, EntityKind::Vehicle, vehicle->getUUID(), {},
+                          dealerships[idx]->getUUID(), 0, payload});
+    std::cout << "Successfully generated vehicle for " << dealerships[idx]->getName() << "!\n";
 
     return vehicle;
 }
@@ -232,13 +258,260 @@ void createDataDirs() {
     }
 }
 
+/**
+ * Get the number of milliseconds since a point in time, and move that point to now
+ * @param start the point in time, reset to now
+ * @return the number of milliseconds
+ */
+double lapMilliseconds(steady_clock::time_point &start) {
+    auto now = steady_clock::now();
+    double ms = duration<double, std::milli>(now - start).count();
+    start = now;
+    return ms;
+}
+
+/**
+ * The encoded bytes of an entity, and the format they're in
+ */
+struct EncodedEntity {
+    std::string_view bytes;
+    StorageFormat format;
+};
+
+/**
+ * Construct every vehicle, person and dealership across all hardware threads, in the stages they depend on each other
+ * in: every vehicle first, then the UUID index, then the people and dealerships that refer to the vehicles. When
+ * loading lazily, no vehicles are constructed and the index is read from the snapshot instead.
+ * @param counts the number of entities of each kind, indexed by EntityKind
+ * @param readEntity function that gives the encoded bytes of the i-th entity of a kind, called from many threads. The
+ * bytes only need to stay valid until the next call from the same thread.
+ * @param clean whether the entities match what's saved, otherwise they're left dirty to be saved
+ * @param enumerateMs how long finding the entities took, for the timings
+ */
+void constructEntities(const std::array<size_t, 3> &counts, const std::function<EncodedEntity(EntityKind, size_t)> &readEntity,
+                       bool clean, double enumerateMs) {
+    auto start = steady_clock::now();
+    size_t vehicleCount = counts[(size_t) EntityKind::Vehicle];
+    size_t personCount = counts[(size_t) EntityKind::Person];
+    size_t dealershipCount = counts[(size_t) EntityKind::Dealership];
+
+    // Stream every vehicle straight into its object, each into its own slot
+    std::vector<Vehicle *> vehicles(vehicleCount);
+    parallelFor(vehicleCount, [&](size_t i) {
+        EncodedEntity entity = readEntity(EntityKind::Vehicle, i);
+        vehicles[i] = EntityReader::readVehicle(entity.bytes, entity.format);
+        if (clean) {
+            vehicles[i]->markClean();
+        }
+    });
+    double vehiclesMs = lapMilliseconds(start);
+
+    // Build the UUID index once, it's only read from after this
+    if (lazyLoading) {
+        vehicleCache.openSnapshot(snapshotPath, lazyVehicleCapacity);
+    }
+    vehicleCache.reserve(vehicles.size());
+    for (Vehicle *vehicle: vehicles) {
+        vehicleCache.add(vehicle);
+    }
+    double indexMs = lapMilliseconds(start);
+
+    // Parse people and dealerships and resolve the vehicles they own
+    std::vector<Person *> loadedPeople(personCount);
+    std::vector<VehicleDealership *> loadedDealerships(dealershipCount);
+    parallelFor(personCount + dealershipCount, [&](size_t i) {
+        if (i < personCount) {
+            EncodedEntity entity = readEntity(EntityKind::Person, i);
+            loadedPeople[i] = EntityReader::readPerson(entity.bytes, entity.format, vehicleCache);
+            if (clean) {
+                loadedPeople[i]->markClean();
+            }
+        } else {
+            size_t idx = i - personCount;
+            EncodedEntity entity = readEntity(EntityKind::Dealership, idx);
+            loadedDealerships[idx] = EntityReader::readDealership(entity.bytes, entity.format, vehicleCache);
+            if (clean) {
+                loadedDealerships[idx]->markClean();
+            }
+        }
+    });
+    entityRegistry.addAll(loadedPeople);
+    entityRegistry.addAll(loadedDealerships);
+    double ownersMs = lapMilliseconds(start);
+
+    // Built separately so the formatting doesn't stick to cout, which would change how heights and balances print
+    std::ostringstream timings;
+    timings << "Loaded " << vehicleCache.getResidentCount() << " vehicles, " << personCount << " people and "
+            << dealershipCount << " dealerships in " << std::fixed << std::setprecision(1)
+            << enumerateMs + vehiclesMs + indexMs + ownersMs << "ms (enumerate " << enumerateMs << "ms, vehicles "
+            << vehiclesMs << "ms, index " << indexMs << "ms, people & dealerships " << ownersMs << "ms)\n";
+    std::cout << timings.str();
+}
+
+/**
+ * Load all vehicles, people and dealerships from the snapshot, in one read of the snapshot file. When loading
+ * lazily, only the people, dealerships and the index are read, and vehicles are left in the file until they're used.
+ * @return sequence number of the last write-ahead log record included in the snapshot
+ */
+uint64_t loadFromSnapshot() {
+    auto start = steady_clock::now();
+    SnapshotStore store(snapshotPath, lazyLoading);
+
+    // Split up the index by kind, so each stage can be indexed directly
+    std::array<std::vector<const SnapshotEntry *>, 3> entries;
+    for (const SnapshotEntry &entry: store.getEntries()) {
+        entries[(size_t) entry.kind].push_back(&entry);
+    }
+    double enumerateMs = lapMilliseconds(start);
+
+    size_t vehicleCount = lazyLoading ? 0 : entries[0].size();
+    constructEntities({vehicleCount, entries[1].size(), entries[2].size()},
+                      [&](EntityKind kind, size_t i) {
+                          // Lazy snapshots are read from the file into a buffer, otherwise this is a view of memory
+                          thread_local std::string buffer;
+                          const SnapshotEntry &entry = *entries[(size_t) kind][i];
+                          return EncodedEntity{store.readBytes(entry, buffer), entry.format};
+                      },
+                      true, enumerateMs);
+    return store.getLogSequence();
+}
+
+/**
+ * Load all vehicles, people and dealerships from their own JSON files in the data folder. Only used when there is
+ * no snapshot yet, everything is left dirty so that the next save writes one. Vehicles are always loaded up front,
+ * since there is no index to load them lazily from.
+ */
+void loadFromFolders() {
+    auto start = steady_clock::now();
+
+    // List every file up front, so they can be handed out to threads. Anything that isn't an entity file is skipped.
+    std::array<std::vector<fs::path>, 3> paths;
+    for (EntityKind kind: {EntityKind::Vehicle, EntityKind::Person, EntityKind::Dealership}) {
+        for (const auto &entry: fs::directory_iterator(fs::path(dataPath) / getEntityFolder(kind))) {
+            StorageFormat format;
+            if (!tryGetFormatFromPath(entry.path().string(), format)) {
+                std::cout << "WARN: " << entry.path().string() << " is not in a known storage format! Skipping.\n";
+                continue;
+            }
+            paths[(size_t) kind].push_back(entry.path());
+        }
+    }
+    double enumerateMs = lapMilliseconds(start);
+
+    constructEntities({paths[0].size(), paths[1].size(), paths[2].size()}, [&](EntityKind kind, size_t i) {
+        thread_local std::string bytes;
+        const fs::path &path = paths[(size_t) kind][i];
+        bytes = readEntityBytes(path.string());
+        return EncodedEntity{bytes, getFormatFromPath(path.string())};
+    }, false, enumerateMs);
+}
+
+/**
+ * Redo an operation from the write-ahead log on top of what was loaded from the snapshot. Everything it touches is
+ * left dirty, so the next save includes it.
+ * @param record the operation to redo
+ * @return if the operation could be redone
+ */
+bool applyLogRecord(const LogRecord &record) {
+    switch (record.type) {
+        case LogRecordType::Create: {
+            // The log always stores JSON
+            if (record.kind == EntityKind::Vehicle) {
+                VehicleDealership *dealership = entityRegistry.findDealership(record.to);
+                if (dealership == nullptr) {
+                    return false;
+                }
+
+                Vehicle *vehicle = EntityReader::readVehicle(record.payload, StorageFormat::JSON);
+                vehicleCache.add(vehicle);
+                dealership->giveVehicle(vehicle);
+            } else if (record.kind == EntityKind::Person) {
+                entityRegistry.add(EntityReader::readPerson(record.payload, StorageFormat::JSON, vehicleCache));
+            } else {
+                entityRegistry.add(EntityReader::readDealership(record.payload, StorageFormat::JSON, vehicleCache));
+            }
+            return true;
+        }
+        case LogRecordType::Delete: {
+            if (record.kind == EntityKind::Person) {
+                entityRegistry.remove(entityRegistry.findPerson(record.uuid));
+            } else if (record.kind == EntityKind::Dealership) {
+                entityRegistry.remove(entityRegistry.findDealership(record.uuid));
+            }
+            deletedUUIDs.push_back(record.uuid);
+            return true;
+        }
+        case LogRecordType::TransferVehicle: {
+            // Pinned, since looking up the owners' vehicles below can load others
+            PinnedVehicle vehicle = vehicleCache.pin(record.uuid);
+            if (!vehicle) {
+                return false;
+            }
+
+            // Redo it the same way it was done the first time. That charges the vehicle's price again, so it has to
+            // match what was paid the first time, or the balances would end up different from before the crash.
+            if (vehicle->getPrice() != record.amount) {
+                return false;
+            }
+
+            VehicleDealership *seller = entityRegistry.findDealership(record.from);
+            Person *buyer = entityRegistry.findPerson(record.to);
+            if (seller != nullptr && buyer != nullptr) {
+                auto it = std::find(seller->vehicles.begin(), seller->vehicles.end(), vehicle.get());
+                if (it == seller->vehicles.end() ||
+                    !seller->buyVehicleFrom((int) (it - seller->vehicles.begin()), buyer->bankAccount)) {
+                    return false;
+                }
+
+                buyer->vehicles.push_back(vehicle.get());
+                buyer->markDirty();
+                return true;
+            }
+
+            Person *personSeller = entityRegistry.findPerson(record.from);
+            VehicleDealership *dealershipBuyer = entityRegistry.findDealership(record.to);
+            if (personSeller != nullptr && dealershipBuyer != nullptr) {
+                if (dealershipBuyer->sellVehicleTo(vehicle.get(), personSeller->bankAccount) == -1) {
+                    return false;
+                }
+
+                std::erase(personSeller->vehicles, vehicle.get());
+                personSeller->markDirty();
+                return true;
+            }
+
+            return false;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Open the write-ahead log and redo every operation in it that isn't in the snapshot yet.
+ * @param snapshotSequence sequence number of the last record included in the snapshot
+ */
+void replayWriteAheadLog(uint64_t snapshotSequence) {
+    writeAheadLog = new WriteAheadLog(logPath, snapshotSequence);
+
+    for (const LogRecord &record: writeAheadLog->getRecords()) {
+        if (!applyLogRecord(record)) {
+            std::cout << "WARN: Could not redo operation #" << record.sequence << " from the log! Skipping.\n";
+        }
+    }
+
+    if (!writeAheadLog->getRecords().empty()) {
+        std::cout << "Redid " << writeAheadLog->getRecords().size() << " operations from " << logPath << "\n";
+    }
+}
+
 /**
  * Using user input, switch the current pointer held in playerData, given the choice of all players.
  */
 void switchCurrentPlayerAccount() {
     // Print out header for this section
     std::cout << color::rize("List of preloaded people:\n", "Green");
-    printPointerValuesWithIdx<Person>(people);
+    printPointerValuesWithIdx(people);
     if (people.empty()) {
         std::cout
                 << "  No people profiles could be loaded in :( If you didn't expect this, check the path of your data files (should be data/people)\n";
@@ -249,8 +522,11 @@ void switchCurrentPlayerAccount() {
             [](const std::string &str) { return (str == "i" && !people.empty()) || str == "c"; });
     if (ans == "c") {
         // Create a new person and assign them as the current player
-        people.push_back(generatePersonFromInput());
+        entityRegistry.add(generatePersonFromInput());
         playerData = people[people.size() - 1];
+        std::string payload;
+        encodeEntity(*playerData, StorageFormat::JSON, payload);
+        writeAheadLog->write({LogRecordType::Create, EntityKind::Person, playerData->getUUID(), {}, {}, 0, payload});
     } else if (ans == "i") {
         // Choose an account from the ones given
         int idx = promptWithValidation<int>("Enter the index of the account to import: ",
@@ -262,29 +538,126 @@ void switchCurrentPlayerAccount() {
 }
 
 /**
- * Serialized and save all the Person and VehicleDealership data in data/
+ * Save the Vehicle, Person and VehicleDealership data that changed since the last save into the snapshot in data/,
+ * and remove anything that was deleted.
  */
 void saveAllData() {
-    // Save all data for people
+    // Only the changes need to be written if there's already a snapshot, otherwise everything is dirty anyways
+    SnapshotWriter writer = fs::exists(snapshotPath) ? SnapshotWriter(snapshotPath) : SnapshotWriter();
+    size_t savedCount = 0;
+
+    // Every entity is encoded into the same buffer, it's copied into the snapshot right away
+    std::string encoded;
+
+    // Save all changed vehicles, any that aren't in memory haven't changed
+    std::vector<Vehicle *> residentVehicles = vehicleCache.getResident();
+    for (auto vehicle: residentVehicles) {
+        if (vehicle->isDirty()) {
+            writer.add(EntityKind::Vehicle, vehicle->getUUID(), encodeEntity(*vehicle, storageFormat, encoded),
+                       storageFormat);
+            savedCount++;
+        }
+    }
+
+    // Save all changed people
     for (auto person: people) {
-        person->saveAsFile();
+        if (person->isDirty()) {
+            writer.add(EntityKind::Person, person->getUUID(), encodeEntity(*person, storageFormat, encoded),
+                       storageFormat);
+            savedCount++;
+        }
     }
 
-    // Save all data for dealerships
+    // Save all changed dealerships
     for (auto dealership: dealerships) {
-        dealership->saveAsFile();
+        if (dealership->isDirty()) {
+            writer.add(EntityKind::Dealership, dealership->getUUID(),
+                       encodeEntity(*dealership, storageFormat, encoded), storageFormat);
+            savedCount++;
+        }
+    }
+
+    // Drop anything that was deleted
+    for (const Uuid &uuid: deletedUUIDs) {
+        writer.remove(uuid);
     }
 
-    // Save all data for vehicles
-    for (auto const& uuidVehiclePair : vehicleUUIDsToPointers) {
-        std::cout << "UUID saved: " << uuidVehiclePair.first << "\n";
-        uuidVehiclePair.second->saveAsFile();
+    // Nothing to write if nothing changed
+    if (savedCount == 0 && deletedUUIDs.empty() && fs::exists(snapshotPath)) {
+        std::cout << "Nothing changed since the last save.\n";
+        return;
     }
 
-    std::cout << "Saved all data!\n";
+    // The snapshot now has everything in the log. write() only returns once it's synced to disk, so the log can be
+    // emptied right after without losing anything to a crash
+    writer.setLogSequence(writeAheadLog->getLastSequence());
+    writer.write(snapshotPath);
+    writeAheadLog->truncate();
+
+    // Everything in memory matches the snapshot now
+    for (auto vehicle: residentVehicles) {
+        vehicle->markClean();
+    }
+    for (auto person: people) {
+        person->markClean();
+    }
+    for (auto dealership: dealerships) {
+        dealership->markClean();
+    }
+
+    std::cout << "Saved all data! (" << savedCount << " changed, " << deletedUUIDs.size() << " deleted)\n";
+    deletedUUIDs.clear();
+
+    // Vehicles that were saved moved in the snapshot, so load them from their new spot if they're evicted
+    if (lazyLoading) {
+        vehicleCache.openSnapshot(snapshotPath, lazyVehicleCapacity);
+        std::cout << vehicleCache.getResidentCount() << " vehicles in memory (" << vehicleCache.getLoadCount()
+                  << " loaded on first use, " << vehicleCache.getEvictionCount() << " evicted)\n";
+    }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    // Save in another storage format if requested, anything already saved is loaded in whatever format it's in
+    auto formatArg = std::find(args.begin(), args.end(), "--format");
+    if (formatArg != args.end()) {
+        if (formatArg + 1 == args.end()) {
+            throw std::runtime_error("--format needs a storage format (json, cbor, msgpack or bson)");
+        }
+        storageFormat = parseStorageFormat(*(formatArg + 1));
+        args.erase(formatArg, formatArg + 2);
+    }
+
+    // Convert between layouts or storage formats instead of running the simulator if requested
+    if (!args.empty() && args[0] == "convert") {
+        if (args.size() < 2) {
+            throw std::runtime_error("convert needs a storage format (json, cbor, msgpack or bson)");
+        }
+        StorageFormat format = parseStorageFormat(args[1]);
+        createDataDirs();
+        if (fs::exists(snapshotPath)) {
+            size_t count = SnapshotStore::convert(snapshotPath, format);
+            std::cout << "Converted " << count << " entities in " << snapshotPath << " to " << args[1] << "\n";
+        }
+        size_t count = convertFolder(dataPath, format);
+        std::cout << "Converted " << count << " entity files in " << dataPath << " to " << args[1] << "\n";
+        return 0;
+    }
+    if (!args.empty() && args[0] == "import") {
+        createDataDirs();
+        size_t count = SnapshotStore::importFolder(dataPath, snapshotPath);
+        std::cout << "Imported " << count << " entities from " << dataPath << " into " << snapshotPath << "\n";
+        return 0;
+    }
+    if (!args.empty() && args[0] == "export") {
+        std::string exportPath = args.size() >= 2 ? args[1] : dataPath;
+        size_t count = SnapshotStore(snapshotPath).exportFolder(exportPath);
+        std::cout << "Exported " << count << " entities from " << snapshotPath << " into " << exportPath << "\n";
+        return 0;
+    }
+    lazyLoading = std::find(args.begin(), args.end(), "--lazy") != args.end();
+
     // Header to start the program off
     std::cout << color::rize(R"(
    _____           _____ _
@@ -300,45 +673,18 @@ int main() {
 
     std::cout << color::rize("Welcome to the Car Simulator!\n", "Red", "Default", "Bold");
 
-    // Load in all people
+    // Load in everything, preferring the snapshot
     createDataDirs();
-    // Load in all vehicles
-    std::string vehiclesDataPath = "data/vehicles";
-    for (const auto &entry: fs::directory_iterator(vehiclesDataPath)) {
-        std::cout << entry.path().string() << "\n";
-
-        std::ifstream file(entry.path().string());
-        json importedJSON;
-        file >> importedJSON;
-
-        Vehicle* tmp;
-        // Can't use a switch/case since its a string
-        if (!importedJSON.contains("type")) {
-            throw;
-        }
-
-        // Create the object based on what type of car it is
-        std::string vehicleType = importedJSON["type"];
-        if (vehicleType == "sedan") {
-            tmp = new Sedan(Sedan::deserializeFromJSON(importedJSON));
-        } else if (vehicleType == "pickup-truck") {
-            tmp = new PickupTruck(PickupTruck::deserializeFromJSON(importedJSON));
-        } else if (vehicleType == "motorcycle") {
-            tmp = new Motorcycle(Motorcycle::deserializeFromJSON(importedJSON));
-        } else {
-            throw;
+    uint64_t snapshotSequence = 0;
+    if (fs::exists(snapshotPath)) {
+        snapshotSequence = loadFromSnapshot();
+    } else {
+        if (lazyLoading) {
+            std::cout << "There's no snapshot to load vehicles lazily from yet, loading them all until the first save.\n";
         }
-
-        vehicleUUIDsToPointers[tmp->getUUID()] = tmp;
-    }
-    std::string peopleDataPath = "data/people";
-    for (const auto &entry: fs::directory_iterator(peopleDataPath)) {
-        people.push_back(new Person(Person::loadFromPath(entry.path().string(), vehicleUUIDsToPointers)));
+        loadFromFolders();
     }
-    // Load in all dealerships
-    std::string dealershipsDataPath = "data/vehicle-dealership";
-    for (const auto &entry: fs::directory_iterator(dealershipsDataPath))
-        dealerships.push_back(new VehicleDealership(VehicleDealership::loadFromPath(entry.path().string(), vehicleUUIDsToPointers)));
+    replayWriteAheadLog(snapshotSequence);
 
     // Have the player choose an account / person profile before doing anything
     switchCurrentPlayerAccount();
@@ -388,7 +734,7 @@ int main() {
             case 4: {
                 // Print out a list of the user's vehicles
                 std::cout << "Your vehicle list: \n";
-                printPointerValuesWithIdx<Vehicle>(playerData->vehicles);
+                printPointerValuesWithIdx(playerData->vehicles);
                 if (playerData->vehicles.empty()) {
                     std::cout << "  You have no vehicles :(\n";
                 }
@@ -432,7 +778,8 @@ int main() {
                         [](int i) { return i > 0 && i <= dealerships.size(); }) - 1;
 
                 // Attempt to sell the vehicle to the dealership, handle if impossible
-                int soldVehicleIdx = dealerships[dealershipIdx]->sellVehicleTo(playerData->vehicles[vehicleIdx],
+                PinnedVehicle soldVehicle = playerData->vehicles[vehicleIdx].pin();
+                int soldVehicleIdx = dealerships[dealershipIdx]->sellVehicleTo(soldVehicle.get(),
                                                                                playerData->bankAccount);
                 if (soldVehicleIdx == -1) {
                     std::cout
@@ -442,6 +789,10 @@ int main() {
 
                 // Sell was successful, remove the vehicle from the player's list since we don't own it anymore
                 playerData->vehicles.erase(playerData->vehicles.begin() + vehicleIdx);
+                playerData->markDirty();
+                writeAheadLog->write({LogRecordType::TransferVehicle, EntityKind::Vehicle, soldVehicle->getUUID(),
+                                      playerData->getUUID(), dealerships[dealershipIdx]->getUUID(),
+                                      soldVehicle->getPrice()});
                 std::cout << "The transaction was successful! " << dealerships[dealershipIdx]->getName()
                           << " now owns this vehicle:\n" << *dealerships[dealershipIdx]->vehicles[soldVehicleIdx]
                           << "\n";
@@ -520,15 +871,19 @@ int main() {
                                                                       x <= dealerships[dealershipIdx]->vehicles.size();
                                                            }) - 1;
 
-                Vehicle *boughtVehicle = dealerships[dealershipIdx]->buyVehicleFrom(vehicleIdx,
-                                                                                    playerData->bankAccount);
-                if (boughtVehicle == nullptr) {
+                PinnedVehicle boughtVehicle = dealerships[dealershipIdx]->buyVehicleFrom(vehicleIdx,
+                                                                                         playerData->bankAccount);
+                if (!boughtVehicle) {
                     std::cout
                             << "The transaction could not be completed, likely because you don't have enough money or deposit/withdraw limits on either accounts. Please check these.\n";
                     break;
                 }
 
-                playerData->vehicles.push_back(boughtVehicle);
+                playerData->vehicles.push_back(boughtVehicle.get());
+                playerData->markDirty();
+                writeAheadLog->write({LogRecordType::TransferVehicle, EntityKind::Vehicle, boughtVehicle->getUUID(),
+                                      dealerships[dealershipIdx]->getUUID(), playerData->getUUID(),
+                                      boughtVehicle->getPrice()});
                 std::cout << "The transaction was successful! You now own this vehicle:\n"
                           << *playerData->vehicles[playerData->vehicles.size() - 1] << "\n";
                 break;
@@ -556,14 +911,20 @@ int main() {
                     break;
                 }
 
-                people.erase(people.begin() + idx);
+                deletedUUIDs.push_back(people[idx]->getUUID());
+                writeAheadLog->write({LogRecordType::Delete, EntityKind::Person, people[idx]->getUUID()});
+                entityRegistry.remove(people[idx]);
 
                 std::cout << "Successfully deleted account data.\n";
                 break;
             }
             case -5: {
                 // Generate a new dealership
-                dealerships.push_back(generateDealershipFromInput());
+                entityRegistry.add(generateDealershipFromInput());
+                std::string payload;
+                encodeEntity(*dealerships.back(), StorageFormat::JSON, payload);
+                writeAheadLog->write({LogRecordType::Create, EntityKind::Dealership, dealerships.back()->getUUID(), {},
+                                      {}, 0, payload});
                 std::cout << "Successfully created a dealership!\n";
                 break;
             }
@@ -576,7 +937,9 @@ int main() {
 
                 int idx = promptWithValidation<int>("Enter the index of the dealership to delete: ",
                                                     [](int x) { return x > 0 && x <= dealerships.size(); }) - 1;
-                dealerships.erase(dealerships.begin() + idx);
+                deletedUUIDs.push_back(dealerships[idx]->getUUID());
+                writeAheadLog->write({LogRecordType::Delete, EntityKind::Dealership, dealerships[idx]->getUUID()});
+                entityRegistry.remove(dealerships[idx]);
 
                 std::cout << "Successfully deleted dealership data.\n";
                 break;
@@ -589,6 +952,7 @@ int main() {
             case -100: {
                 // Exit from the program
                 std::cout << "Thank you for using the program!\n";
+                delete writeAheadLog;
                 return 0;
             }
             default: {
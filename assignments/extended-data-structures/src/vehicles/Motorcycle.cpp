@@ -1,5 +1,7 @@
 #include "vehicles/Vehicle.hpp"
 #include "vehicles/Motorcycle.hpp"
+#include "StorageFormat.hpp"
+#include "util.hpp"
 #include <fstream>
 #include <filesystem>
 
@@ -25,7 +27,9 @@ std::string convertMotorcycleTypeEnumToStr(MOTORCYCLE_TYPE type) {
     }
 }
 
-Motorcycle::Motorcycle(std::string name, double price, std::string manufacturer, double mileage, double horsepower, double maxSpeed, std::string color, double engineSize, double maxAcceleration, MOTORCYCLE_TYPE motorcycleType) : Vehicle(std::move(name), price, 2, 0, 1, 1, std::move(manufacturer), mileage, horsepower, maxSpeed, std::move(color), "motorcycle") {
+Motorcycle::Motorcycle(std::string name, double price, std::string manufacturer, double mileage, double horsepower, double maxSpeed, std::string color, double engineSize, double maxAcceleration, MOTORCYCLE_TYPE motorcycleType) : Motorcycle(std::move(name), price, std::move(manufacturer), mileage, horsepower, maxSpeed, std::move(color), engineSize, maxAcceleration, motorcycleType, Uuid::generate()) {}
+
+Motorcycle::Motorcycle(std::string name, double price, std::string manufacturer, double mileage, double horsepower, double maxSpeed, std::string color, double engineSize, double maxAcceleration, MOTORCYCLE_TYPE motorcycleType, Uuid uuid) : Vehicle(std::move(name), price, 2, 0, 1, 1, std::move(manufacturer), mileage, horsepower, maxSpeed, std::move(color), "motorcycle", uuid) {
     this->engineSize = engineSize;
     this->maxAcceleration = maxAcceleration;
     this->motorcycleType = motorcycleType;
@@ -69,6 +73,14 @@ json Motorcycle::serializeToJSON() {
     return baseData;
 }
 
+void Motorcycle::writeFields(JsonWriter &writer) const {
+    Vehicle::writeFields(writer);
+
+    writer.field("engineSize", engineSize);
+    writer.field("maxAcceleration", maxAcceleration);
+    writer.field("motorcycleType", convertMotorcycleTypeEnumToStr(motorcycleType));
+}
+
 Motorcycle Motorcycle::deserializeFromJSON(const json &data) {
     json sanitizedData = Vehicle::getSanitizedJSON(data);
 
@@ -84,15 +96,14 @@ Motorcycle Motorcycle::deserializeFromJSON(const json &data) {
 
     Motorcycle tmp{
             data["name"], data["price"], data["manufacturer"], data["mileage"], data["horsepower"], data["maxSpeed"],
-            data["color"], data["engineSize"], data["maxAcceleration"], convertMotorcycleTypeStrToEnum(data["motorcycleType"])
+            data["color"], data["engineSize"], data["maxAcceleration"], convertMotorcycleTypeStrToEnum(data["motorcycleType"]), Uuid::parse(data["uuid"].get<std::string>())
     };
 
-    tmp.uuid = data["uuid"];
     return tmp;
 }
 
-Motorcycle Motorcycle::loadFromUUID(const std::string& uuid) {
-    std::string fname = "data/vehicles/" + uuid + ".json";
+Motorcycle Motorcycle::loadFromUUID(const Uuid &uuid) {
+    std::string fname = findEntityFile("data/vehicles", uuid);
     return Motorcycle::loadFromPath(fname);
 }
 
@@ -102,9 +113,7 @@ Motorcycle Motorcycle::loadFromPath(const std::string& path) {
         throw;
     }
 
-    std::ifstream file(path);
-    json importedJSON;
-    file >> importedJSON;
+    json importedJSON = readEntityFile(path);
 
     return Motorcycle::deserializeFromJSON(importedJSON);
 }
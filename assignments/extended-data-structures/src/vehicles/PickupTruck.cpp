@@ -1,5 +1,7 @@
 #include "vehicles/Vehicle.hpp"
 #include "vehicles/PickupTruck.hpp"
+#include "StorageFormat.hpp"
+#include "util.hpp"
 #include <fstream>
 #include <filesystem>
 #include <utility>
@@ -8,7 +10,11 @@ namespace fs = std::filesystem;
 
 PickupTruck::PickupTruck(std::string name, double price, std::string manufacturer, double mileage, double horsepower,
                          double maxSpeed, double bedCapacity, double towingMaxLoad, int engineCylinderCount,
-                         std::string color) : Vehicle(std::move(name), price, 4, 2, 2, 1, std::move(manufacturer), mileage, horsepower, maxSpeed, std::move(color), "pickup-truck") {
+                         std::string color) : PickupTruck(std::move(name), price, std::move(manufacturer), mileage, horsepower, maxSpeed, bedCapacity, towingMaxLoad, engineCylinderCount, std::move(color), Uuid::generate()) {}
+
+PickupTruck::PickupTruck(std::string name, double price, std::string manufacturer, double mileage, double horsepower,
+                         double maxSpeed, double bedCapacity, double towingMaxLoad, int engineCylinderCount,
+                         std::string color, Uuid uuid) : Vehicle(std::move(name), price, 4, 2, 2, 1, std::move(manufacturer), mileage, horsepower, maxSpeed, std::move(color), "pickup-truck", uuid) {
     this->bedCapacity = bedCapacity;
     this->towingMaxLoad = towingMaxLoad;
     this->engineCylinderCount = engineCylinderCount;
@@ -50,6 +56,14 @@ json PickupTruck::serializeToJSON() {
     return baseData;
 }
 
+void PickupTruck::writeFields(JsonWriter &writer) const {
+    Vehicle::writeFields(writer);
+
+    writer.field("bedCapacity", bedCapacity);
+    writer.field("towingMaxLoad", towingMaxLoad);
+    writer.field("engineCylinderCount", engineCylinderCount);
+}
+
 PickupTruck PickupTruck::deserializeFromJSON(const json &data) {
     json sanitizedData = Vehicle::getSanitizedJSON(data);
 
@@ -64,16 +78,14 @@ PickupTruck PickupTruck::deserializeFromJSON(const json &data) {
     }
 
     PickupTruck tmp{
-            data["name"], data["price"], data["manufacturer"], data["mileage"], data["horsepower"], data["maxSpeed"], data["bedCapacity"], data["towingMaxLoad"], data["engineCylinderCount"], data["color"]
+            data["name"], data["price"], data["manufacturer"], data["mileage"], data["horsepower"], data["maxSpeed"], data["bedCapacity"], data["towingMaxLoad"], data["engineCylinderCount"], data["color"], Uuid::parse(data["uuid"].get<std::string>())
     };
 
-    tmp.uuid = data["uuid"];
-
     return tmp;
 }
 
-PickupTruck PickupTruck::loadFromUUID(const std::string& uuid) {
-    std::string fname = "data/vehicles/" + uuid + ".json";
+PickupTruck PickupTruck::loadFromUUID(const Uuid &uuid) {
+    std::string fname = findEntityFile("data/vehicles", uuid);
     return PickupTruck::loadFromPath(fname);
 }
 
@@ -83,9 +95,7 @@ PickupTruck PickupTruck::loadFromPath(const std::string& path) {
         throw;
     }
 
-    std::ifstream file(path);
-    json importedJSON;
-    file >> importedJSON;
+    json importedJSON = readEntityFile(path);
 
     return PickupTruck::deserializeFromJSON(importedJSON);
 }
@@ -1,5 +1,7 @@
 #include "vehicles/Vehicle.hpp"
 #include "vehicles/Sedan.hpp"
+#include "StorageFormat.hpp"
+#include "util.hpp"
 #include <fstream>
 #include <filesystem>
 #include <utility>
@@ -8,8 +10,13 @@ namespace fs = std::filesystem;
 
 Sedan::Sedan(std::string name, double price, std::string manufacturer, double mileage, double horsepower,
              double maxSpeed, double trunkCapacity, int engineCylinderCount,
-             std::string color) : Vehicle(std::move(name), price, 4, 4, 5, 4, std::move(manufacturer), mileage, horsepower,
-                                          maxSpeed, std::move(color), "sedan") {
+             std::string color) : Sedan(std::move(name), price, std::move(manufacturer), mileage, horsepower, maxSpeed,
+                                        trunkCapacity, engineCylinderCount, std::move(color), Uuid::generate()) {}
+
+Sedan::Sedan(std::string name, double price, std::string manufacturer, double mileage, double horsepower,
+             double maxSpeed, double trunkCapacity, int engineCylinderCount, std::string color,
+             Uuid uuid) : Vehicle(std::move(name), price, 4, 4, 5, 4, std::move(manufacturer), mileage, horsepower,
+                                         maxSpeed, std::move(color), "sedan", uuid) {
     this->trunkCapacity = trunkCapacity;
     this->engineCylinderCount = engineCylinderCount;
 }
@@ -44,6 +51,13 @@ json Sedan::serializeToJSON() {
     return baseData;
 }
 
+void Sedan::writeFields(JsonWriter &writer) const {
+    Vehicle::writeFields(writer);
+
+    writer.field("trunkCapacity", trunkCapacity);
+    writer.field("engineCylinderCount", engineCylinderCount);
+}
+
 Sedan Sedan::deserializeFromJSON(const json &data) {
     json sanitizedData = Vehicle::getSanitizedJSON(data);
 
@@ -59,15 +73,14 @@ Sedan Sedan::deserializeFromJSON(const json &data) {
 
     Sedan tmp{
             data["name"], data["price"], data["manufacturer"], data["mileage"], data["horsepower"], data["maxSpeed"],
-            data["trunkCapacity"], data["engineCylinderCount"], data["color"]
+            data["trunkCapacity"], data["engineCylinderCount"], data["color"], Uuid::parse(data["uuid"].get<std::string>())
     };
 
-    tmp.uuid = data["uuid"];
     return tmp;
 }
 
-Sedan Sedan::loadFromUUID(const std::string& uuid) {
-    std::string fname = "data/vehicles/" + uuid + ".json";
+Sedan Sedan::loadFromUUID(const Uuid &uuid) {
+    std::string fname = findEntityFile("data/vehicles", uuid);
     return Sedan::loadFromPath(fname);
 }
 
@@ -77,9 +90,7 @@ Sedan Sedan::loadFromPath(const std::string& path) {
         throw;
     }
 
-    std::ifstream file(path);
-    json importedJSON;
-    file >> importedJSON;
+    json importedJSON = readEntityFile(path);
 
     return Sedan::deserializeFromJSON(importedJSON);
 }
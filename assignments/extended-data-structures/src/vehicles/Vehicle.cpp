@@ -1,29 +1,39 @@
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <utility>
 #include "vehicles/Vehicle.hpp"
 #include "util.hpp"
+#include "StorageFormat.hpp"
 
 namespace fs = std::filesystem;
 
 Vehicle::Vehicle(std::string name, double price, int wheels, int doors, int seats, int maxPassengers,
-                 std::string manufacturer, double mileage, double horsepower, double maxSpeed, std::string color, std::string type) {
-    this->name = name;
+                 std::string manufacturer, double mileage, double horsepower, double maxSpeed, std::string color,
+                 std::string type) : Vehicle(std::move(name), price, wheels, doors, seats, maxPassengers,
+                                             std::move(manufacturer), mileage, horsepower, maxSpeed, std::move(color),
+                                             std::move(type), Uuid::generate()) {}
+
+Vehicle::Vehicle(std::string name, double price, int wheels, int doors, int seats, int maxPassengers,
+                 std::string manufacturer, double mileage, double horsepower, double maxSpeed, std::string color,
+                 std::string type, Uuid uuid) {
+    this->name = std::move(name);
     this->price = price;
     this->wheels = wheels;
     this->doors = doors;
     this->seats = seats;
     this->maxPassengers = maxPassengers;
-    this->manufacturer = manufacturer;
+    this->manufacturer = std::move(manufacturer);
     this->mileage = mileage;
     this->horsepower = horsepower;
     this->maxSpeed = maxSpeed;
-    this->color = color;
+    this->color = std::move(color);
     this->driver = nullptr;
     this->started = false;
-    this->type = type;
+    this->type = std::move(type);
+    this->dirty = true;
 
-    this->uuid = generate_uuid_v4();
+    this->uuid = uuid;
 }
 
 bool Vehicle::start() {
@@ -53,6 +63,7 @@ bool Vehicle::drive(double distance) {
     }
 
     mileage += distance;
+    dirty = true;
     return true;
 }
 
@@ -83,6 +94,7 @@ bool Vehicle::changeColor(const std::string &newColor) {
     }
 
     color = newColor;
+    dirty = true;
     return true;
 }
 
@@ -93,6 +105,7 @@ bool Vehicle::changePrice(double newPrice) {
     }
 
     price = newPrice;
+    dirty = true;
     return true;
 }
 
@@ -124,16 +137,24 @@ std::string Vehicle::getName() const {
     return name;
 }
 
-std::string Vehicle::getUUID() const {
+Uuid Vehicle::getUUID() const {
     return uuid;
 }
 
+bool Vehicle::isDirty() const {
+    return dirty;
+}
+
+void Vehicle::markClean() {
+    dirty = false;
+}
+
 json Vehicle::serializeToJSON() {
     json serialized = {};
 
     // Store all important info into JSON object
     // We don't include the driver pointer since it should never be saved while a person is driving
-    serialized["uuid"] = uuid;
+    serialized["uuid"] = uuid.toString();
     serialized["name"] = name;
     serialized["price"] = price;
     serialized["wheels"] = wheels;
@@ -147,7 +168,7 @@ json Vehicle::serializeToJSON() {
     serialized["started"] = false; // Make sure the car can be started in the future in case if it somehow saves during driving
     serialized["color"] = color;
     serialized["type"] = type;
-    serialized["uuid"] = uuid;
+    serialized["uuid"] = uuid.toString();
 
     return serialized;
 }
@@ -171,8 +192,34 @@ json Vehicle::getSanitizedJSON(const json &data) {
     return sanitizedData;
 }
 
+void Vehicle::writeJSON(JsonWriter &writer) const {
+    writer.beginObject();
+    writeFields(writer);
+    writer.endObject();
+}
+
+void Vehicle::writeFields(JsonWriter &writer) const {
+    // Same fields as serializeToJSON(), still without the driver pointer
+    writer.field("uuid", uuid);
+    writer.field("name", name);
+    writer.field("price", price);
+    writer.field("wheels", wheels);
+    writer.field("doors", doors);
+    writer.field("seats", seats);
+    writer.field("maxPassengers", maxPassengers);
+    writer.field("maxSpeed", maxSpeed);
+    writer.field("manufacturer", manufacturer);
+    writer.field("mileage", mileage);
+    writer.field("horsepower", horsepower);
+    writer.field("started", false);
+    writer.field("color", color);
+    writer.field("type", type);
+}
+
 void Vehicle::saveAsFile() {
-    json serializedJSON = serializeToJSON();
+    // JSON files are indented so they can still be read by people
+    std::string encoded;
+    encodeEntity(*this, storageFormat, encoded, true);
 
     // Make data directory if needed
     if (!fs::is_directory("data") || !fs::exists("data")) { // Check if folder exists
@@ -184,10 +231,8 @@ void Vehicle::saveAsFile() {
         fs::create_directory("data/vehicles");
     }
 
-    // Write data to file
-    std::ofstream file("data/vehicles/" + uuid + ".json");
-    file << std::setw(4) << serializedJSON << std::endl;
-    file.close();
+    // Write data to file in the storage format
+    writeEntityBytes("data/vehicles", uuid, encoded);
 }
 
 std::string Vehicle::toFormattedString() {